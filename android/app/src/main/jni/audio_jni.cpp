@@ -123,7 +123,11 @@ JNIEXPORT void JNICALL Java_com_example_lsound_sound_Audio_createUserPlayer(JNIE
     if(!lsound::Context::exists()){
         return;
     }
-    lsound::UserPlayer* player = lsound::Context::getInstance().createUserPlayer(packId, id);
+    lsound::Context& context = lsound::Context::getInstance();
+    lsound::UserPlayer* player = context.findUserPlayer(context.createUserPlayer(packId, id));
+    if(NULL == player){
+        return;
+    }
     player->setFlag(lsound::PlayerFlag_Loop);
     player->play();
 }
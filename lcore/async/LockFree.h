@@ -0,0 +1,228 @@
+﻿#ifndef INC_LCORE_LOCKFREE_H__
+#define INC_LCORE_LOCKFREE_H__
+/**
+@file LockFree.h
+@author t-sakai
+@date 2015/08/10 create
+*/
+#include "../lcore.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+namespace lcore
+{
+    //-------------------------------------------------------
+    //---
+    //--- Atomic
+    //---
+    //-------------------------------------------------------
+    /// 加算後の値を返す
+    inline s32 atomicIncrement(volatile s32* value)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        return InterlockedIncrement(reinterpret_cast<volatile LONG*>(value));
+#else
+        return __sync_add_and_fetch(value, 1);
+#endif
+    }
+
+    /// 減算後の値を返す
+    inline s32 atomicDecrement(volatile s32* value)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        return InterlockedDecrement(reinterpret_cast<volatile LONG*>(value));
+#else
+        return __sync_sub_and_fetch(value, 1);
+#endif
+    }
+
+    /// 交換前の値を返す
+    inline s32 atomicExchange(volatile s32* value, s32 exchange)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        return InterlockedExchange(reinterpret_cast<volatile LONG*>(value), exchange);
+#else
+        __sync_synchronize();
+        return __sync_lock_test_and_set(value, exchange);
+#endif
+    }
+
+    /// 論理和の前の値を返す
+    inline s32 atomicOr(volatile s32* value, s32 mask)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        return InterlockedOr(reinterpret_cast<volatile LONG*>(value), mask);
+#else
+        return __sync_fetch_and_or(value, mask);
+#endif
+    }
+
+    /// 論理積の前の値を返す
+    inline s32 atomicAnd(volatile s32* value, s32 mask)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        return InterlockedAnd(reinterpret_cast<volatile LONG*>(value), mask);
+#else
+        return __sync_fetch_and_and(value, mask);
+#endif
+    }
+
+    /// 前後の読み書きの順序を入れ替えさせない
+    inline void memoryBarrier()
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        MemoryBarrier();
+#else
+        __sync_synchronize();
+#endif
+    }
+
+    /// valueがcomparandと等しければexchangeに置き換える。交換前の値を返す
+    inline s32 atomicCompareExchange(volatile s32* value, s32 exchange, s32 comparand)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        return InterlockedCompareExchange(reinterpret_cast<volatile LONG*>(value), exchange, comparand);
+#else
+        return __sync_val_compare_and_swap(value, comparand, exchange);
+#endif
+    }
+
+    /// valueがcomparandと等しければexchangeに置き換える。交換前の値を返す
+    inline s64 atomicCompareExchange64(volatile s64* value, s64 exchange, s64 comparand)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        return InterlockedCompareExchange64(reinterpret_cast<volatile LONGLONG*>(value), exchange, comparand);
+#else
+        return __sync_val_compare_and_swap(value, comparand, exchange);
+#endif
+    }
+
+    /// 交換前の値を返す
+    inline void* atomicExchangePointer(void* volatile* value, void* exchange)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        return InterlockedExchangePointer(value, exchange);
+#else
+        __sync_synchronize();
+        return __sync_lock_test_and_set(value, exchange);
+#endif
+    }
+
+    /// valueがcomparandと等しければexchangeに置き換える。交換前の値を返す
+    inline void* atomicCompareExchangePointer(void* volatile* value, void* exchange, void* comparand)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        return InterlockedCompareExchangePointer(value, exchange, comparand);
+#else
+        return __sync_val_compare_and_swap(value, comparand, exchange);
+#endif
+    }
+
+    //-------------------------------------------------------
+    //---
+    //--- LockFreeIndexStack
+    //---
+    //-------------------------------------------------------
+    /**
+    @brief 固定長のインデックスのスタック。ロックなしで複数スレッドからpush, popできる
+    上位32bitのタグでABAを防ぐ
+    */
+    class LockFreeIndexStack
+    {
+    public:
+        LockFreeIndexStack()
+            :top_(0)
+            ,size_(0)
+            ,capacity_(0)
+            ,next_(NULL)
+        {}
+
+        ~LockFreeIndexStack()
+        {
+            LIME_DELETE_ARRAY(next_);
+        }
+
+        /**
+        @brief 0からcapacity-1まで全てのインデックスを積んだ状態にする
+        */
+        void initialize(s32 capacity)
+        {
+            LASSERT(0<capacity);
+            LIME_DELETE_ARRAY(next_);
+            capacity_ = capacity;
+            next_ = LIME_NEW s32[capacity];
+            for(s32 i=0; i<capacity; ++i){
+                next_[i] = i+1;
+            }
+            next_[capacity-1] = -1;
+            top_ = 1;
+            size_ = capacity;
+        }
+
+        /// 空なら-1
+        s32 pop()
+        {
+            for(;;){
+                s64 top = top_;
+                s32 index = static_cast<s32>(top & 0xFFFFFFFF) - 1;
+                if(index<0){
+                    return -1;
+                }
+                if(capacity_<=index){
+                    continue; //torn read
+                }
+                s64 next = nextTop(top, next_[index]);
+                if(top == atomicCompareExchange64(&top_, next, top)){
+                    atomicDecrement(&size_);
+                    return index;
+                }
+            }
+        }
+
+        void push(s32 index)
+        {
+            LASSERT(0<=index && index<capacity_);
+            for(;;){
+                s64 top = top_;
+                next_[index] = static_cast<s32>(top & 0xFFFFFFFF) - 1;
+                s64 next = nextTop(top, index);
+                if(top == atomicCompareExchange64(&top_, next, top)){
+                    atomicIncrement(&size_);
+                    return;
+                }
+            }
+        }
+
+        /// 他スレッドが操作中なら概算
+        inline s32 size() const
+        {
+            return size_;
+        }
+
+        inline s32 capacity() const
+        {
+            return capacity_;
+        }
+    private:
+        LockFreeIndexStack(const LockFreeIndexStack&);
+        LockFreeIndexStack& operator=(const LockFreeIndexStack&);
+
+        /// タグを進めて先頭をindexにする
+        static inline s64 nextTop(s64 top, s32 index)
+        {
+            u64 tag = (static_cast<u64>(top) + (0x01ULL<<32)) & ~0xFFFFFFFFULL;
+            return static_cast<s64>(tag | static_cast<u32>(index+1));
+        }
+
+        volatile s64 top_; //上位32bitがタグ、下位32bitが先頭のインデックス+1
+        volatile s32 size_;
+        s32 capacity_;
+        s32* next_;
+    };
+}
+#endif //INC_LCORE_LOCKFREE_H__
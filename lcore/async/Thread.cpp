@@ -326,6 +326,10 @@ namespace lcore
             }
 #endif
         }
+        if(0 == ret){
+            //A joined thread must not be canceled nor joined again in release
+            handle_ = 0;
+        }
 
         switch(ret)
         {
@@ -483,6 +487,10 @@ namespace lcore
             }
 #endif
         }
+        if(0 == ret){
+            //A joined thread must not be canceled nor joined again in release
+            handle_ = 0;
+        }
 
         switch(ret)
         {
@@ -37,7 +37,7 @@
 #include "async/SyncObject.h"
 #endif
 
-#include "clibrary.h"
+#include "CLibrary.h"
 
 namespace
 {
@@ -901,6 +901,22 @@ namespace
 #endif
     }
 
+    // マイクロ秒単位の単調増加する時間を取得
+    u64 getTimeMicroSeconds()
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        LARGE_INTEGER count;
+        LARGE_INTEGER freq;
+        QueryPerformanceCounter(&count);
+        QueryPerformanceFrequency(&freq);
+        return static_cast<u64>(count.QuadPart/freq.QuadPart)*1000000 + static_cast<u64>((count.QuadPart%freq.QuadPart)*1000000/freq.QuadPart);
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<u64>(ts.tv_sec)*1000000 + static_cast<u64>(ts.tv_nsec/1000);
+#endif
+    }
+
     namespace
     {
         inline u32 getUsageMSec()
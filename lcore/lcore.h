@@ -84,6 +84,18 @@ inline void operator delete[](void* ptr)
     lcore_free(ptr);
 }
 
+#if defined(__cpp_sized_deallocation)
+inline void operator delete(void* ptr, std::size_t /*size*/)
+{
+    lcore_free(ptr);
+}
+
+inline void operator delete[](void* ptr, std::size_t /*size*/)
+{
+    lcore_free(ptr);
+}
+#endif
+
 //-------------------
 inline void* operator new(std::size_t size, const char* file, int line)
 {
@@ -111,8 +123,8 @@ inline void operator delete[](void* ptr, const char* /*file*/, int /*line*/)
 #define LIME_ALIGN16 __declspec(align(16))
 #define LIME_ALIGN(x) __declspec(align(x))
 #else
-#define LIME_ALIGN16 __attribute__((align(16)))
-#define LIME_ALIGN(x) __attribute__((align(x)))
+#define LIME_ALIGN16 __attribute__((aligned(16)))
+#define LIME_ALIGN(x) __attribute__((aligned(x)))
 #endif
 
 static const uintptr_t LIME_ALIGN16_MASK = (0xFU);
@@ -900,6 +912,9 @@ namespace lcore
     /// ミリ秒単位の時間を取得
     u32 getTime();
 
+    /// マイクロ秒単位の単調増加する時間を取得
+    u64 getTimeMicroSeconds();
+
 
     template<bool enable>
     struct Timer
@@ -0,0 +1,74 @@
+/**
+@file BufferPool.cpp
+@author t-sakai
+@date 2015/08/13 create
+*/
+#include "BufferPool.h"
+
+namespace lsound
+{
+    BufferPool::BufferPool()
+        :blockSize_(0)
+        ,memory_(NULL)
+        ,numUsed_(0)
+        ,highWatermark_(0)
+    {
+    }
+
+    BufferPool::~BufferPool()
+    {
+        destroy();
+    }
+
+    void BufferPool::create(u32 blockSize, s32 numBlocks)
+    {
+        LASSERT(0<blockSize);
+        LASSERT(0<numBlocks);
+        destroy();
+
+        //Blocks start at cache lines
+        blockSize_ = (blockSize + 63) & ~63U;
+        memory_ = reinterpret_cast<u8*>(LIME_ALIGNED_MALLOC(blockSize_*numBlocks, 64));
+        free_.initialize(numBlocks);
+        numUsed_ = 0;
+        highWatermark_ = 0;
+    }
+
+    void BufferPool::destroy()
+    {
+        LASSERT(0 == numUsed_);
+        LIME_ALIGNED_FREE(memory_, 64);
+        blockSize_ = 0;
+    }
+
+    s32 BufferPool::pop()
+    {
+        s32 index = free_.pop();
+        if(index<0){
+            return -1;
+        }
+
+        s32 numUsed = lcore::atomicIncrement(&numUsed_);
+        for(;;){
+            s32 highWatermark = highWatermark_;
+            if(numUsed<=highWatermark){
+                break;
+            }
+            if(highWatermark == lcore::atomicCompareExchange(&highWatermark_, numUsed, highWatermark)){
+                break;
+            }
+        }
+        return index;
+    }
+
+    void BufferPool::push(s32 index)
+    {
+        lcore::atomicDecrement(&numUsed_);
+        free_.push(index);
+    }
+
+    void BufferPool::resetHighWatermark()
+    {
+        lcore::atomicExchange(&highWatermark_, numUsed_);
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef INC_LSOUND_BUFFERPOOL_H__
+#define INC_LSOUND_BUFFERPOOL_H__
+/**
+@file BufferPool.h
+@author t-sakai
+@date 2015/08/13 create
+*/
+#include "lsound.h"
+#include <lcore/async/LockFree.h>
+
+namespace lsound
+{
+    /**
+    @brief Fixed size blocks of device buffers, a voice holds a block only while it plays.
+    Sized for voices playing at once instead of every voice. Any thread can pop and push.
+    */
+    class BufferPool
+    {
+    public:
+        BufferPool();
+        ~BufferPool();
+
+        void create(u32 blockSize, s32 numBlocks);
+        void destroy();
+
+        /// @return index of a block, -1 if all are used
+        s32 pop();
+        void push(s32 index);
+
+        inline void* getBlock(s32 index);
+        inline u32 getBlockSize() const;
+        inline s32 getCapacity() const;
+        inline s32 getNumUsed() const;
+
+        /// Most blocks used at once since created or reset
+        inline s32 getHighWatermark() const;
+        void resetHighWatermark();
+
+    private:
+        BufferPool(const BufferPool&);
+        BufferPool& operator=(const BufferPool&);
+
+        u32 blockSize_;
+        u8* memory_;
+        lcore::LockFreeIndexStack free_;
+        volatile s32 numUsed_;
+        volatile s32 highWatermark_;
+    };
+
+    inline void* BufferPool::getBlock(s32 index)
+    {
+        LASSERT(0<=index && index<free_.capacity());
+        return memory_ + index*blockSize_;
+    }
+
+    inline u32 BufferPool::getBlockSize() const
+    {
+        return blockSize_;
+    }
+
+    inline s32 BufferPool::getCapacity() const
+    {
+        return free_.capacity();
+    }
+
+    inline s32 BufferPool::getNumUsed() const
+    {
+        return numUsed_;
+    }
+
+    inline s32 BufferPool::getHighWatermark() const
+    {
+        return highWatermark_;
+    }
+}
+#endif //INC_LSOUND_BUFFERPOOL_H__
@@ -15,6 +15,9 @@
 
 #elif defined(LSOUND_API_OPENSL)
 #include "OpenSL/Context.h"
+
+#elif defined(LSOUND_API_OFFLINE)
+#include "Offline/Context.h"
 #endif
 
 #endif //INC_LSOUND_CONTEXT_H__
@@ -0,0 +1,143 @@
+/**
+@file Context.cpp
+@author t-sakai
+@date 2015/08/03 create
+*/
+#include "Context.h"
+#include <lcore/CLibrary.h>
+
+namespace lsound
+{
+    Context* Context::instance_ = NULL;
+
+    bool Context::initialize(const InitParam& initParam)
+    {
+        LASSERT(0<initParam.maxPlayers_ && initParam.maxPlayers_<=MaxHandleIndex);
+        LASSERT(0<initParam.maxUserPlayers_ && initParam.maxUserPlayers_<=MaxHandleIndex);
+        LASSERT(Channels_Mono == initParam.numChannels_ || Channels_Stereo == initParam.numChannels_);
+
+        if(NULL != instance_){
+            return true;
+        }
+        instance_ = LIME_NEW Context(initParam);
+        if(!instance_->createDevice()){
+            LIME_DELETE(instance_);
+            return false;
+        }
+        return true;
+    }
+
+    void Context::terminate()
+    {
+        LIME_DELETE(instance_);
+    }
+
+    Context::Context(const InitParam& initParam)
+        :MixerContext(initParam)
+        //Do not resample upward
+        ,samplesPerSec_(lcore::minimum(initParam.samplesPerSec_, static_cast<s32>(SampleRate_48000)))
+        ,numChannels_(initParam.numChannels_)
+        ,pause_(false)
+        ,gain_(1.0f)
+    {
+    }
+
+    Context::~Context()
+    {
+        clear();
+        destroyDevice();
+    }
+
+    bool Context::createDevice()
+    {
+        if(!device_.create(
+            static_cast<u16>(numChannels_),
+            BitsPerSample,
+            samplesPerSec_))
+        {
+            return false;
+        }
+        if(!createVoices(device_.getNumChannels(), device_.getBitsPerSample()/8, device_.getSamplesPerSec())){
+            device_.destroy();
+            return false;
+        }
+        return true;
+    }
+
+    void Context::destroyDevice()
+    {
+        destroyVoices();
+        device_.destroy();
+    }
+
+    void Context::setGain(f32 gain)
+    {
+        lcore::CSLock lock(contextLock_);
+        gain_ = lcore::clamp01(gain);
+    }
+
+    void Context::setPause(bool pause)
+    {
+        lcore::CSLock lock(contextLock_);
+        pause_ = pause;
+    }
+
+    void Context::updateRequests()
+    {
+        //Requests are picked up by the next render
+        takeNumRequests();
+    }
+
+    s32 Context::render(LSshort* pcm, s32 numFrames)
+    {
+        LASSERT(0<=numFrames);
+        LASSERT(device_.valid());
+
+        //Handle new requests
+        startRequests();
+        bool pause;
+        f32 gain;
+        {
+            lcore::CSLock lock(contextLock_);
+            pause = pause_;
+            gain = gain_;
+        }
+
+        const s32 numChannels = device_.getNumChannels();
+        const s32 maxFrames = SharedBufferLength/Channels_Stereo;
+        s32 rendered = 0;
+        while(rendered<numFrames){
+            s32 frames = lcore::minimum(numFrames-rendered, maxFrames);
+            LSshort* out = (NULL == pcm)? out_ : pcm + rendered*numChannels;
+
+            if(pause){
+                lcore::memset(out, 0, sizeof(LSshort)*frames*numChannels);
+
+            }else{
+                LSshort* dst = out;
+                s32 remain = frames;
+                while(0<remain){
+                    if(mixer_.getNumAvailableFrames()<=0){
+                        mixBlock();
+                    }
+                    u32 n = mixer_.read(dst, remain, gain);
+                    dst += n*numChannels;
+                    remain -= n;
+                }
+            }
+            device_.write(out, frames);
+            rendered += frames;
+        }
+        return rendered;
+    }
+
+    bool Context::openWaveFile(const Char* path)
+    {
+        return device_.openWaveFile(path);
+    }
+
+    void Context::closeWaveFile()
+    {
+        device_.closeWaveFile();
+    }
+}
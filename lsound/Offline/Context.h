@@ -0,0 +1,82 @@
+#ifndef INC_LSOUND_OFFLINE_CONTEXT_H__
+#define INC_LSOUND_OFFLINE_CONTEXT_H__
+/**
+@file Context.h
+@author t-sakai
+@date 2015/08/03 create
+*/
+#include "../dsp/MixerContext.h"
+#include "Device.h"
+
+namespace lsound
+{
+    /**
+    @brief Headless context. Nothing runs in background, the caller pulls frames with render.
+    All players are summed by a software mixer into one stream.
+    */
+    class Context : public MixerContext
+    {
+    public:
+        struct InitParam : public MixerContext::InitParam
+        {
+            InitParam()
+                :samplesPerSec_(SampleRate_48000)
+                ,numChannels_(Channels_Stereo)
+            {}
+
+            s32 samplesPerSec_;
+            s32 numChannels_;
+        };
+
+        static bool initialize(const InitParam& initParam);
+        static void terminate();
+
+        static Context& getInstance(){ return *instance_;}
+
+        void setGain(f32 gain);
+        void setPause(bool pause);
+        void updateRequests();
+
+        /**
+        @brief Mix numFrames frames of all playing players
+        @return number of rendered frames
+        @param pcm ... interleaved output, numFrames*channels samples. can be NULL when only writing a wave file
+        */
+        s32 render(LSshort* pcm, s32 numFrames);
+
+        bool openWaveFile(const Char* path);
+        void closeWaveFile();
+
+        inline u64 getRenderedFrames() const;
+        inline const Device& getDevice() const;
+    private:
+        Context(const Context&);
+        Context& operator=(const Context&);
+
+        bool createDevice();
+        void destroyDevice();
+
+        Context(const InitParam& initParam);
+        ~Context();
+
+        static Context* instance_;
+
+        Device device_;
+        s32 samplesPerSec_;
+        s32 numChannels_;
+        bool pause_;
+        f32 gain_;
+        LIME_ALIGN16 LSshort out_[SharedBufferLength];
+    };
+
+    inline u64 Context::getRenderedFrames() const
+    {
+        return device_.getNumFrames();
+    }
+
+    inline const Device& Context::getDevice() const
+    {
+        return device_;
+    }
+}
+#endif //INC_LSOUND_OFFLINE_CONTEXT_H__
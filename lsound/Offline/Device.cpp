@@ -0,0 +1,127 @@
+/**
+@file Device.cpp
+@author t-sakai
+@date 2015/08/03 create
+*/
+#include "Device.h"
+
+namespace lsound
+{
+namespace
+{
+    struct WaveFileHeader
+    {
+        u32 riff_;
+        u32 riffSize_;
+        u32 wave_;
+        u32 fmt_;
+        u32 fmtSize_;
+        u16 format_;
+        u16 channels_;
+        u32 samplesPerSec_;
+        u32 bytesPerSec_;
+        u16 blockSize_;
+        u16 bitsPerSample_;
+        u32 data_;
+        u32 dataSize_;
+    };
+
+    static const u16 WaveFormat_PCM = 1;
+}
+
+    Device::Device()
+        :numChannels_(0)
+        ,bitsPerSample_(0)
+        ,samplesPerSec_(0)
+        ,numFrames_(0)
+        ,waveFile_(NULL)
+        ,waveDataSize_(0)
+    {
+    }
+
+    Device::~Device()
+    {
+        destroy();
+    }
+
+    bool Device::create(u16 numChannels, u16 bitsPerSample, u32 samplesPerSec)
+    {
+        LASSERT(Channels_Mono == numChannels || Channels_Stereo == numChannels);
+        LASSERT(16 == bitsPerSample);
+
+        destroy();
+        numChannels_ = numChannels;
+        bitsPerSample_ = bitsPerSample;
+        samplesPerSec_ = samplesPerSec;
+        numFrames_ = 0;
+        return true;
+    }
+
+    void Device::destroy()
+    {
+        closeWaveFile();
+        numChannels_ = 0;
+        bitsPerSample_ = 0;
+        samplesPerSec_ = 0;
+    }
+
+    bool Device::openWaveFile(const Char* path)
+    {
+        LASSERT(NULL != path);
+        closeWaveFile();
+
+#if defined(_WIN32) || defined(_WIN64)
+        fopen_s(&waveFile_, path, "wb");
+#else
+        waveFile_ = fopen(path, "wb");
+#endif
+        if(NULL == waveFile_){
+            return false;
+        }
+        //sizes are patched on close
+        waveDataSize_ = 0;
+        writeWaveHeader(0);
+        return true;
+    }
+
+    void Device::closeWaveFile()
+    {
+        if(NULL == waveFile_){
+            return;
+        }
+        fseek(waveFile_, 0, SEEK_SET);
+        writeWaveHeader(waveDataSize_);
+        fclose(waveFile_);
+        waveFile_ = NULL;
+        waveDataSize_ = 0;
+    }
+
+    void Device::write(const void* data, u32 numFrames)
+    {
+        numFrames_ += numFrames;
+        if(NULL == waveFile_ || NULL == data){
+            return;
+        }
+        u32 size = numFrames * getBytesPerFrame();
+        waveDataSize_ += static_cast<u32>(fwrite(data, 1, size, waveFile_));
+    }
+
+    void Device::writeWaveHeader(u32 dataSize)
+    {
+        WaveFileHeader header;
+        header.riff_ = LIME_MAKE_FOURCC('R', 'I', 'F', 'F');
+        header.riffSize_ = sizeof(WaveFileHeader) - 8 + dataSize;
+        header.wave_ = LIME_MAKE_FOURCC('W', 'A', 'V', 'E');
+        header.fmt_ = LIME_MAKE_FOURCC('f', 'm', 't', ' ');
+        header.fmtSize_ = 16;
+        header.format_ = WaveFormat_PCM;
+        header.channels_ = numChannels_;
+        header.samplesPerSec_ = samplesPerSec_;
+        header.bytesPerSec_ = samplesPerSec_ * getBytesPerFrame();
+        header.blockSize_ = static_cast<u16>(getBytesPerFrame());
+        header.bitsPerSample_ = bitsPerSample_;
+        header.data_ = LIME_MAKE_FOURCC('d', 'a', 't', 'a');
+        header.dataSize_ = dataSize;
+        fwrite(&header, sizeof(WaveFileHeader), 1, waveFile_);
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef INC_LSOUND_OFFLINE_DEVICE_H__
+#define INC_LSOUND_OFFLINE_DEVICE_H__
+/**
+@file Device.h
+@author t-sakai
+@date 2015/08/03 create
+*/
+#include "../lsound.h"
+#include <stdio.h>
+
+namespace lsound
+{
+    /**
+    @brief Output sink of the offline backend. Rendered frames go to the caller's memory and optionally to a wave file.
+    */
+    class Device
+    {
+    public:
+        Device();
+        ~Device();
+
+        inline bool valid() const;
+        bool create(u16 numChannels, u16 bitsPerSample, u32 samplesPerSec);
+        void destroy();
+
+        bool openWaveFile(const Char* path);
+        void closeWaveFile();
+
+        void write(const void* data, u32 numFrames);
+
+        inline u16 getNumChannels() const;
+        inline u16 getBitsPerSample() const;
+        inline u32 getSamplesPerSec() const;
+        inline u32 getBytesPerFrame() const;
+        inline u64 getNumFrames() const;
+    private:
+        friend class Context;
+
+        Device(const Device&);
+        Device& operator=(const Device&);
+
+        void writeWaveHeader(u32 dataSize);
+
+        u16 numChannels_;
+        u16 bitsPerSample_;
+        u32 samplesPerSec_;
+        u64 numFrames_;
+
+        FILE* waveFile_;
+        u32 waveDataSize_;
+    };
+
+    inline bool Device::valid() const
+    {
+        return (0 != numChannels_);
+    }
+
+    inline u16 Device::getNumChannels() const
+    {
+        return numChannels_;
+    }
+
+    inline u16 Device::getBitsPerSample() const
+    {
+        return bitsPerSample_;
+    }
+
+    inline u32 Device::getSamplesPerSec() const
+    {
+        return samplesPerSec_;
+    }
+
+    inline u32 Device::getBytesPerFrame() const
+    {
+        return numChannels_ * (bitsPerSample_>>3);
+    }
+
+    inline u64 Device::getNumFrames() const
+    {
+        return numFrames_;
+    }
+}
+#endif //INC_LSOUND_OFFLINE_DEVICE_H__
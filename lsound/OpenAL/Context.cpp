@@ -161,7 +161,8 @@ namespace
     bool Context::initialize(const InitParam& initParam)
     {
         LASSERT(0<initParam.numQueuedBuffers_ && initParam.numQueuedBuffers_<=lsound::NumMaxBuffers);
-        LASSERT(0<initParam.maxPlayers_);
+        LASSERT(0<initParam.maxPlayers_ && initParam.maxPlayers_<=MaxHandleIndex);
+        LASSERT(0<initParam.maxUserPlayers_ && initParam.maxUserPlayers_<=MaxHandleIndex);
 
         if(NULL != instance_){
             return true;
@@ -169,6 +170,9 @@ namespace
         instance_ = LIME_NEW Context();
         instance_->initParam_ = initParam;
         instance_->waitTime_ = initParam.waitTime_;
+        instance_->maxBufferFrames_ = lcore::maximum(static_cast<s32>((static_cast<u64>(initParam.maxBufferDuration_)*SampleRate_48000)/1000), 1);
+        instance_->bufferFrames_ = instance_->getBufferFrames(initParam.bufferDuration_);
+        instance_->pcm_ = LIME_NEW opus_int16[instance_->maxBufferFrames_*Channels_Stereo];
 
         ALCdevice* device = alcOpenDevice(NULL);
         if(NULL == device){
@@ -244,21 +248,22 @@ namespace
     Context::Context()
         :device_(NULL)
         ,context_(NULL)
-        ,numStreams_(0)
-        ,streamTop_(NULL)
+        ,streamSize_(0)
         ,streams_(NULL)
-        ,numPlayers_(0)
         ,players_(NULL)
-        ,numUserPlayers_(0)
-        ,userPlayerTop_(NULL)
         ,userPlayers_(NULL)
         ,numRequests_(0)
-        ,requestList_(NULL)
+        ,requestList_(-1)
+        ,numControls_(0)
+        ,playing_(NULL)
+        ,numPlaying_(0)
+        ,numScheduled_(0)
+        ,schedule_(NULL)
         ,waitEvent_(false, false)
+        ,bufferFrames_(0)
+        ,maxBufferFrames_(0)
+        ,pcm_(NULL)
     {
-        playerTop_.resetLink();
-        playList_.resetLink();
-
         for(s32 i=0; i<NumMaxPacks; ++i){
             packResources_[i] = NULL;
         }
@@ -284,10 +289,18 @@ namespace
         }
 
         LIME_DELETE_ARRAY(userPlayers_);
+        LIME_DELETE_ARRAY(schedule_);
+        LIME_DELETE_ARRAY(playing_);
+        playerPool_.destroy();
         LIME_DELETE_ARRAY(players_);
-        
-        u8* streams = reinterpret_cast<u8*>(streams_);
-        LIME_FREE(streams);
+        for(s32 i=0; i<bufferPool_.getCapacity(); ++i){
+            alDeleteBuffers(initParam_.numQueuedBuffers_, reinterpret_cast<LSuint*>(bufferPool_.getBlock(i)));
+        }
+        bufferPool_.destroy();
+
+        streamPool_.destroy();
+        LIME_DELETE_ARRAY(streams_);
+        LIME_DELETE_ARRAY(pcm_);
 
         destroy();
     }
@@ -299,7 +312,6 @@ namespace
 
     void Context::setPause(bool pause)
     {
-        lcore::CSLock lock(playerLock_);
         if(pause){
             waitTime_ = lcore::thread::Infinite;
         }else{
@@ -310,9 +322,9 @@ namespace
 
     void Context::updateRequests()
     {
-        if(numRequests_){
+        s32 numRequests = lcore::atomicExchange(&numRequests_, 0);
+        if(0<numRequests || 0<numControls_){
             waitEvent_.set();
-            numRequests_ = 0;
         }
     }
 
@@ -320,38 +332,70 @@ namespace
     {
         LSOUND_DECL_STOPWATCH
 
+        //Sleep until the nearest deadline, forever if nothing is playing
         u32 waitTime = getWaitTime();
+        if(lcore::thread::Infinite != waitTime){
+            if(numScheduled_<=0){
+                //Wake up while pools can be trimmed
+                if(!playerPool_.canTrim() && !streamPool_.canTrim()){
+                    waitTime = lcore::thread::Infinite;
+                }
+            }else{
+                u64 now = lcore::getTimeMicroSeconds();
+                u64 deadline = voices_.deadlines_[schedule_[0]];
+                waitTime = (deadline<=now)? 0 : static_cast<u32>((deadline-now)/1000);
+            }
+        }
 
         LSOUND_DECL_START
         waitEvent_.wait(waitTime);
         LSOUND_DECL_STOP("wait: %f\n")
 
+        //Sources and stream slots are made and released here, not in play
+        playerPool_.update(initParam_.poolTrimDelay_);
+        streamPool_.update(initParam_.poolTrimDelay_);
+
         //VKNGXg
-        playerLock_.enter();
-        Player* requestList = getRequestList();
-        playerLock_.leave();
-        while(NULL != requestList){
+        s32 index = getRequestList();
+        while(0<=index){
             LSOUND_DECL_START;
-            Player* request = requestList;
-            requestList = requestList->getNext();
+            Player* request = &players_[index];
+            index = request->next_;
+            //Opening parses headers and reads files, so it is not done by the caller of play
+            if(!openStream(request)){
+                releasePlayer(request);
+                continue;
+            }
             initPlayer(request);
-            request->link(&playList_);
+            addPlaying(request);
+            if(NULL != request->userPlayer_){
+                applyUserControls(request);
+            }
+            voices_.deadlines_[request->index_] = getDeadline(request, lcore::getTimeMicroSeconds());
+            pushSchedule(request);
             LSOUND_DECL_STOP("initial:%f\n")
         }
 
-        Player* endList = NULL;
-
-        Player* player = playList_.getNext();
-        while(player != &playList_){
-            //LSOUND_DECL_START
+        if(0<numControls_ && 0<lcore::atomicExchange(&numControls_, 0)){
+            applyUserControls();
+        }
 
-            Player* current = player;
-            player = player->getNext();
+        u64 now = lcore::getTimeMicroSeconds();
+        while(0<numScheduled_ && voices_.deadlines_[schedule_[0]]<=(now+DeadlineSlack)){
+            Player* current = popSchedule();
+            if(current->checkInnerFlag(Player::InnerFlag_Stop)){
+                current->clear();
+                removePlaying(current);
+                releasePlayer(current);
+                continue;
+            }
 
             s32 processed = current->getProcessed();
             ALenum err = getError();
             if(err != AL_NO_ERROR){
                 logError(err);
+                voices_.deadlines_[current->index_] = now + initParam_.waitTime_*1000;
+                pushSchedule(current);
                 continue;
             }
 
@@ -361,21 +405,16 @@ namespace
                 current->unqueueBuffers(1, &bufid);
                 --processed;
 
-                lsound::Stream* stream = current->stream_;
-                s32 numSamples = stream->read(pcm_, BufferNumSamples);
-                if(0<numSamples){
-                    lpAlBufferSamplesSOFT(bufid, stream->getSampleRate(), stream->getFormat(), numSamples, stream->getChannels(), stream->getType(), pcm_);
+                lsound::Stream* stream = voices_.streams_[current->index_];
+                s32 numFrames = fillBuffer(current, userFlags);
+                if(0<numFrames){
+                    lpAlBufferSamplesSOFT(bufid, stream->getSampleRate(), stream->getFormat(), numFrames, stream->getChannels(), stream->getType(), pcm_);
                     current->queueBuffers(1, &bufid);
                 }
 
                 if(stream->getTotal()<=stream->getPosition()){
                     //Sď
-                    //[vȂ擪ɃV[N
-                    if((userFlags & PlayerFlag_Loop)){
-                        stream->seek(0);
-                    }else{
-                        break;
-                    }
+                    break;
                 }
             }
 
@@ -383,41 +422,163 @@ namespace
             if(State_Playing != state && State_Paused != state){
                 if(current->getQueued()<=0){
                     current->clear();
-                    current->unlink();
-                    current->setNext(endList);
-                    endList = current;
+                    removePlaying(current);
+                    releasePlayer(current);
                     continue;
                 }
                 if(!current->checkInnerFlag(Player::InnerFlag_UserPlayer)){
                     current->play();
                 }
             }
+            if(NULL != current->userPlayer_){
+                publish(current, state);
+            }
+            voices_.deadlines_[current->index_] = getDeadline(current, now);
+            pushSchedule(current);
+        }
+    }
 
-            //INGXg
-            {
-                lcore::CSLock lock(playerLock_);
-                while(NULL != endList){
-                    Player* current = endList;
-                    endList = endList->getNext();
-                    current->resetLink();
-                    releasePlayer(current);
-                }
+    void Context::addPlaying(Player* player)
+    {
+        player->slot_ = numPlaying_;
+        playing_[numPlaying_] = player->index_;
+        ++numPlaying_;
+    }
+
+    void Context::removePlaying(Player* player)
+    {
+        LASSERT(0<=player->slot_ && player->slot_<numPlaying_);
+        //Move the last one to the hole
+        --numPlaying_;
+        Player& last = players_[playing_[numPlaying_]];
+        playing_[player->slot_] = last.index_;
+        last.slot_ = player->slot_;
+        player->slot_ = -1;
+    }
+
+    void Context::addControl()
+    {
+        lcore::atomicIncrement(&numControls_);
+    }
+
+    void Context::applyUserControls()
+    {
+        for(s32 i=0; i<numPlaying_; ++i){
+            Player* player = &players_[playing_[i]];
+            if(NULL != player->userPlayer_){
+                applyUserControls(player);
             }
+        }
+    }
 
-            //LSOUND_DECL_LATENCY(current->source_);
-            //LSOUND_DECL_STOP("update:%f\n")
+    void Context::applyUserControls(Player* player)
+    {
+        UserPlayer* userPlayer = player->userPlayer_;
+        s32 controls = userPlayer->takeControls();
+        if(controls & UserPlayer::Control_Gain){
+            player->setGain(userPlayer->gain_);
         }
+        if(controls & UserPlayer::Control_Pitch){
+            player->setPitch(userPlayer->pitch_);
+        }
+
+        switch(userPlayer->takeRequest())
+        {
+        case UserPlayer::Request_Play:
+            player->play();
+            break;
+        case UserPlayer::Request_Pause:
+            player->pause();
+            break;
+        case UserPlayer::Request_Stop:
+            //Released at its next schedule
+            player->stop();
+            player->setInnerFlag(Player::InnerFlag_Stop);
+            break;
+        default:
+            break;
+        }
+        publish(player, player->getState());
+    }
+
+    void Context::publish(Player* player, State state)
+    {
+        //Approximated as every queued buffer is full
+        s32 queuedFrames = player->getQueued()*player->bufferFrames_ - static_cast<s32>(player->getSampleOffset());
+        queuedFrames = lcore::maximum(queuedFrames, 0);
+        lsound::Stream* stream = voices_.streams_[player->index_];
+        opus_int64 position = stream->getPosition() - queuedFrames;
+        player->userPlayer_->publish(
+            state,
+            (position<0)? 0 : static_cast<u32>(position),
+            static_cast<f32>(queuedFrames)/stream->getSampleRate());
+    }
+
+    u64 Context::getDeadline(Player* player, u64 now)
+    {
+        if(State_Playing != player->getState()){
+            //Paused or stopped by the user, check again later
+            return now + initParam_.waitTime_*1000;
+        }
+        s32 remain = player->bufferFrames_ - static_cast<s32>(player->getSampleOffset());
+        f32 pitch = player->getPitch();
+        u64 interval = (0<remain && 0.0f<pitch)? static_cast<u64>(remain*(1000000.0f/SampleRate_48000)/pitch) : 0;
+        return now + lcore::maximum(interval, MinUpdateInterval);
+    }
+
+    void Context::pushSchedule(Player* player)
+    {
+        LASSERT(numScheduled_<initParam_.maxPlayers_);
+        const u64* deadlines = voices_.deadlines_;
+        u64 deadline = deadlines[player->index_];
+        s32 index = numScheduled_;
+        ++numScheduled_;
+        while(0<index){
+            s32 parent = (index-1)>>1;
+            if(deadlines[schedule_[parent]]<=deadline){
+                break;
+            }
+            schedule_[index] = schedule_[parent];
+            index = parent;
+        }
+        schedule_[index] = player->index_;
+    }
+
+    Player* Context::popSchedule()
+    {
+        LASSERT(0<numScheduled_);
+        const u64* deadlines = voices_.deadlines_;
+        u16 top = schedule_[0];
+        --numScheduled_;
+        u16 last = schedule_[numScheduled_];
+        u64 deadline = deadlines[last];
+        s32 index = 0;
+        for(;;){
+            s32 child = (index<<1) + 1;
+            if(numScheduled_<=child){
+                break;
+            }
+            if((child+1)<numScheduled_ && deadlines[schedule_[child+1]]<deadlines[schedule_[child]]){
+                ++child;
+            }
+            if(deadline<=deadlines[schedule_[child]]){
+                break;
+            }
+            schedule_[index] = schedule_[child];
+            index = child;
+        }
+        schedule_[index] = last;
+        return &players_[top];
     }
 
     void Context::initPlayer(Player* player)
     {
-        player->resetLink();
         u16 userFlags = player->getUserFlags();
-        for(s32 i=0; i<1; ++i){
-            lsound::Stream* stream = player->stream_;
-            s32 numSamples = stream->read(pcm_, BufferNumSamples);
-            if(0<numSamples){
-                lpAlBufferSamplesSOFT(player->buffers_[i], stream->getSampleRate(), stream->getFormat(), numSamples, stream->getChannels(), stream->getType(), pcm_);
+        for(s32 i=0; i<player->numBuffers_; ++i){
+            lsound::Stream* stream = voices_.streams_[player->index_];
+            s32 numFrames = fillBuffer(player, userFlags);
+            if(0<numFrames){
+                lpAlBufferSamplesSOFT(player->buffers_[i], stream->getSampleRate(), stream->getFormat(), numFrames, stream->getChannels(), stream->getType(), pcm_);
                 player->queueBuffers(1, &player->buffers_[i]);
 
                 ALenum err = getError();
@@ -425,7 +586,6 @@ namespace
                     logError(err);
                     //request->clear();
 
-                    //lcore::CSLock lock(playerLock_);
                     //releasePlayer(request);
                     //request = NULL;
                     //break;
@@ -434,12 +594,7 @@ namespace
 
             if(stream->getTotal()<=stream->getPosition()){
                 //Sď
-                //[vȂ擪ɃV[N
-                if(userFlags & PlayerFlag_Loop){
-                    stream->seek(0);
-                }else{
-                    break;
-                }
+                break;
             }
         }
         State state = player->getState();
@@ -457,6 +612,38 @@ namespace
         }
     }
 
+    s32 Context::fillBuffer(Player* player, u16 userFlags)
+    {
+        lsound::Stream* stream = voices_.streams_[player->index_];
+        s32 samplesPerFrame = (Channels_Mono == stream->getChannels())? 1 : 2;
+        s32 frames = 0;
+        while(frames<player->bufferFrames_){
+            //op_read returns one packet at most
+            s32 s = stream->read(pcm_ + frames*samplesPerFrame, (player->bufferFrames_-frames)*samplesPerFrame);
+            if(s<0){
+                break;
+            }
+            frames += s;
+            if(stream->getTotal()<=stream->getPosition()){
+                //Reached the end, seek to the top if looping
+                if(userFlags & PlayerFlag_Loop){
+                    stream->seek(0);
+                }else{
+                    break;
+                }
+            }else if(s<=0){
+                break;
+            }
+        }
+        return frames;
+    }
+
+    s32 Context::getBufferFrames(u32 duration) const
+    {
+        s32 frames = static_cast<s32>((static_cast<u64>(duration)*SampleRate_48000)/1000);
+        return lcore::clamp(frames, 1, maxBufferFrames_);
+    }
+
 
     s32 Context::loadResourcePack(s32 id, const Char* path, bool stream)
     {
@@ -464,7 +651,7 @@ namespace
 
         PackResource* packResource = NULL;
         if(stream){
-            packResource = PackFile::open(path);
+            packResource = PackFile::open(path, initParam_.readBlockSize_, initParam_.numReadBlocks_);
         }else{
             packResource = PackMemory::open(path);
         }
@@ -478,199 +665,125 @@ namespace
         return id;
     }
 
-    bool Context::play(s32 packId, s32 id, f32 gain)
+    s32 Context::mapResourcePack(s32 id, const Char* path)
+    {
+        LASSERT(0<=id && id<NumMaxPacks);
+
+        PackResource* packResource = PackMapped::open(path);
+        if(NULL == packResource){
+            return -1;
+        }
+
+        LIME_DELETE(packResources_[id]);
+        packResources_[id] = packResource;
+        return id;
+    }
+
+    Handle Context::play(s32 packId, s32 id, f32 gain)
     {
         LASSERT(0<=packId && packId<NumMaxPacks);
         LASSERT(0<=id);
 
         PackResource* packResource = packResources_[packId];
         if(NULL == packResource){
-            return false;
+            return InvalidHandle;
         }
         if(packResource->getNumFiles()<=id){
-            return false;
+            return InvalidHandle;
         }
 
-        Player* player;
-        StreamEntry* streamEntry;
-        {
-            lcore::CSLock lock(playerLock_);
-            if(numPlayers_<=0){
-                return false;
-            }
-            player = getPlayer();
-
-            if(NULL == streamTop_){
-                releasePlayer(player);
-                return false;
-            }
-            streamEntry = getStream();
+        Player* player = getPlayer();
+        if(NULL == player){
+            return InvalidHandle;
         }
-
-        Stream* stream;
-        switch(packResource->getType())
-        {
-        case PackResource::ResourceType_File:
-            {
-
-                FileStream* fileStream = LIME_PLACEMENT_NEW(streamEntry) FileStream();
-                PackFile* packFile = reinterpret_cast<PackFile*>(packResource);
-                File* file;
-                s32 start, end;
-                packFile->get(id, file, start, end);
-                fileStream->set(file, start, end);
-                stream = fileStream;
-            }
-            break;
-
-        case PackResource::ResourceType_Memory:
-            {
-                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry) MemoryStream();
-                PackMemory* packMemory = reinterpret_cast<PackMemory*>(packResource);
-                Memory* memory;
-                u32 size;
-                s32 offset;
-                packMemory->get(id, memory, size, offset);
-                memoryStream->set(size, offset, memory);
-                stream = memoryStream;
-            }
-            break;
-
-        default:
-            {
-                lcore::CSLock lock(playerLock_);
-                releasePlayer(player);
-                releaseStream((Stream*)streamEntry);
-            }
-            return false;
+        StreamEntry* streamEntry = getStream();
+        if(NULL == streamEntry){
+            releasePlayer(player);
+            return InvalidHandle;
         }
 
-        if(!stream->open() || stream->getTotal()<=0){
-            lcore::CSLock lock(playerLock_);
+        Stream* stream = createStream(streamEntry, packResource, id);
+        if(NULL == stream){
             releasePlayer(player);
-            releaseStream(stream);
-            return false;
+            return InvalidHandle;
         }
         player->setStream(stream);
+        player->setInnerFlag(Player::InnerFlag_Open);
+        player->setBufferFrames(bufferFrames_);
         player->setGain(gain);
         player->rewind();
 
-        {
-            lcore::CSLock lock(playerLock_);
-            player->setNext(requestList_);
-            requestList_ = player;
-        }
-        ++numRequests_;
-        return true;
+        Handle handle = player->getHandle();
+        addRequest(player);
+        return handle;
     }
 
-    UserPlayer* Context::createUserPlayer(s32 packId, s32 id)
+    Handle Context::createUserPlayer(s32 packId, s32 id, u32 bufferDuration)
     {
         LASSERT(0<=packId && packId<NumMaxPacks);
         LASSERT(0<=id);
 
         PackResource* packResource = packResources_[packId];
         if(NULL == packResource){
-            return NULL;
+            return InvalidHandle;
         }
         if(packResource->getNumFiles()<=id){
-            return NULL;
+            return InvalidHandle;
         }
 
-        UserPlayer* userPlayer;
-        Player* player;
-        StreamEntry* streamEntry;
-        {
-            if(numUserPlayers_<=0){
-                return NULL;
-            }
-
-            userPlayer = getUserPlayer();
-
-            lcore::CSLock lock(playerLock_);
-            if(numPlayers_<=0){
-                releaseUserPlayer(userPlayer);
-                return NULL;
-            }
-            player = getPlayer();
-
-            if(NULL == streamTop_){
-                releaseUserPlayer(userPlayer);
-                releasePlayer(player);
-                return NULL;
-            }
-            streamEntry = getStream();
+        UserPlayer* userPlayer = getUserPlayer();
+        if(NULL == userPlayer){
+            return InvalidHandle;
         }
-
-        Stream* stream;
-        switch(packResource->getType())
-        {
-        case PackResource::ResourceType_File:
-            {
-
-                FileStream* fileStream = LIME_PLACEMENT_NEW(streamEntry) FileStream();
-                PackFile* packFile = reinterpret_cast<PackFile*>(packResource);
-                File* file;
-                s32 start, end;
-                packFile->get(id, file, start, end);
-                fileStream->set(file, start, end);
-                stream = fileStream;
-            }
-            break;
-
-        case PackResource::ResourceType_Memory:
-            {
-                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry) MemoryStream();
-                PackMemory* packMemory = reinterpret_cast<PackMemory*>(packResource);
-                Memory* memory;
-                u32 size;
-                s32 offset;
-                packMemory->get(id, memory, size, offset);
-                memoryStream->set(size, offset, memory);
-                stream = memoryStream;
-            }
-            break;
-
-        default:
-            {
-                lcore::CSLock lock(playerLock_);
-                releaseUserPlayer(userPlayer);
-                releasePlayer(player);
-                releaseStream((Stream*)streamEntry);
-            }
-            return NULL;
+        Player* player = getPlayer();
+        if(NULL == player){
+            releaseUserPlayer(userPlayer);
+            return InvalidHandle;
+        }
+        StreamEntry* streamEntry = getStream();
+        if(NULL == streamEntry){
+            releaseUserPlayer(userPlayer);
+            releasePlayer(player);
+            return InvalidHandle;
         }
 
-        if(!stream->open() || stream->getTotal()<=0){
-            lcore::CSLock lock(playerLock_);
+        Stream* stream = createStream(streamEntry, packResource, id);
+        if(NULL == stream){
             releaseUserPlayer(userPlayer);
             releasePlayer(player);
-            releaseStream(stream);
-            return NULL;
+            return InvalidHandle;
         }
         player->setStream(stream);
+        player->setInnerFlag(Player::InnerFlag_Open);
+        player->setBufferFrames((0<bufferDuration)? getBufferFrames(bufferDuration) : bufferFrames_);
         player->setGain(1.0f);
         player->setInnerFlag(Player::InnerFlag_UserPlayer);
         
         player->rewind();
         player->userPlayer_ = userPlayer;
-        userPlayer->impl_.player_ = player;
+        //Released by the caller and the player each
+        lcore::atomicIncrement(&userPlayer->refCount_);
 
-        {
-            lcore::CSLock lock(playerLock_);
-            player->setNext(requestList_);
-            requestList_ = player;
-        }
-        ++numRequests_;
-        return userPlayer;
+        Handle handle = makeHandle(static_cast<s32>(userPlayer - userPlayers_), static_cast<u16>(userPlayer->generation_));
+        addRequest(player);
+        return handle;
     }
 
-    void Context::destroyUserPlayer(UserPlayer* player)
+    void Context::destroyUserPlayer(Handle handle)
     {
+        UserPlayer* player = findUserPlayer(handle);
         if(NULL == player){
             return;
         }
-        player->impl_.player_->stop();
+        //Reject the handle from now, only the caller retiring its generation releases the reference.
+        //The slot is reused after the player releases it too
+        s32 generation = getHandleGeneration(handle);
+        if(generation != lcore::atomicCompareExchange(&player->generation_, nextGeneration(static_cast<u16>(generation)), generation)){
+            return;
+        }
+        //The player stops at the next update, then releases its reference
+        lcore::atomicExchange(&player->request_, UserPlayer::Request_Stop);
+        addControl();
         releaseUserPlayer(player);
     }
 
@@ -796,44 +909,22 @@ namespace
 
     void Context::clear()
     {
-        Player* endList = NULL;
-
-        Player* player = playList_.getNext();
-        while(player != &playList_){
-            Player* current = player;
-            player = player->getNext();
+        numScheduled_ = 0;
 
+        for(s32 i=0; i<numPlaying_; ++i){
+            Player* current = &players_[playing_[i]];
             current->clear();
-            current->unlink();
-            current->setNext(endList);
-            endList = current;
+            current->slot_ = -1;
+            releasePlayer(current);
         }
+        numPlaying_ = 0;
 
-        //INGXgAVKNGXg
-        Player* requestList = NULL;
-        {
-            lcore::CSLock lock(playerLock_);
-            requestList = getRequestList();
-        }
-
-        while(NULL != requestList){
-            Player* request = requestList;
-            requestList = requestList->getNext();
-            request->resetLink();
-
-            request->clear();
-            request->setNext(endList);
-            endList = request;
-        }
-
-        {
-            lcore::CSLock lock(playerLock_);
-            while(NULL != endList){
-                Player* current = endList;
-                endList = endList->getNext();
-                current->resetLink();
-                releasePlayer(current);
-            }
+        s32 request = getRequestList();
+        while(0<=request){
+            Player* current = &players_[request];
+            request = current->next_;
+            current->clear();
+            releasePlayer(current);
         }
     }
 
@@ -854,124 +945,259 @@ namespace
     void Context::initStreams()
     {
         LASSERT(NULL == streams_);
-        numStreams_ = initParam_.maxPlayers_;
-        u32 elemSize = lcore::maximum(sizeof(FileStream), sizeof(MemoryStream));
-        u8* buffer = (u8*)LIME_MALLOC(elemSize * initParam_.maxPlayers_);
-
-        StreamEntry* entry;
-        for(s32 i=0; i<(initParam_.maxPlayers_-1); ++i){
-            entry = reinterpret_cast<StreamEntry*>(buffer + i*elemSize);
-            entry->next_ = reinterpret_cast<StreamEntry*>(buffer + (i+1)*elemSize);
+        streamSize_ = lcore::maximum(sizeof(FileStream), sizeof(MemoryStream));
+        streams_ = LIME_NEW StreamEntry*[initParam_.maxPlayers_];
+        for(s32 i=0; i<initParam_.maxPlayers_; ++i){
+            streams_[i] = NULL;
         }
-        entry = reinterpret_cast<StreamEntry*>(buffer + (initParam_.maxPlayers_-1)*elemSize);
-        entry->next_ = NULL;
-
-        streamTop_ = reinterpret_cast<StreamEntry*>(buffer);
-        streams_ = reinterpret_cast<StreamEntry*>(buffer);
+        streamPool_.create(initParam_.maxPlayers_, initParam_.poolChunkSize_, createStreamProc, destroyStreamProc, this);
     }
 
     void Context::initPlayers()
     {
         LASSERT(NULL == players_);
-        numPlayers_ = initParam_.maxPlayers_;
         players_ = LIME_NEW Player[initParam_.maxPlayers_];
+        voices_.create(initParam_.maxPlayers_);
+        schedule_ = LIME_NEW u16[initParam_.maxPlayers_];
+
+        playing_ = LIME_NEW u16[initParam_.maxPlayers_];
+
+        for(s32 i=0; i<initParam_.maxPlayers_; ++i){
+            players_[i].table_ = &voices_;
+            players_[i].index_ = static_cast<u16>(i);
+        }
+        playerPool_.create(initParam_.maxPlayers_, initParam_.poolChunkSize_, createPlayerProc, destroyPlayerProc, this);
 
-        for(s32 i=initParam_.maxPlayers_-1; 0<=i; --i){
-            players_[i].create(initParam_.numQueuedBuffers_);
-            players_[i].link(playerTop_.getNext());
+        s32 numBlocks = (0<initParam_.maxPlayingVoices_)? lcore::minimum(initParam_.maxPlayingVoices_, initParam_.maxPlayers_) : initParam_.maxPlayers_;
+        bufferPool_.create(sizeof(LSuint)*initParam_.numQueuedBuffers_, numBlocks);
+        for(s32 i=0; i<numBlocks; ++i){
+            alGenBuffers(initParam_.numQueuedBuffers_, reinterpret_cast<LSuint*>(bufferPool_.getBlock(i)));
         }
     }
 
     void Context::initUserPlayers()
     {
         LASSERT(NULL == userPlayers_);
-        numUserPlayers_ = initParam_.maxUserPlayers_;
         userPlayers_ = LIME_NEW UserPlayer[initParam_.maxUserPlayers_];
-
-        for(s32 i=0; i<(initParam_.maxUserPlayers_-1); ++i){
-            userPlayers_[i].impl_.next_ = &userPlayers_[i+1];
-        }
-        userPlayers_[initParam_.maxUserPlayers_-1].impl_.next_ = NULL;
-        userPlayerTop_ = &userPlayers_[0];
+        freeUserPlayers_.initialize(initParam_.maxUserPlayers_);
     }
 
     u32 Context::getWaitTime()
     {
-        lcore::CSLock lock(playerLock_);
         return waitTime_;
     }
 
+    bool Context::createStreamProc(s32 index, void* data)
+    {
+        Context* context = reinterpret_cast<Context*>(data);
+        void* memory = LIME_MALLOC(sizeof(StreamEntry) + context->streamSize_);
+        if(NULL == memory){
+            return false;
+        }
+        StreamEntry* entry = reinterpret_cast<StreamEntry*>(memory);
+        entry->index_ = index;
+        context->streams_[index] = entry;
+        return true;
+    }
+
+    void Context::destroyStreamProc(s32 index, void* data)
+    {
+        Context* context = reinterpret_cast<Context*>(data);
+        LIME_FREE(context->streams_[index]);
+    }
+
     Context::StreamEntry* Context::getStream()
     {
-        StreamEntry* entry = streamTop_;
-        streamTop_ = streamTop_->next_;
-        --numStreams_;
-        return entry;
+        s32 index = streamPool_.pop();
+        return (index<0)? NULL : streams_[index];
     }
 
     void Context::releaseStream(Stream* stream)
     {
         LASSERT(NULL != stream);
         stream->~Stream();
-        StreamEntry* entry = reinterpret_cast<StreamEntry*>(stream);
-        entry->next_ = streamTop_;
-        streamTop_ = entry;
-        ++numStreams_;
+        StreamEntry* entry = reinterpret_cast<StreamEntry*>(stream) - 1;
+        streamPool_.push(entry->index_);
+    }
+
+    Stream* Context::createStream(StreamEntry* streamEntry, PackResource* packResource, s32 id)
+    {
+        Stream* stream;
+        switch(packResource->getType())
+        {
+        case PackResource::ResourceType_File:
+            {
+                FileStream* fileStream = LIME_PLACEMENT_NEW(streamEntry+1) FileStream();
+                PackFile* packFile = reinterpret_cast<PackFile*>(packResource);
+                File* file;
+                s32 start, end;
+                packFile->get(id, file, start, end);
+                fileStream->set(file, start, end);
+                packResource->setStreamInfo(id, *fileStream);
+                stream = fileStream;
+            }
+            break;
+
+        case PackResource::ResourceType_Memory:
+            {
+                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry+1) MemoryStream();
+                PackMemory* packMemory = reinterpret_cast<PackMemory*>(packResource);
+                Memory* memory;
+                u32 size;
+                s32 offset;
+                packMemory->get(id, memory, size, offset);
+                memoryStream->set(size, offset, memory);
+                packResource->setStreamInfo(id, *memoryStream);
+                stream = memoryStream;
+            }
+            break;
+
+        case PackResource::ResourceType_Mapped:
+            {
+                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry+1) MemoryStream();
+                PackMapped* packMapped = reinterpret_cast<PackMapped*>(packResource);
+                Memory* memory;
+                u32 size;
+                s32 offset;
+                packMapped->get(id, memory, size, offset);
+                packMapped->prefetch(id);
+                memoryStream->set(size, offset, memory);
+                packResource->setStreamInfo(id, *memoryStream);
+                stream = memoryStream;
+            }
+            break;
+
+        default:
+            streamPool_.push(streamEntry->index_);
+            return NULL;
+        }
+        return stream;
+    }
+
+    bool Context::openStream(Player* player)
+    {
+        if(!player->checkInnerFlag(Player::InnerFlag_Open)){
+            return true;
+        }
+        player->resetInnerFlag(Player::InnerFlag_Open);
+        Stream* stream = voices_.streams_[player->index_];
+        return stream->open() && 0<stream->getTotal();
+    }
+
+    bool Context::createPlayerProc(s32 index, void* data)
+    {
+        Context* context = reinterpret_cast<Context*>(data);
+        return context->players_[index].create(context->initParam_.numQueuedBuffers_);
+    }
+
+    void Context::destroyPlayerProc(s32 index, void* data)
+    {
+        Context* context = reinterpret_cast<Context*>(data);
+        context->players_[index].destroy();
     }
 
     Player* Context::getPlayer()
     {
-        Player* player = playerTop_.getNext();
-        player->unlink();
-        player->userFlags_ = 0;
-        player->innerFlags_ = 0;
+        s32 index = playerPool_.pop();
+        if(index<0){
+            return NULL;
+        }
+        Player* player = &players_[index];
+        player->block_ = bufferPool_.pop();
+        if(player->block_<0){
+            playerPool_.push(index);
+            return NULL;
+        }
+        player->buffers_ = reinterpret_cast<LSuint*>(bufferPool_.getBlock(player->block_));
+        voices_.userFlags_[index] = 0;
+        voices_.innerFlags_[index] = 0;
         player->userPlayer_ = NULL;
-
-        --numPlayers_;
         return player;
     }
 
     void Context::releasePlayer(Player* player)
     {
         LASSERT(NULL != player);
-        //player->resetLink();
 
-        if(NULL != player->stream_){
-            releaseStream(player->stream_);
-            player->stream_ = NULL;
+        if(NULL != player->userPlayer_){
+            Stream* stream = voices_.streams_[player->index_];
+            u32 position = (NULL != stream)? static_cast<u32>(stream->getPosition()) : 0;
+            player->userPlayer_->publish(State_Stopped, position, 0.0f);
+            releaseUserPlayer(player->userPlayer_);
+            player->userPlayer_ = NULL;
+        }
+        Stream*& stream = voices_.streams_[player->index_];
+        if(NULL != stream){
+            releaseStream(stream);
+            stream = NULL;
         }
-        player->link(&playerTop_);
-        ++numPlayers_;
+        bufferPool_.push(player->block_);
+        player->block_ = -1;
+        player->buffers_ = NULL;
+        player->generation_ = nextGeneration(player->generation_);
+        playerPool_.push(player->index_);
     }
 
     UserPlayer* Context::getUserPlayer()
     {
-        UserPlayer* player = userPlayerTop_;
-        userPlayerTop_ = userPlayerTop_->impl_.next_;
-        player->flags_ = 0;
-        --numUserPlayers_;
+        s32 index = freeUserPlayers_.pop();
+        if(index<0){
+            return NULL;
+        }
+        UserPlayer* player = &userPlayers_[index];
+        player->reset();
         return player;
     }
 
     void Context::releaseUserPlayer(UserPlayer* player)
     {
         LASSERT(NULL != player);
-        player->impl_.next_ = userPlayerTop_;
-        userPlayerTop_ = player;
-        ++numUserPlayers_;
+        if(0 == lcore::atomicDecrement(&player->refCount_)){
+            freeUserPlayers_.push(static_cast<s32>(player - userPlayers_));
+        }
     }
 
     void Context::addRequest(Player* player)
     {
         LASSERT(NULL != player);
-        player->setNext(requestList_);
-        requestList_ = player;
+        for(;;){
+            s32 top = requestList_;
+            player->next_ = top;
+            if(top == lcore::atomicCompareExchange(&requestList_, player->index_, top)){
+                break;
+            }
+        }
+        lcore::atomicIncrement(&numRequests_);
+    }
+
+    s32 Context::getRequestList()
+    {
+        return lcore::atomicExchange(&requestList_, -1);
+    }
+
+    UserPlayer* Context::findUserPlayer(Handle handle)
+    {
+        s32 index = getHandleIndex(handle);
+        if(initParam_.maxUserPlayers_<=index){
+            return NULL;
+        }
+        UserPlayer* player = &userPlayers_[index];
+        return (getHandleGeneration(handle) == player->generation_)? player : NULL;
+    }
+
+    bool Context::isPlaying(Handle handle) const
+    {
+        s32 index = getHandleIndex(handle);
+        if(initParam_.maxPlayers_<=index){
+            return false;
+        }
+        return getHandleGeneration(handle) == players_[index].generation_;
     }
 
-    Player* Context::getRequestList()
+    void Context::getBufferUsage(s32& numUsed, s32& highWatermark, s32& capacity) const
     {
-        Player* ret = requestList_;
-        requestList_ = NULL;
-        return ret;
+        numUsed = bufferPool_.getNumUsed();
+        highWatermark = bufferPool_.getHighWatermark();
+        capacity = bufferPool_.getCapacity();
     }
 }
@@ -10,7 +10,10 @@
 #include <AL/alext.h>
 #include <opus/opus_types.h>
 #include <lcore/async/SyncObject.h>
+#include <lcore/async/LockFree.h>
 #include "../lsound.h"
+#include "../BufferPool.h"
+#include "../SlotPool.h"
 #include "Player.h"
 
 namespace lcore
@@ -33,14 +36,28 @@ namespace lsound
             InitParam()
                 :numQueuedBuffers_(3)
                 ,maxPlayers_(128)
+                ,poolChunkSize_(16)
+                ,poolTrimDelay_(1000)
+                ,maxPlayingVoices_(32)
                 ,maxUserPlayers_(8)
                 ,waitTime_(30)
+                ,readBlockSize_(64*1024)
+                ,numReadBlocks_(16)
+                ,bufferDuration_(50)
+                ,maxBufferDuration_(200)
             {}
 
             s32 numQueuedBuffers_;
             s32 maxPlayers_;
+            s32 poolChunkSize_; //sources and stream slots made at once, first in initialize then by the context thread when few are free
+            s32 poolTrimDelay_; //updates of the context thread with many free ones before a chunk of them is released
+            s32 maxPlayingVoices_; //voices holding queued buffers at once, 0 for maxPlayers_
             s32 maxUserPlayers_;
             u32 waitTime_;
+            u32 readBlockSize_; //read-ahead block of streamed packs
+            s32 numReadBlocks_; //blocks shared by streams of a pack, 0 to read directly
+            u32 bufferDuration_; //milliseconds of pcm in a queued buffer
+            u32 maxBufferDuration_; //longest buffer a user player can request
         };
 
         static bool initialize(const InitParam& initParam);
@@ -55,9 +72,35 @@ namespace lsound
 
         s32 loadResourcePack(s32 id, const Char* path, bool stream);
 
-        bool play(s32 packId, s32 id, f32 gain=1.0f);
-        UserPlayer* createUserPlayer(s32 packId, s32 id);
-        void destroyUserPlayer(UserPlayer* player);
+        /**
+        @brief Map a pack into memory, its entries are read on demand without copying
+        */
+        s32 mapResourcePack(s32 id, const Char* path);
+
+        /**
+        @return handle of the voice, InvalidHandle if failed
+        */
+        Handle play(s32 packId, s32 id, f32 gain=1.0f);
+        /**
+        @param bufferDuration ... milliseconds of pcm in a queued buffer, 0 for InitParam::bufferDuration_
+        */
+        Handle createUserPlayer(s32 packId, s32 id, u32 bufferDuration=0);
+        void destroyUserPlayer(Handle handle);
+
+        /**
+        @return NULL if the handle has been destroyed
+        */
+        UserPlayer* findUserPlayer(Handle handle);
+
+        /**
+        @brief Whether the voice has not been released yet, paused ones too
+        */
+        bool isPlaying(Handle handle) const;
+
+        /**
+        @brief Blocks of the buffer pool in use now, the most used at once, and all of them
+        */
+        void getBufferUsage(s32& numUsed, s32& highWatermark, s32& capacity) const;
 
         static LSenum getFormat(LSenum channels, LSenum type, LPALISBUFFERFORMATSUPPORTEDSOFT isBufferSupportedSOFT);
         
@@ -71,9 +114,11 @@ namespace lsound
         Context(const Context&);
         Context& operator=(const Context&);
 
+        /// Header of a stream slot, streamSize_ bytes of the stream follow
         struct StreamEntry
         {
-            StreamEntry* next_;
+            s32 index_;
+            s32 padding_[3];
         };
 
         Context();
@@ -99,13 +144,50 @@ namespace lsound
 
         void initPlayer(Player* player);
 
+        /// Called by user players on any thread, wakes the context at the next updateRequests
+        void addControl();
+
+        /// Consume controls written to the user players
+        void applyUserControls();
+        void applyUserControls(Player* player);
+        void publish(Player* player, State state);
+
+        /**
+        @brief Decode packets into pcm_ until the buffer of a player is full or the stream ends
+        @return number of frames
+        */
+        s32 fillBuffer(Player* player, u16 userFlags);
+        s32 getBufferFrames(u32 duration) const;
+
         void update();
 
+        /// Players nearer to its deadline than this are updated in this wakeup
+        static const u64 DeadlineSlack = 1000;
+        /// Shortest interval between updates of a player
+        static const u64 MinUpdateInterval = 1000;
+
+        /**
+        @brief When the first queued buffer of a player will have been processed
+        */
+        u64 getDeadline(Player* player, u64 now);
+
+        /// Min-heap of playing players ordered by deadline
+        void pushSchedule(Player* player);
+        Player* popSchedule();
+
         u32 getWaitTime();
 
+        static bool createStreamProc(s32 index, void* data);
+        static void destroyStreamProc(s32 index, void* data);
         StreamEntry* getStream();
         void releaseStream(Stream* stream);
+        /// Construct a stream of an entry, it is opened later by the context thread
+        Stream* createStream(StreamEntry* streamEntry, PackResource* packResource, s32 id);
+        /// Open the stream of a requested player, false if it cannot be played
+        bool openStream(Player* player);
 
+        static bool createPlayerProc(s32 index, void* data);
+        static void destroyPlayerProc(s32 index, void* data);
         Player* getPlayer();
         void releasePlayer(Player* player);
 
@@ -113,7 +195,12 @@ namespace lsound
         void releaseUserPlayer(UserPlayer* player);
 
         void addRequest(Player* player);
-        Player* getRequestList();
+        /// Index of the top request, -1 if empty
+        s32 getRequestList();
+
+        /// Dense table of playing players, removed by moving the last one
+        void addPlaying(Player* player);
+        void removePlaying(Player* player);
 
         static Context* instance_;
 
@@ -123,28 +210,34 @@ namespace lsound
         ALCdevice* device_;
         ALCcontext* context_;
 
-        s32 numStreams_;
-        StreamEntry* streamTop_;
-        StreamEntry* streams_;
+        u32 streamSize_;
+        SlotPool streamPool_;
+        StreamEntry** streams_; ///< NULL for slots not made
 
-        s32 numPlayers_;
-        PlayerLink playerTop_;
+        SlotPool playerPool_; ///< players with sources
         Player* players_;
+        VoiceTable voices_;
+        BufferPool bufferPool_; ///< names of al buffers, numQueuedBuffers_ in a block
 
-        s32 numUserPlayers_;
-        UserPlayer* userPlayerTop_;
+        lcore::LockFreeIndexStack freeUserPlayers_;
         UserPlayer* userPlayers_;
 
         PackResource* packResources_[NumMaxPacks];
 
-        u32 numRequests_;
-        Player* requestList_;
-        PlayerLink playList_;
+        //Pushed by any thread, taken at once by the context
+        volatile s32 numRequests_;
+        volatile s32 requestList_;
+        volatile s32 numControls_;
+        u16* playing_; ///< indices of playing players
+        s32 numPlaying_;
+        s32 numScheduled_;
+        u16* schedule_; ///< indices of players
 
-        lcore::CriticalSection playerLock_;
         lcore::Event waitEvent_;
 
-        opus_int16 pcm_[BufferNumSamples];
+        s32 bufferFrames_;
+        s32 maxBufferFrames_;
+        opus_int16* pcm_;
     };
 }
 #endif //INC_LSOUND_OPENAL_CONTEXT_H__
@@ -11,41 +11,32 @@
 namespace lsound
 {
     Player::Player()
-        :userFlags_(0)
-        ,innerFlags_(0)
+        :table_(NULL)
+        ,index_(0)
+        ,generation_(1)
+        ,next_(-1)
+        ,slot_(-1)
         ,source_(0)
         ,numBuffers_(0)
-        ,stream_(NULL)
+        ,buffers_(NULL)
+        ,block_(-1)
+        ,bufferFrames_(0)
         ,userPlayer_(NULL)
     {
-        for(s32 i=0; i<NumMaxBuffers; ++i){
-            buffers_[i] = 0;
-        }
     }
 
     Player::~Player()
     {
-        if(0 != source_){
-            clear();
-            alDeleteSources(1, &source_);
-            source_ = 0;
-        }
-        if(0<numBuffers_){
-            alDeleteBuffers(numBuffers_, buffers_);
-            for(s32 i=0; i<NumMaxBuffers; ++i){
-                buffers_[i] = 0;
-            }
-        }
+        destroy();
     }
 
     u16 Player::getUserFlags()
     {
         if(NULL == userPlayer_){
-            return userFlags_;
+            return table_->userFlags_[index_];
         }
 
-        lcore::CSLock lock(userPlayer_->lock_);
-        return userPlayer_->flags_;
+        return static_cast<u16>(userPlayer_->flags_);
     }
 
     void Player::clear()
@@ -55,6 +46,8 @@ namespace lsound
         s32 processed = getProcessed();
         LSuint bufids[NumMaxBuffers];
         unqueueBuffers(processed, bufids);
+        //Buffers go back to the pool
+        alSourcei(source_, AL_BUFFER, 0);
         setPitch(1.0f);
     }
 
@@ -63,11 +56,22 @@ namespace lsound
         LASSERT(0<numBuffers && numBuffers<=NumMaxBuffers);
 
         alGenSources(1, &source_);
+        if(0 == source_){
+            return false;
+        }
         numBuffers_ = numBuffers;
-        alGenBuffers(numBuffers_, buffers_);
         return true;
     }
 
+    void Player::destroy()
+    {
+        if(0 != source_){
+            clear();
+            alDeleteSources(1, &source_);
+            source_ = 0;
+        }
+    }
+
     void Player::update(s32 index, LSuint sampleRate, LSenum internalFormat, LSsizei samples, LSenum channels, LSenum type, const LSvoid* data)
     {
         LASSERT(0<=index && index<numBuffers_);
@@ -6,79 +6,14 @@
 @date 2014/07/08 create
 */
 #include "../lsound.h"
+#include "../VoiceTable.h"
 
 namespace lsound
 {
     class Stream;
-    class Player;
     class UserPlayer;
 
-    class PlayerLink
-    {
-    public:
-        PlayerLink()
-            :prev_(this)
-            ,next_(this)
-        {}
-
-        ~PlayerLink()
-        {}
-
-        inline void resetLink();
-        inline void unlink();
-        inline void link(PlayerLink* node);
-
-        inline Player* getPrev();
-        inline void setPrev(PlayerLink* prev);
-
-        inline Player* getNext();
-        inline void setNext(PlayerLink* next);
-
-    protected:
-        PlayerLink* prev_;
-        PlayerLink* next_;
-    };
-
-    inline void PlayerLink::resetLink()
-    {
-        prev_ = next_ = this;
-    }
-
-    inline void PlayerLink::unlink()
-    {
-        next_->prev_ = prev_;
-        prev_->next_ = next_;
-        prev_ = next_ = this;
-    }
-
-    inline void PlayerLink::link(PlayerLink* node)
-    {
-        prev_ = node->prev_;
-        next_ = node;
-        prev_->next_ = node->prev_ = this;
-    }
-
-    inline Player* PlayerLink::getPrev()
-    {
-        return reinterpret_cast<Player*>(prev_);
-    }
-
-    inline void PlayerLink::setPrev(PlayerLink* prev)
-    {
-        prev_ = prev;
-    }
-
-    inline Player* PlayerLink::getNext()
-    {
-        return reinterpret_cast<Player*>(next_);
-    }
-
-    inline void PlayerLink::setNext(PlayerLink* next)
-    {
-        next_ = next;
-    }
-
-    class Player : public PlayerLink
+    class Player
     {
     public:
         static const s16 NumMaxBuffers = lsound::NumMaxBuffers;
@@ -86,10 +21,13 @@ namespace lsound
         enum InnerFlag
         {
             InnerFlag_UserPlayer = (0x01U<<0),
+            InnerFlag_Stop = (0x01U<<1), ///< stopped by the user, released at its next schedule
+            InnerFlag_Open = (0x01U<<2), ///< the stream is opened when the context takes the request
         };
 
         ~Player();
         
+        inline Handle getHandle() const;
         u16 getUserFlags();
 
         inline bool checkUserFlag(PlayerFlag flag) const;
@@ -111,6 +49,7 @@ namespace lsound
         inline s32 getQueued();
         inline s32 getProcessed();
         inline u32 getSampleOffset();
+        inline f32 getPitch();
 
         inline void setPosition(f32 x, f32 y, f32 z);
         inline void setGain(f32 gain);
@@ -127,50 +66,61 @@ namespace lsound
         Player& operator=(const Player&);
 
         inline void setStream(Stream* stream);
+        inline void setBufferFrames(s32 frames);
 
         Player();
         bool create(s8 numBuffers);
+        void destroy();
 
         inline void queueBuffers(s32 numBuffers, ALuint* buffers);
         inline void unqueueBuffers(s32 numBuffers, ALuint* buffers);
 
-        u16 userFlags_;
-        u16 innerFlags_;
+        VoiceTable* table_; ///< flags, stream and deadline are in the context's table
+        u16 index_;
+        volatile u16 generation_; ///< incremented when released
+        s32 next_; ///< index of the next request
+        s32 slot_; ///< position in the play table
         LSuint source_;
         s32 numBuffers_;
-        LSuint buffers_[NumMaxBuffers];
-        Stream* stream_;
+        LSuint* buffers_; ///< names in a block of the context's buffer pool, NULL while released
+        s32 block_;
+        s32 bufferFrames_; //frames a queued buffer is filled with
         UserPlayer* userPlayer_;
     };
 
+    inline Handle Player::getHandle() const
+    {
+        return makeHandle(index_, generation_);
+    }
+
     inline bool Player::checkUserFlag(PlayerFlag flag) const
     {
-        return 0 != (userFlags_ & flag);
+        return 0 != (table_->userFlags_[index_] & flag);
     }
 
     inline void Player::setUserFlag(PlayerFlag flag)
     {
-        userFlags_ |= flag;
+        table_->userFlags_[index_] |= flag;
     }
 
     inline void Player::resetUserFlag(PlayerFlag flag)
     {
-        userFlags_ &= ~flag;
+        table_->userFlags_[index_] &= ~flag;
     }
 
     inline bool Player::checkInnerFlag(InnerFlag flag) const
     {
-        return 0 != (innerFlags_ & flag);
+        return 0 != (table_->innerFlags_[index_] & flag);
     }
 
     inline void Player::setInnerFlag(InnerFlag flag)
     {
-        innerFlags_ |= flag;
+        table_->innerFlags_[index_] |= flag;
     }
 
     inline void Player::resetInnerFlag(InnerFlag flag)
     {
-        innerFlags_ &= ~flag;
+        table_->innerFlags_[index_] &= ~flag;
     }
 
     inline void Player::rewind()
@@ -221,6 +171,13 @@ namespace lsound
         return static_cast<u32>(samples);
     }
 
+    inline f32 Player::getPitch()
+    {
+        f32 pitch = 1.0f;
+        alGetSourcef(source_, AL_PITCH, &pitch);
+        return pitch;
+    }
+
     inline void Player::setPosition(f32 x, f32 y, f32 z)
     {
         alSource3f(source_, AL_POSITION, x, y, z);
@@ -246,6 +203,11 @@ namespace lsound
         alSourcei(source_, AL_ROLLOFF_FACTOR, rolloff);
     }
 
+    inline void Player::setBufferFrames(s32 frames)
+    {
+        bufferFrames_ = frames;
+    }
+
     inline void Player::queueBuffers(s32 numBuffers, ALuint* buffers)
     {
         LASSERT(NULL != buffers);
@@ -260,7 +222,7 @@ namespace lsound
 
     inline void Player::setStream(Stream* stream)
     {
-        stream_ = stream;
+        table_->streams_[index_] = stream;
     }
 
     inline s32 Player::getNumBuffers() const
@@ -5,62 +5,110 @@
 */
 #include "UserPlayer.h"
 #include "Player.h"
+#include "Context.h"
 
 namespace lsound
 {
     UserPlayer::UserPlayer()
-        :flags_(0)
+        :generation_(1)
     {
-        impl_.player_ = NULL;
+        reset();
     }
 
     UserPlayer::~UserPlayer()
     {
     }
 
+    void UserPlayer::reset()
+    {
+        refCount_ = 1;
+        flags_ = 0;
+        controls_ = 0;
+        request_ = Request_None;
+        gain_ = 1.0f;
+        pitch_ = 1.0f;
+        sequence_ = 0;
+        for(s32 i=0; i<2; ++i){
+            snapshots_[i].state_ = State_Initial;
+            snapshots_[i].position_ = 0;
+            snapshots_[i].queuedDuration_ = 0.0f;
+        }
+    }
+
     bool UserPlayer::checkFlag(PlayerFlag flag)
     {
-        lcore::CSLock lock(lock_);
         return 0 != (flags_ & flag);
     }
 
     void UserPlayer::setFlag(PlayerFlag flag)
     {
-        lcore::CSLock lock(lock_);
-        flags_ |= flag;
+        lcore::atomicOr(&flags_, flag);
     }
 
     void UserPlayer::resetFlag(PlayerFlag flag)
     {
-        lcore::CSLock lock(lock_);
-        flags_ &= ~flag;
+        lcore::atomicAnd(&flags_, ~static_cast<s32>(flag));
     }
 
     void UserPlayer::play()
     {
-        LASSERT(NULL != impl_.player_);
-        impl_.player_->play();
+        lcore::atomicExchange(&request_, Request_Play);
+        Context::getInstance().addControl();
     }
 
     void UserPlayer::pause()
     {
-        LASSERT(NULL != impl_.player_);
-        impl_.player_->pause();
+        lcore::atomicExchange(&request_, Request_Pause);
+        Context::getInstance().addControl();
     }
 
     State UserPlayer::getState()
     {
-        LASSERT(NULL != impl_.player_);
-        return impl_.player_->getState();
+        Snapshot snapshot;
+        getSnapshot(snapshot);
+        return static_cast<State>(snapshot.state_);
+    }
+
+    void UserPlayer::getSnapshot(Snapshot& snapshot)
+    {
+        for(;;){
+            u32 sequence = sequence_ & ~0x01U;
+            lcore::memoryBarrier();
+            snapshot = snapshots_[(sequence>>1) & 0x01U];
+            lcore::memoryBarrier();
+            //The front one is rewritten from the second publish after
+            if((sequence_-sequence)<=2){
+                return;
+            }
+        }
     }
 
     void UserPlayer::setGain(f32 gain)
     {
-        impl_.player_->setGain(gain);
+        gain_ = gain;
+        lcore::atomicOr(&controls_, Control_Gain);
+        Context::getInstance().addControl();
     }
 
     void UserPlayer::setPitch(f32 pitch)
     {
-        impl_.player_->setPitch(pitch);
+        pitch_ = pitch;
+        lcore::atomicOr(&controls_, Control_Pitch);
+        Context::getInstance().addControl();
+    }
+
+    void UserPlayer::publish(s32 state, u32 position, f32 queuedDuration)
+    {
+        u32 sequence = sequence_;
+        sequence_ = sequence + 1;
+        lcore::memoryBarrier();
+
+        Snapshot& back = snapshots_[((sequence>>1)+1) & 0x01U];
+        back.state_ = state;
+        back.position_ = position;
+        back.queuedDuration_ = queuedDuration;
+
+        lcore::memoryBarrier();
+        sequence_ = sequence + 2;
     }
 }
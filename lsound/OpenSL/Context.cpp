@@ -227,21 +227,17 @@ namespace
         ,canRun_(false)
         ,systemPaused_(false)
         ,waitTime_(0)
-        ,numStreams_(0)
-        ,streamTop_(NULL)
+        ,streamSize_(0)
         ,streams_(NULL)
-        ,numPlayers_(0)
         ,players_(NULL)
-        ,numUserPlayers_(0)
-        ,userPlayerTop_(NULL)
         ,userPlayers_(NULL)
         ,numRequests_(0)
-        ,requestList_(NULL)
+        ,requestList_(-1)
+        ,numControls_(0)
+        ,playing_(NULL)
+        ,numPlaying_(0)
         //,waitEvent_(false, false)
     {
-        playerTop_.resetLink();
-        playList_.resetLink();
-
         for(s32 i=0; i<NumMaxPacks; ++i){
             packResources_[i] = NULL;
         }
@@ -263,10 +259,14 @@ namespace
         }
 
         LIME_DELETE_ARRAY(userPlayers_);
+        LIME_DELETE_ARRAY(playing_);
+        playerPool_.destroy();
         LIME_DELETE_ARRAY(players_);
-        
-        u8* streams = reinterpret_cast<u8*>(streams_);
-        LIME_FREE(streams);
+        lcore::Log("buffer blocks high watermark %d/%d", bufferPool_.getHighWatermark(), bufferPool_.getCapacity());
+        bufferPool_.destroy();
+
+        streamPool_.destroy();
+        LIME_DELETE_ARRAY(streams_);
 
         destroy();
     }
@@ -327,9 +327,9 @@ namespace
 
     void Context::updateRequests()
     {
-        if(numRequests_){
+        s32 numRequests = lcore::atomicExchange(&numRequests_, 0);
+        if(0<numRequests || 0<numControls_){
             waitEvent_.set();
-            numRequests_ = 0;
         }
     }
 
@@ -352,63 +352,139 @@ namespace
             if(!canRun){
                 break;
             }
+
+            //Audio players and stream slots are made and released here, not in play
+            playerPool_.update(initParam_.poolTrimDelay_);
+            streamPool_.update(initParam_.poolTrimDelay_);
            // LSOUND_DECL_START;
 
             //VKNGXg
-            csContext_.enter();
-            Player* requestList = getRequestList();
-            csContext_.leave();
-            while(NULL != requestList){
+            s32 index = getRequestList();
+            while(0<=index){
                 //LSOUND_DECL_START;
-                Player* request = requestList;
-                requestList = requestList->getNext();
-                request->resetLink();
+                Player* request = &players_[index];
+                index = request->next_;
+                //Opening parses headers and reads files, so it is not done by the caller of play
+                if(!openStream(request)){
+                    releasePlayer(request);
+                    continue;
+                }
                 request->initialize();
-                request->link(&playList_);
+                addPlaying(request);
+                if(NULL != request->userPlayer_){
+                    applyUserControls(request);
+                }
                 //LSOUND_DECL_STOP("initial:%f\n");
             }
 
-            Player* player;
+            if(0<numControls_ && 0<lcore::atomicExchange(&numControls_, 0)){
+                applyUserControls();
+            }
 
             if(systemPaused != prevSystemPaused){
                 prevSystemPaused = systemPaused;
-                player = playList_.getNext();
-                while(player != &playList_){
-                    player->systemPause(systemPaused);
-                    player = player->getNext();
+                for(s32 i=0; i<numPlaying_; ++i){
+                    players_[playing_[i]].systemPause(systemPaused);
                 }
             }
 
-            player = playList_.getNext();
-            Player* endList = NULL;
-            while(player != &playList_){
+            //INGXg
+            for(s32 i=0; i<numPlaying_;){
                 //LSOUND_DECL_START
 
-                Player* current = player;
-                player = player->getNext();
-
+                Player* current = &players_[playing_[i]];
                 //State state = current->getState();
                 //if(State_Playing != state && State_Paused != state){
-                if(!current->update()){
+                if(current->checkInnerFlag(Player::InnerFlag_Stop) || !current->update()){
+                    //The last one moves to this slot
                     current->clear();
-                    current->unlink();
-                    current->setNext(endList);
-                    endList = current;
+                    removePlaying(current);
+                    releasePlayer(current);
+                    continue;
                 }
+                if(NULL != current->userPlayer_){
+                    publish(current, current->getState());
+                }
+                ++i;
             }
 
-            //INGXg
-            csContext_.enter();
-            while(NULL != endList){
-                Player* current = endList;
-                endList = endList->getNext();
-                current->resetLink();
-                releasePlayer(current);
+            //LSOUND_DECL_STOP("update:%f\n");
+        }
+    }
+
+    void Context::addControl()
+    {
+        lcore::atomicIncrement(&numControls_);
+    }
+
+    void Context::applyUserControls()
+    {
+        for(s32 i=0; i<numPlaying_; ++i){
+            Player* player = &players_[playing_[i]];
+            if(NULL != player->userPlayer_){
+                applyUserControls(player);
             }
-            csContext_.leave();
+        }
+    }
 
-            //LSOUND_DECL_STOP("update:%f\n");
+    void Context::applyUserControls(Player* player)
+    {
+        UserPlayer* userPlayer = player->userPlayer_;
+        s32 controls = userPlayer->takeControls();
+        if(controls & UserPlayer::Control_Gain){
+            player->setGain(userPlayer->gain_);
+        }
+        if(controls & UserPlayer::Control_Pitch){
+            player->setPitch(userPlayer->pitch_);
+        }
+
+        switch(userPlayer->takeRequest())
+        {
+        case UserPlayer::Request_Play:
+            player->play();
+            break;
+        case UserPlayer::Request_Pause:
+            player->pause();
+            break;
+        case UserPlayer::Request_Stop:
+            //Released at the next update
+            player->stop();
+            player->setInnerFlag(Player::InnerFlag_Stop);
+            break;
+        default:
+            break;
         }
+        publish(player, player->getState());
+    }
+
+    void Context::publish(Player* player, State state)
+    {
+        //Approximated as every queued buffer is full
+        s32 queuedFrames = (player->getQueued() + player->numQueuedBuffers_)*BufferNumSamplesPerChannel;
+        opus_int64 position = voices_.streams_[player->index_]->getPosition() - queuedFrames;
+        voices_.positions_[player->index_] = (position<0)? 0 : static_cast<u32>(position);
+        player->userPlayer_->publish(
+            state,
+            voices_.positions_[player->index_],
+            static_cast<f32>(queuedFrames)/SampleRate_48000);
+    }
+
+    void Context::addPlaying(Player* player)
+    {
+        player->slot_ = numPlaying_;
+        playing_[numPlaying_] = player->index_;
+        ++numPlaying_;
+    }
+
+    void Context::removePlaying(Player* player)
+    {
+        LASSERT(0<=player->slot_ && player->slot_<numPlaying_);
+        //Move the last one to the hole
+        --numPlaying_;
+        Player& last = players_[playing_[numPlaying_]];
+        playing_[player->slot_] = last.index_;
+        last.slot_ = player->slot_;
+        player->slot_ = -1;
     }
 
     s32 Context::loadResourcePack(s32 id, const Char* path, bool stream)
@@ -417,7 +493,7 @@ namespace
 
         PackResource* packResource = NULL;
         if(stream){
-            packResource = PackFile::open(path);
+            packResource = PackFile::open(path, initParam_.readBlockSize_, initParam_.numReadBlocks_);
         }else{
             packResource = PackMemory::open(path);
         }
@@ -431,6 +507,20 @@ namespace
         return id;
     }
 
+    s32 Context::mapResourcePack(s32 id, const Char* path)
+    {
+        LASSERT(0<=id && id<NumMaxPacks);
+
+        PackResource* packResource = PackMapped::open(path);
+        if(NULL == packResource){
+            return -1;
+        }
+
+        LIME_DELETE(packResources_[id]);
+        packResources_[id] = packResource;
+        return id;
+    }
+
 #ifdef ANDROID
     s32 Context::loadResourcePackFromAsset(AAssetManager* assetManager, s32 id, const Char* path, s32 stream)
     {
@@ -453,268 +543,138 @@ namespace
     }
 #endif
 
-    bool Context::play(s32 packId, s32 id, f32 gain)
+    Handle Context::play(s32 packId, s32 id, f32 gain)
     {
         LASSERT(0<=packId && packId<NumMaxPacks);
         LASSERT(0<=id);
 
         PackResource* packResource = packResources_[packId];
         if(NULL == packResource){
-            return false;
+            return InvalidHandle;
         }
         if(packResource->getNumFiles()<=id){
-            return false;
+            return InvalidHandle;
         }
 
-        Player* player;
-        StreamEntry* streamEntry;
-        {
-            lcore::CSLock lock(csContext_);
-            if(numPlayers_<=0){
-                return false;
-            }
-            player = getPlayer();
-
-            if(NULL == streamTop_){
-                releasePlayer(player);
-                return false;
-            }
-            streamEntry = getStream();
+        Player* player = getPlayer();
+        if(NULL == player){
+            return InvalidHandle;
         }
-
-        Stream* stream;
-        switch(packResource->getType())
-        {
-        case PackResource::ResourceType_File:
-            {
-
-                FileStream* fileStream = LIME_PLACEMENT_NEW(streamEntry) FileStream();
-                PackFile* packFile = reinterpret_cast<PackFile*>(packResource);
-                File* file;
-                s32 start, end;
-                packFile->get(id, file, start, end);
-                fileStream->set(file, start, end);
-                stream = fileStream;
-            }
-            break;
-
-        case PackResource::ResourceType_Memory:
-            {
-                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry) MemoryStream();
-                PackMemory* packMemory = reinterpret_cast<PackMemory*>(packResource);
-                Memory* memory;
-                u32 size;
-                s32 offset;
-                packMemory->get(id, memory, size, offset);
-                memoryStream->set(size, offset, memory);
-                stream = memoryStream;
-            }
-            break;
-
-        case PackResource::ResourceType_Asset:
-            {
-                AssetStream* assetStream = LIME_PLACEMENT_NEW(streamEntry) AssetStream();
-                PackAsset* packAsset = reinterpret_cast<PackAsset*>(packResource);
-                Asset* asset;
-                s32 start, end;
-                packAsset->get(id, asset, start, end);
-                assetStream->set(asset, start, end);
-                stream = assetStream;
-            }
-            break;
-
-        default:
-            {
-                lcore::CSLock lock(csContext_);
-                releasePlayer(player);
-                releaseStream((Stream*)streamEntry);
-            }
-            return false;
+        StreamEntry* streamEntry = getStream();
+        if(NULL == streamEntry){
+            releasePlayer(player);
+            return InvalidHandle;
         }
 
-        if(!stream->open() || stream->getTotal()<=0){
-            lcore::CSLock lock(csContext_);
+        Stream* stream = createStream(streamEntry, packResource, id);
+        if(NULL == stream){
             releasePlayer(player);
-            releaseStream(stream);
-            return false;
+            return InvalidHandle;
         }
+        player->rewind();
         player->setStream(stream);
+        player->setInnerFlag(Player::InnerFlag_Open);
         player->setGain(gain);
-        player->rewind();
 
-        {
-            lcore::CSLock lock(csContext_);
-            player->setNext(requestList_);
-            requestList_ = player;
-        }
-        ++numRequests_;
-        return true;
+        Handle handle = player->getHandle();
+        addRequest(player);
+        return handle;
     }
 
-    UserPlayer* Context::createUserPlayer(s32 packId, s32 id)
+    Handle Context::createUserPlayer(s32 packId, s32 id)
     {
         LASSERT(0<=packId && packId<NumMaxPacks);
         LASSERT(0<=id);
 
         PackResource* packResource = packResources_[packId];
         if(NULL == packResource){
-            return NULL;
+            return InvalidHandle;
         }
         if(packResource->getNumFiles()<=id){
-            return NULL;
+            return InvalidHandle;
         }
 
-        UserPlayer* userPlayer;
-        Player* player;
-        StreamEntry* streamEntry;
-        {
-            if(numUserPlayers_<=0){
-                return NULL;
-            }
-
-            userPlayer = getUserPlayer();
-
-            lcore::CSLock lock(csContext_);
-            if(numPlayers_<=0){
-                releaseUserPlayer(userPlayer);
-                return NULL;
-            }
-            player = getPlayer();
-
-            if(NULL == streamTop_){
-                releaseUserPlayer(userPlayer);
-                releasePlayer(player);
-                return NULL;
-            }
-            streamEntry = getStream();
+        UserPlayer* userPlayer = getUserPlayer();
+        if(NULL == userPlayer){
+            return InvalidHandle;
         }
-
-        Stream* stream;
-        switch(packResource->getType())
-        {
-        case PackResource::ResourceType_File:
-            {
-
-                FileStream* fileStream = LIME_PLACEMENT_NEW(streamEntry) FileStream();
-                PackFile* packFile = reinterpret_cast<PackFile*>(packResource);
-                File* file;
-                s32 start, end;
-                packFile->get(id, file, start, end);
-                fileStream->set(file, start, end);
-                stream = fileStream;
-            }
-            break;
-
-        case PackResource::ResourceType_Memory:
-            {
-                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry) MemoryStream();
-                PackMemory* packMemory = reinterpret_cast<PackMemory*>(packResource);
-                Memory* memory;
-                u32 size;
-                s32 offset;
-                packMemory->get(id, memory, size, offset);
-                memoryStream->set(size, offset, memory);
-                stream = memoryStream;
-            }
-            break;
-
-        case PackResource::ResourceType_Asset:
-            {
-                AssetStream* assetStream = LIME_PLACEMENT_NEW(streamEntry) AssetStream();
-                PackAsset* packAsset = reinterpret_cast<PackAsset*>(packResource);
-                Asset* asset;
-                s32 start, end;
-                packAsset->get(id, asset, start, end);
-                assetStream->set(asset, start, end);
-                stream = assetStream;
-            }
-            break;
-
-        default:
-            {
-                lcore::CSLock lock(csContext_);
-                releaseUserPlayer(userPlayer);
-                releasePlayer(player);
-                releaseStream((Stream*)streamEntry);
-            }
-            return NULL;
+        Player* player = getPlayer();
+        if(NULL == player){
+            releaseUserPlayer(userPlayer);
+            return InvalidHandle;
+        }
+        StreamEntry* streamEntry = getStream();
+        if(NULL == streamEntry){
+            releaseUserPlayer(userPlayer);
+            releasePlayer(player);
+            return InvalidHandle;
         }
 
-        if(!stream->open() || stream->getTotal()<=0){
-            lcore::CSLock lock(csContext_);
+        Stream* stream = createStream(streamEntry, packResource, id);
+        if(NULL == stream){
             releaseUserPlayer(userPlayer);
             releasePlayer(player);
-            releaseStream(stream);
-            return NULL;
+            return InvalidHandle;
         }
+        player->rewind();
         player->setStream(stream);
+        player->setInnerFlag(Player::InnerFlag_Open);
         player->setGain(1.0f);
         player->setInnerFlag(Player::InnerFlag_UserPlayer);
-        
-        player->rewind();
         player->userPlayer_ = userPlayer;
-        userPlayer->impl_.player_ = player;
-        userPlayer->initialized_ = 0;
-        userPlayer->state_ = State_Initial;
+        //Released by the caller and the player each
+        lcore::atomicIncrement(&userPlayer->refCount_);
 
-        {
-            lcore::CSLock lock(csContext_);
-            player->setNext(requestList_);
-            requestList_ = player;
-        }
-        ++numRequests_;
-        return userPlayer;
+        Handle handle = makeHandle(static_cast<s32>(userPlayer - userPlayers_), static_cast<u16>(userPlayer->generation_));
+        addRequest(player);
+        return handle;
     }
 
-    void Context::destroyUserPlayer(UserPlayer* player)
+    void Context::destroyUserPlayer(Handle handle)
     {
+        UserPlayer* player = findUserPlayer(handle);
         if(NULL == player){
             return;
         }
-        player->impl_.player_->stop();
+        //Reject the handle from now, only the caller retiring its generation releases the reference.
+        //The slot is reused after the player releases it too
+        s32 generation = getHandleGeneration(handle);
+        if(generation != lcore::atomicCompareExchange(&player->generation_, nextGeneration(static_cast<u16>(generation)), generation)){
+            return;
+        }
+        //The player stops at the next update, then releases its reference
+        lcore::atomicExchange(&player->request_, UserPlayer::Request_Stop);
+        addControl();
         releaseUserPlayer(player);
     }
 
-    void Context::clear()
+    bool Context::openStream(Player* player)
     {
-        Player* endList = NULL;
-
-        Player* player = playList_.getNext();
-        while(player != &playList_){
-            Player* current = player;
-            player = player->getNext();
-
-            current->clear();
-            current->unlink();
-            current->setNext(endList);
-            endList = current;
-        }
-
-        //INGXgAVKNGXg
-        Player* requestList = NULL;
-        {
-            lcore::CSLock lock(csContext_);
-            requestList = getRequestList();
+        if(!player->checkInnerFlag(Player::InnerFlag_Open)){
+            return true;
         }
+        player->resetInnerFlag(Player::InnerFlag_Open);
+        Stream* stream = voices_.streams_[player->index_];
+        return stream->open() && 0<stream->getTotal();
+    }
 
-        while(NULL != requestList){
-            Player* request = requestList;
-            requestList = requestList->getNext();
-            request->resetLink();
-
-            request->clear();
-            request->setNext(endList);
-            endList = request;
+    void Context::clear()
+    {
+        for(s32 i=0; i<numPlaying_; ++i){
+            Player* current = &players_[playing_[i]];
+            current->clear();
+            current->slot_ = -1;
+            releasePlayer(current);
         }
+        numPlaying_ = 0;
 
-        {
-            lcore::CSLock lock(csContext_);
-            while(NULL != endList){
-                Player* current = endList;
-                endList = endList->getNext();
-                current->resetLink();
-                releasePlayer(current);
-            }
+        //VKNGXg
+        s32 request = getRequestList();
+        while(0<=request){
+            Player* current = &players_[request];
+            request = current->next_;
+            current->clear();
+            releasePlayer(current);
         }
     }
 
@@ -731,28 +691,141 @@ namespace
     void Context::initStreams()
     {
         LASSERT(NULL == streams_);
-        numStreams_ = initParam_.maxPlayers_;
-        u32 elemSize = lcore::maximum(sizeof(FileStream), sizeof(MemoryStream));
-        elemSize = lcore::maximum(elemSize, sizeof(AssetStream));
-        u8* buffer = (u8*)LIME_MALLOC(elemSize * initParam_.maxPlayers_);
-
-        StreamEntry* entry;
-        for(s32 i=0; i<(initParam_.maxPlayers_-1); ++i){
-            entry = reinterpret_cast<StreamEntry*>(buffer + i*elemSize);
-            entry->next_ = reinterpret_cast<StreamEntry*>(buffer + (i+1)*elemSize);
+        streamSize_ = lcore::maximum(sizeof(FileStream), sizeof(MemoryStream));
+        streamSize_ = lcore::maximum(streamSize_, sizeof(AssetStream));
+        streams_ = LIME_NEW StreamEntry*[initParam_.maxPlayers_];
+        for(s32 i=0; i<initParam_.maxPlayers_; ++i){
+            streams_[i] = NULL;
         }
-        entry = reinterpret_cast<StreamEntry*>(buffer + (initParam_.maxPlayers_-1)*elemSize);
-        entry->next_ = NULL;
-
-        streamTop_ = reinterpret_cast<StreamEntry*>(buffer);
-        streams_ = reinterpret_cast<StreamEntry*>(buffer);
+        streamPool_.create(initParam_.maxPlayers_, initParam_.poolChunkSize_, createStreamProc, destroyStreamProc, this);
     }
 
     void Context::initPlayers()
     {
         LASSERT(NULL == players_);
         players_ = LIME_NEW Player[initParam_.maxPlayers_];
-        numPlayers_ = 0;
+        voices_.create(initParam_.maxPlayers_);
+        playing_ = LIME_NEW u16[initParam_.maxPlayers_];
+        for(s32 i=0; i<initParam_.maxPlayers_; ++i){
+            players_[i].table_ = &voices_;
+            players_[i].index_ = static_cast<u16>(i);
+        }
+        playerPool_.create(initParam_.maxPlayers_, initParam_.poolChunkSize_, createPlayerProc, destroyPlayerProc, this);
+
+        s32 numBlocks = (0<initParam_.maxPlayingVoices_)? lcore::minimum(initParam_.maxPlayingVoices_, initParam_.maxPlayers_) : initParam_.maxPlayers_;
+        bufferPool_.create(sizeof(SampleType)*BufferNumSamples*NumMaxBuffers, numBlocks);
+    }
+
+    void Context::initUserPlayers()
+    {
+        LASSERT(NULL == userPlayers_);
+        userPlayers_ = LIME_NEW UserPlayer[initParam_.maxUserPlayers_];
+        freeUserPlayers_.initialize(initParam_.maxUserPlayers_);
+    }
+
+    bool Context::createStreamProc(s32 index, void* data)
+    {
+        Context* context = reinterpret_cast<Context*>(data);
+        void* memory = LIME_MALLOC(sizeof(StreamEntry) + context->streamSize_);
+        if(NULL == memory){
+            return false;
+        }
+        StreamEntry* entry = reinterpret_cast<StreamEntry*>(memory);
+        entry->index_ = index;
+        context->streams_[index] = entry;
+        return true;
+    }
+
+    void Context::destroyStreamProc(s32 index, void* data)
+    {
+        Context* context = reinterpret_cast<Context*>(data);
+        LIME_FREE(context->streams_[index]);
+    }
+
+    Context::StreamEntry* Context::getStream()
+    {
+        s32 index = streamPool_.pop();
+        return (index<0)? NULL : streams_[index];
+    }
+
+    void Context::releaseStream(Stream* stream)
+    {
+        LASSERT(NULL != stream);
+        stream->~Stream();
+        StreamEntry* entry = reinterpret_cast<StreamEntry*>(stream) - 1;
+        streamPool_.push(entry->index_);
+    }
+
+    Stream* Context::createStream(StreamEntry* streamEntry, PackResource* packResource, s32 id)
+    {
+        Stream* stream;
+        switch(packResource->getType())
+        {
+        case PackResource::ResourceType_File:
+            {
+                FileStream* fileStream = LIME_PLACEMENT_NEW(streamEntry+1) FileStream();
+                PackFile* packFile = reinterpret_cast<PackFile*>(packResource);
+                File* file;
+                s32 start, end;
+                packFile->get(id, file, start, end);
+                fileStream->set(file, start, end);
+                packResource->setStreamInfo(id, *fileStream);
+                stream = fileStream;
+            }
+            break;
+
+        case PackResource::ResourceType_Memory:
+            {
+                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry+1) MemoryStream();
+                PackMemory* packMemory = reinterpret_cast<PackMemory*>(packResource);
+                Memory* memory;
+                u32 size;
+                s32 offset;
+                packMemory->get(id, memory, size, offset);
+                memoryStream->set(size, offset, memory);
+                packResource->setStreamInfo(id, *memoryStream);
+                stream = memoryStream;
+            }
+            break;
+
+        case PackResource::ResourceType_Mapped:
+            {
+                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry+1) MemoryStream();
+                PackMapped* packMapped = reinterpret_cast<PackMapped*>(packResource);
+                Memory* memory;
+                u32 size;
+                s32 offset;
+                packMapped->get(id, memory, size, offset);
+                packMapped->prefetch(id);
+                memoryStream->set(size, offset, memory);
+                packResource->setStreamInfo(id, *memoryStream);
+                stream = memoryStream;
+            }
+            break;
+
+        case PackResource::ResourceType_Asset:
+            {
+                AssetStream* assetStream = LIME_PLACEMENT_NEW(streamEntry+1) AssetStream();
+                PackAsset* packAsset = reinterpret_cast<PackAsset*>(packResource);
+                Asset* asset;
+                s32 start, end;
+                packAsset->get(id, asset, start, end);
+                assetStream->set(asset, start, end);
+                packResource->setStreamInfo(id, *assetStream);
+                stream = assetStream;
+            }
+            break;
+
+        default:
+            streamPool_.push(streamEntry->index_);
+            return NULL;
+        }
+        return stream;
+    }
+
+    bool Context::createPlayerProc(s32 index, void* data)
+    {
+        Context* context = reinterpret_cast<Context*>(data);
 
         SLDataLocator_BufferQueue bufferQueue;
         SLDataFormat_PCM pcmFormat;
@@ -775,7 +848,7 @@ namespace
         dataSource.pLocator = &bufferQueue;
 
         outputMix.locatorType = SL_DATALOCATOR_OUTPUTMIX;
-        outputMix.outputMix = outputMixObject_;
+        outputMix.outputMix = context->outputMixObject_;
         dataSink.pFormat = NULL;
         dataSink.pLocator = &outputMix;
 
@@ -791,135 +864,131 @@ namespace
             SL_BOOLEAN_FALSE,
         };
 
-        SLresult result = 0;
-        SLObjectItf outputMixObj = NULL;
         SLObjectItf playerObj = NULL;
-        for(s32 i=initParam_.maxPlayers_-1; 0<=i; --i){
-            //OutputMix
-            //result = engine_.CreateOutputMix(&outputMixObj, 0, NULL, NULL);
-            //if(result != SL_RESULT_SUCCESS){
-            //    lcore::Log("error: CreateOutputMix");
-            //    break;
-            //}
-            //result = (*outputMixObj)->Realize(outputMixObj, SL_BOOLEAN_FALSE);
-            //if(result != SL_RESULT_SUCCESS){
-            //    lcore::Log("error: OutputMixObj::Realize");
-            //    break;
-            //}
-
-            //result = instance_->outputMixObject_.Realize(SL_BOOLEAN_FALSE);
-            //if(result != SL_RESULT_SUCCESS){
-            //    lcore::Log("error: Realize");
-            //    LIME_DELETE(instance_);
-            //    return false;
-            //}
-
-            //Player
-            result = engine_.CreateAudioPlayer(
-                &playerObj,
-                &dataSource,
-                &dataSink,
-                2,
-                playInterfaceIDs,
-                playRequired);
-            if(result != SL_RESULT_SUCCESS){
-                lcore::Log("error: CreateAudioPlayer %d", result);
-                break;
-            }
-
-            if(!players_[i].create(initParam_.numQueuedBuffers_, playerObj)){
-                break;
-            }
-            players_[i].link(playerTop_.getNext());
-            ++numPlayers_;
-        }
-        lcore::Log("num created voices %d", numPlayers_);
-    }
-
-    void Context::initUserPlayers()
-    {
-        LASSERT(NULL == userPlayers_);
-        numUserPlayers_ = initParam_.maxUserPlayers_;
-        userPlayers_ = LIME_NEW UserPlayer[initParam_.maxUserPlayers_];
-
-        for(s32 i=0; i<(initParam_.maxUserPlayers_-1); ++i){
-            userPlayers_[i].impl_.next_ = &userPlayers_[i+1];
+        SLresult result = context->engine_.CreateAudioPlayer(
+            &playerObj,
+            &dataSource,
+            &dataSink,
+            2,
+            playInterfaceIDs,
+            playRequired);
+        if(result != SL_RESULT_SUCCESS){
+            lcore::Log("error: CreateAudioPlayer %d", result);
+            return false;
         }
-        userPlayers_[initParam_.maxUserPlayers_-1].impl_.next_ = NULL;
-        userPlayerTop_ = &userPlayers_[0];
+        return context->players_[index].create(context->initParam_.numQueuedBuffers_, playerObj);
     }
 
-    Context::StreamEntry* Context::getStream()
+    void Context::destroyPlayerProc(s32 index, void* data)
     {
-        StreamEntry* entry = streamTop_;
-        streamTop_ = streamTop_->next_;
-        --numStreams_;
-        return entry;
-    }
-
-    void Context::releaseStream(Stream* stream)
-    {
-        LASSERT(NULL != stream);
-        stream->~Stream();
-        StreamEntry* entry = reinterpret_cast<StreamEntry*>(stream);
-        entry->next_ = streamTop_;
-        streamTop_ = entry;
-        ++numStreams_;
+        Context* context = reinterpret_cast<Context*>(data);
+        context->players_[index].destroy();
     }
 
     Player* Context::getPlayer()
     {
-        Player* player = playerTop_.getNext();
-        player->unlink();
-        player->userFlags_ = 0;
-        player->innerFlags_ = 0;
+        s32 block = bufferPool_.pop();
+        if(block<0){
+            return NULL;
+        }
+        s32 index = playerPool_.pop();
+        if(index<0){
+            bufferPool_.push(block);
+            return NULL;
+        }
+        Player* player = &players_[index];
+        player->block_ = block;
+        player->buffers_ = reinterpret_cast<SampleType*>(bufferPool_.getBlock(block));
+        voices_.userFlags_[index] = 0;
+        voices_.innerFlags_[index] = 0;
         player->userPlayer_ = NULL;
-
-        --numPlayers_;
         return player;
     }
 
     void Context::releasePlayer(Player* player)
     {
         LASSERT(NULL != player);
-        //player->resetLink();
 
-        if(NULL != player->stream_){
-            releaseStream(player->stream_);
-            player->stream_ = NULL;
+        Stream*& stream = voices_.streams_[player->index_];
+        if(NULL != player->userPlayer_){
+            u32 position = (NULL != stream)? static_cast<u32>(stream->getPosition()) : 0;
+            player->userPlayer_->publish(State_Stopped, position, 0.0f);
+            releaseUserPlayer(player->userPlayer_);
+            player->userPlayer_ = NULL;
+        }
+        if(NULL != stream){
+            releaseStream(stream);
+            stream = NULL;
+        }
+        if(0<=player->block_){
+            bufferPool_.push(player->block_);
+            player->block_ = -1;
+            player->buffers_ = NULL;
         }
-        player->link(&playerTop_);
-        ++numPlayers_;
+        player->generation_ = nextGeneration(player->generation_);
+        playerPool_.push(player->index_);
     }
 
     UserPlayer* Context::getUserPlayer()
     {
-        UserPlayer* player = userPlayerTop_;
-        userPlayerTop_ = userPlayerTop_->impl_.next_;
-        player->flags_ = 0;
-        --numUserPlayers_;
+        s32 index = freeUserPlayers_.pop();
+        if(index<0){
+            return NULL;
+        }
+        UserPlayer* player = &userPlayers_[index];
+        player->reset();
         return player;
     }
 
     void Context::releaseUserPlayer(UserPlayer* player)
     {
         LASSERT(NULL != player);
-        player->impl_.next_ = userPlayerTop_;
-        userPlayerTop_ = player;
-        ++numUserPlayers_;
+        if(0 == lcore::atomicDecrement(&player->refCount_)){
+            freeUserPlayers_.push(static_cast<s32>(player - userPlayers_));
+        }
     }
 
     void Context::addRequest(Player* player)
     {
         LASSERT(NULL != player);
-        player->setNext(requestList_);
-        requestList_ = player;
+        for(;;){
+            s32 top = requestList_;
+            player->next_ = top;
+            if(top == lcore::atomicCompareExchange(&requestList_, player->index_, top)){
+                break;
+            }
+        }
+        lcore::atomicIncrement(&numRequests_);
+    }
+
+    s32 Context::getRequestList()
+    {
+        return lcore::atomicExchange(&requestList_, -1);
+    }
+
+    UserPlayer* Context::findUserPlayer(Handle handle)
+    {
+        s32 index = getHandleIndex(handle);
+        if(initParam_.maxUserPlayers_<=index){
+            return NULL;
+        }
+        UserPlayer* player = &userPlayers_[index];
+        return (getHandleGeneration(handle) == player->generation_)? player : NULL;
+    }
+
+    bool Context::isPlaying(Handle handle) const
+    {
+        s32 index = getHandleIndex(handle);
+        if(initParam_.maxPlayers_<=index){
+            return false;
+        }
+        return getHandleGeneration(handle) == players_[index].generation_;
     }
 
-    Player* Context::getRequestList()
+    void Context::getBufferUsage(s32& numUsed, s32& highWatermark, s32& capacity) const
     {
-        Player* ret = requestList_;
-        requestList_ = NULL;
-        return ret;
+        numUsed = bufferPool_.getNumUsed();
+        highWatermark = bufferPool_.getHighWatermark();
+        capacity = bufferPool_.getCapacity();
     }
 }
@@ -12,7 +12,10 @@
 
 #include <opus/opus_types.h>
 #include <lcore/async/SyncObject.h>
+#include <lcore/async/LockFree.h>
 #include "../lsound.h"
+#include "../BufferPool.h"
+#include "../SlotPool.h"
 #include "Player.h"
 
 #include "internal/SLObject.h"
@@ -40,14 +43,24 @@ namespace lsound
             InitParam()
                 :numQueuedBuffers_(2)
                 ,maxPlayers_(64)
+                ,maxPlayingVoices_(16)
                 ,maxUserPlayers_(4)
                 ,waitTime_(30)
+                ,readBlockSize_(64*1024)
+                ,numReadBlocks_(16)
+                ,poolChunkSize_(16)
+                ,poolTrimDelay_(1000)
             {}
 
             s32 numQueuedBuffers_;
             s32 maxPlayers_;
+            s32 maxPlayingVoices_; //voices holding sample buffers at once, 0 for maxPlayers_
             s32 maxUserPlayers_;
             u32 waitTime_;
+            u32 readBlockSize_; //read-ahead block of streamed packs
+            s32 numReadBlocks_; //blocks shared by streams of a pack, 0 to read directly
+            s32 poolChunkSize_; //audio players and stream slots made at once, first in initialize then by the context thread when few are free
+            s32 poolTrimDelay_; //updates of the context thread with many free ones before a chunk of them is released
         };
 
         static bool initialize(const InitParam& initParam);
@@ -62,12 +75,35 @@ namespace lsound
 
         s32 loadResourcePack(s32 id, const Char* path, bool stream);
 
+        /**
+        @brief Map a pack into memory, its entries are read on demand without copying
+        */
+        s32 mapResourcePack(s32 id, const Char* path);
+
 #ifdef ANDROID
         s32 loadResourcePackFromAsset(AAssetManager* assetManager, s32 id, const Char* path, s32 stream);
 #endif
-        bool play(s32 packId, s32 id, f32 gain=1.0f);
-        UserPlayer* createUserPlayer(s32 packId, s32 id);
-        void destroyUserPlayer(UserPlayer* player);
+        /**
+        @return handle of the voice, InvalidHandle if failed
+        */
+        Handle play(s32 packId, s32 id, f32 gain=1.0f);
+        Handle createUserPlayer(s32 packId, s32 id);
+        void destroyUserPlayer(Handle handle);
+
+        /**
+        @return NULL if the handle has been destroyed
+        */
+        UserPlayer* findUserPlayer(Handle handle);
+
+        /**
+        @brief Whether the voice has not been released yet, paused ones too
+        */
+        bool isPlaying(Handle handle) const;
+
+        /**
+        @brief Blocks of the buffer pool in use now, the most used at once, and all of them
+        */
+        void getBufferUsage(s32& numUsed, s32& highWatermark, s32& capacity) const;
 
     private:
         friend class Player;
@@ -79,9 +115,11 @@ namespace lsound
         Context(const Context&);
         Context& operator=(const Context&);
 
+        /// Header of a stream slot, streamSize_ bytes of the stream follow
         struct StreamEntry
         {
-            StreamEntry* next_;
+            s32 index_;
+            s32 padding_[3];
         };
 
         Context();
@@ -103,9 +141,27 @@ namespace lsound
         static void* threadProc(void* args);
         void update();
 
+        /// Called by user players on any thread, wakes the context at the next updateRequests
+        void addControl();
+
+        /// Consume controls written to the user players
+        void applyUserControls();
+        void applyUserControls(Player* player);
+        void publish(Player* player, State state);
+
+        /// Open the stream of a requested player, false if it cannot be played
+        bool openStream(Player* player);
+
+        static bool createStreamProc(s32 index, void* data);
+        static void destroyStreamProc(s32 index, void* data);
         StreamEntry* getStream();
         void releaseStream(Stream* stream);
+        /// Construct a stream of an entry, it is opened later by the context thread
+        Stream* createStream(StreamEntry* streamEntry, PackResource* packResource, s32 id);
 
+        /// Create the audio player of a slot, called by the pool
+        static bool createPlayerProc(s32 index, void* data);
+        static void destroyPlayerProc(s32 index, void* data);
         Player* getPlayer();
         void releasePlayer(Player* player);
 
@@ -113,7 +169,12 @@ namespace lsound
         void releaseUserPlayer(UserPlayer* player);
 
         void addRequest(Player* player);
-        Player* getRequestList();
+        /// Index of the top request, -1 if empty
+        s32 getRequestList();
+
+        /// Dense table of playing players, removed by moving the last one
+        void addPlaying(Player* player);
+        void removePlaying(Player* player);
 
         static Context* instance_;
 
@@ -121,7 +182,6 @@ namespace lsound
         lcore::SpinLock lockThreadStatus_;
 
         lcore::Event waitEvent_;
-        lcore::CriticalSection csContext_;
         lcore::SpinLock lockAPI_;
 
         bool canRun_;
@@ -137,23 +197,26 @@ namespace lsound
 
         SLObject outputMixObject_;
 
-        s32 numStreams_;
-        StreamEntry* streamTop_;
-        StreamEntry* streams_;
+        u32 streamSize_;
+        SlotPool streamPool_;
+        StreamEntry** streams_; ///< NULL for slots not made
 
-        s32 numPlayers_;
-        PlayerLink playerTop_;
+        SlotPool playerPool_; ///< players with audio players
         Player* players_;
+        VoiceTable voices_;
+        BufferPool bufferPool_; ///< sample buffers of playing players
 
-        s32 numUserPlayers_;
-        UserPlayer* userPlayerTop_;
+        lcore::LockFreeIndexStack freeUserPlayers_;
         UserPlayer* userPlayers_;
 
         PackResource* packResources_[NumMaxPacks];
 
-        u32 numRequests_;
-        Player* requestList_;
-        PlayerLink playList_;
+        //Pushed by any thread, taken at once by the context
+        volatile s32 numRequests_;
+        volatile s32 requestList_;
+        volatile s32 numControls_;
+        u16* playing_; ///< indices of playing players
+        s32 numPlaying_;
     };
 }
 #endif //INC_LSOUND_OPENSL_CONTEXT_H__
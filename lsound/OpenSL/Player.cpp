@@ -29,15 +29,19 @@ namespace lsound
     //s16 Player::queuedBuffers_[BufferNumSamples];
 
     Player::Player()
-        :userFlags_(0)
-        ,innerFlags_(0)
+        :table_(NULL)
+        ,index_(0)
+        ,generation_(1)
+        ,next_(-1)
+        ,slot_(-1)
         ,numBuffers_(0)
         ,prevState_(State_Initial)
         ,maxVolumeLevel_(0)
-        ,stream_(NULL)
         ,userPlayer_(NULL)
         ,nextBufferIndex_(0)
         ,numQueuedBuffers_(0)
+        ,block_(-1)
+        ,buffers_(NULL)
     {
         clearQueuedBuffers();
     }
@@ -51,15 +55,15 @@ namespace lsound
     u16 Player::getUserFlags()
     {
         if(NULL == userPlayer_){
-            return userFlags_;
+            return table_->userFlags_[index_];
         }
 
-        lcore::CSLock lock(userPlayer_->lock_);
-        return userPlayer_->flags_;
+        return static_cast<u16>(userPlayer_->flags_);
     }
 
     void Player::clear()
     {
+        Stream* stream = table_->streams_[index_];
         lsound::Context& context = lsound::Context::getInstance();
         context.enterAPI();
         prevState_ = State_Initial;
@@ -68,8 +72,8 @@ namespace lsound
         clearQueuedBuffers();
         context.leaveAPI();
 
-        if(stream_){
-            stream_->seek(0);
+        if(NULL != stream && !checkInnerFlag(InnerFlag_Open)){
+            stream->seek(0);
         }
     }
 
@@ -127,21 +131,31 @@ namespace lsound
         return true;
     }
 
+    void Player::destroy()
+    {
+        SLVolume().swap(volume_);
+        SLBufferQueue().swap(bufferQueue_);
+        SLPlay().swap(play_);
+        playObject_.Destroy();
+        maxVolumeLevel_ = 0;
+    }
+
     void Player::setStream(Stream* stream)
     {
-        stream_ = stream;
+        table_->streams_[index_] = stream;
     }
 
     void Player::rewind()
     {
+        Stream* stream = table_->streams_[index_];
         lsound::Context& context = lsound::Context::getInstance();
         context.enterAPI();
         play_.SetPlayState(State_Stopped);
         bufferQueue_.Clear();
         clearQueuedBuffers();
         context.leaveAPI();
-        if(stream_){
-            stream_->seek(0);
+        if(NULL != stream && !checkInnerFlag(InnerFlag_Open)){
+            stream->seek(0);
         }
     }
 
@@ -185,6 +199,7 @@ namespace lsound
 
     void Player::setGain(f32 gain)
     {
+        table_->gains_[index_] = gain;
         if(!volume_.valid()){
             return;
         }
@@ -252,29 +267,31 @@ namespace lsound
 
     bool Player::isSampleEnd()
     {
+        Stream* stream = table_->streams_[index_];
         lsound::Context& context = lsound::Context::getInstance();
-        bool ret = (stream_->getTotal()<=stream_->getPosition());
+        bool ret = (stream->getTotal()<=stream->getPosition());
         return ret;
     }
 
     s32 Player::fillBuffer(bool isLoop)
     {
-        SampleType* buffer = buffers_[nextBufferIndex_];
+        Stream* stream = table_->streams_[index_];
+        SampleType* buffer = getBuffer(nextBufferIndex_);
         s32 requestSamples = BufferNumSamplesPerChannel;
         s32 readSamples = 0;
         for(s32 i=0; i<7; ++i){
             s32 s;
 #if 1
             if(NumChannels == 1){
-                s = stream_->read(buffer, requestSamples);
+                s = stream->read(buffer, requestSamples);
             }else{
-                s = stream_->read_stereo(buffer, requestSamples);
+                s = stream->read_stereo(buffer, requestSamples);
             }
 #else
             if(NumChannels == 1){
-                s = stream_->read_float(buffer, requestSamples);
+                s = stream->read_float(buffer, requestSamples);
             }else{
-                s = stream_->read_float_stereo(buffer, requestSamples);
+                s = stream->read_float_stereo(buffer, requestSamples);
             }
 #endif
             if(0<s){
@@ -283,11 +300,11 @@ namespace lsound
                 requestSamples -= s;
             }
 
-            if(stream_->getTotal()<=stream_->getPosition()){
+            if(stream->getTotal()<=stream->getPosition()){
                 //Sď
                 //[vȂ擪ɃV[N
                 if(isLoop){
-                    stream_->seek(0);
+                    stream->seek(0);
                 } else{
                     if(readSamples<=0){
                         readSamples = -1;
@@ -304,11 +321,7 @@ namespace lsound
 
     bool Player::initialize()
     {
-        if(NULL != userPlayer_){
-            userPlayer_->lock_.enter();
-        }
-
-        u16 userFlags = (NULL == userPlayer_)? userFlags_ : userPlayer_->flags_;
+        u16 userFlags = getUserFlags();
         //u32 bufferStart = getProcessed() & BufferRoundMask;
 
         static const s16 InitNumBuffers = 1;
@@ -324,21 +337,16 @@ namespace lsound
 
             
             context.enterAPI();
-            bufferQueue_.Enqueue(buffers_[nextBufferIndex_], sizeof(SampleType)*readSamples*NumChannels);
+            bufferQueue_.Enqueue(getBuffer(nextBufferIndex_), sizeof(SampleType)*readSamples*NumChannels);
             //enqueue(sizeof(SampleType)*readSamples*NumChannels);
             advanceBufferIndex();
             context.leaveAPI();
         }
 
         prevState_ = State_Initial;
-        if(NULL != userPlayer_){
-            if(userPlayer_->state_ == State_Initial || userPlayer_->state_ == State_Playing){
-                play();
-            }else{
-                pause();
-            }
-            userPlayer_->initialized_ = 1;
-            userPlayer_->lock_.leave();
+        //Paused before the context took it, the request is consumed by the context after
+        if(NULL != userPlayer_ && UserPlayer::Request_Pause == userPlayer_->request_){
+            pause();
         }else{
             play();
         }
@@ -371,7 +379,7 @@ namespace lsound
     {
         LASSERT(0<numQueuedBuffers_);
 
-        buffer = buffers_[queuedBuffers_[0].index_];
+        buffer = getBuffer(queuedBuffers_[0].index_);
         size = queuedBuffers_[0].size_;
         for(s32 i=1; i<numQueuedBuffers_; ++i){
             queuedBuffers_[i-1] = queuedBuffers_[i];
@@ -400,7 +408,8 @@ namespace lsound
 
     bool Player::update()
     {
-        if(NULL == stream_){
+        Stream* stream = table_->streams_[index_];
+        if(NULL == stream){
             return false;
         }
         u16 userFlags = getUserFlags();
@@ -417,11 +426,11 @@ namespace lsound
         queuedBuffers = numQueuedBuffers_;
         context.leaveAPI();
 
-        if(stream_->getTotal()<=stream_->getPosition()){
+        if(stream->getTotal()<=stream->getPosition()){
             //Sď
             //[vȂ擪ɃV[N
             if(userFlags & PlayerFlag_Loop){
-                stream_->seek(0);
+                stream->seek(0);
 
             } else {
                 if(enqueuedBuffers<=0 && queuedBuffers<=0){
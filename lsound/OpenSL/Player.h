@@ -6,6 +6,7 @@
 @date 2015/07/19 create
 */
 #include "../lsound.h"
+#include "../VoiceTable.h"
 #include "internal/SLObject.h"
 #include "internal/SLPlay.h"
 #include "internal/SLVolume.h"
@@ -14,84 +15,21 @@
 namespace lsound
 {
     class Stream;
-    class Player;
     class UserPlayer;
 
-    class PlayerLink
-    {
-    public:
-        PlayerLink()
-            :prev_(this)
-            ,next_(this)
-        {}
-
-        ~PlayerLink()
-        {}
-
-        inline void resetLink();
-        inline void unlink();
-        inline void link(PlayerLink* node);
-
-        inline Player* getPrev();
-        inline void setPrev(PlayerLink* prev);
-
-        inline Player* getNext();
-        inline void setNext(PlayerLink* next);
-
-    protected:
-        PlayerLink* prev_;
-        PlayerLink* next_;
-    };
-
-    inline void PlayerLink::resetLink()
-    {
-        prev_ = next_ = this;
-    }
-
-    inline void PlayerLink::unlink()
-    {
-        next_->prev_ = prev_;
-        prev_->next_ = next_;
-        prev_ = next_ = this;
-    }
-
-    inline void PlayerLink::link(PlayerLink* node)
-    {
-        prev_ = node->prev_;
-        next_ = node;
-        prev_->next_ = node->prev_ = this;
-    }
-
-    inline Player* PlayerLink::getPrev()
-    {
-        return reinterpret_cast<Player*>(prev_);
-    }
-
-    inline void PlayerLink::setPrev(PlayerLink* prev)
-    {
-        prev_ = prev;
-    }
-
-    inline Player* PlayerLink::getNext()
-    {
-        return reinterpret_cast<Player*>(next_);
-    }
-
-    inline void PlayerLink::setNext(PlayerLink* next)
-    {
-        next_ = next;
-    }
-
-    class Player : public PlayerLink
+    class Player
     {
     public:
         enum InnerFlag
         {
             InnerFlag_UserPlayer = (0x01U<<0),
+            InnerFlag_Open = (0x01U<<1), ///< the stream is opened when the context takes the request
+            InnerFlag_Stop = (0x01U<<2), ///< stopped by the user, released at the next update
         };
 
         ~Player();
         
+        inline Handle getHandle() const;
         u16 getUserFlags();
 
         inline bool checkUserFlag(PlayerFlag flag) const;
@@ -123,6 +61,8 @@ namespace lsound
         void setRolloff(s32 rolloff);
 
         bool create(s32 numBuffers, SLObjectItf playObj);
+        /// Destroy the audio player, the player can be created again
+        void destroy();
 
         void setStream(Stream* stream);
 
@@ -140,6 +80,10 @@ namespace lsound
         static void callback(SLAndroidSimpleBufferQueueItf caller, void* context);
 
         void clearQueuedBuffers();
+        inline SampleType* getBuffer(s32 index)
+        {
+            return buffers_ + index*BufferNumSamples;
+        }
         inline void advanceBufferIndex()
         {
             ++nextBufferIndex_;
@@ -160,8 +104,11 @@ namespace lsound
 
         s32 fillBuffer(bool isLoop);
 
-        u16 userFlags_;
-        u16 innerFlags_;
+        VoiceTable* table_; ///< flags, gain and stream are in the context's table
+        u16 index_;
+        volatile u16 generation_; ///< incremented when released
+        s32 next_; ///< index of the next request
+        s32 slot_; ///< position in the play table
         s16 numBuffers_;
         s16 prevState_;
         SLmillibel maxVolumeLevel_;
@@ -172,43 +119,48 @@ namespace lsound
         SLBufferQueue bufferQueue_;
         SLVolume volume_;
 
-        Stream* stream_;
         UserPlayer* userPlayer_;
 
         s16 nextBufferIndex_;
         s16 numQueuedBuffers_;
         QueuedBuffer queuedBuffers_[NumMaxBuffers];
-        SampleType buffers_[NumMaxBuffers][BufferNumSamples];
+        s32 block_;
+        SampleType* buffers_; ///< NumMaxBuffers in a block of the context's buffer pool, NULL while released
     };
 
+    inline Handle Player::getHandle() const
+    {
+        return makeHandle(index_, generation_);
+    }
+
     inline bool Player::checkUserFlag(PlayerFlag flag) const
     {
-        return 0 != (userFlags_ & flag);
+        return 0 != (table_->userFlags_[index_] & flag);
     }
 
     inline void Player::setUserFlag(PlayerFlag flag)
     {
-        userFlags_ |= flag;
+        table_->userFlags_[index_] |= flag;
     }
 
     inline void Player::resetUserFlag(PlayerFlag flag)
     {
-        userFlags_ &= ~flag;
+        table_->userFlags_[index_] &= ~flag;
     }
 
     inline bool Player::checkInnerFlag(InnerFlag flag) const
     {
-        return 0 != (innerFlags_ & flag);
+        return 0 != (table_->innerFlags_[index_] & flag);
     }
 
     inline void Player::setInnerFlag(InnerFlag flag)
     {
-        innerFlags_ |= flag;
+        table_->innerFlags_[index_] |= flag;
     }
 
     inline void Player::resetInnerFlag(InnerFlag flag)
     {
-        innerFlags_ &= ~flag;
+        table_->innerFlags_[index_] &= ~flag;
     }
 }
 #endif //INC_LSOUND_OPENSL_PLAYER_H__
\ No newline at end of file
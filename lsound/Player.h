@@ -7,8 +7,8 @@
 */
 #include "lsound_api.h"
 
-#if defined(LSOUND_API_WASAPI)
-#include "Wasapi/Player.h"
+#if defined(LSOUND_API_WASAPI) || defined(LSOUND_API_OFFLINE)
+#include "dsp/Player.h"
 
 #elif defined(_APPLE_)
 #include "OpenAL/Player.h"
@@ -0,0 +1,145 @@
+/**
+@file SlotPool.cpp
+@author t-sakai
+@date 2015/08/15 create
+*/
+#include "SlotPool.h"
+
+namespace lsound
+{
+    SlotPool::SlotPool()
+        :chunkSize_(0)
+        ,createFunc_(NULL)
+        ,destroyFunc_(NULL)
+        ,data_(NULL)
+        ,unused_(NULL)
+        ,numUnused_(0)
+        ,made_(NULL)
+        ,numSlots_(0)
+        ,numUsed_(0)
+        ,idleCount_(0)
+    {
+    }
+
+    SlotPool::~SlotPool()
+    {
+        destroy();
+    }
+
+    bool SlotPool::create(s32 capacity, s32 chunkSize, CreateFunc createFunc, DestroyFunc destroyFunc, void* data)
+    {
+        LASSERT(0<capacity);
+        LASSERT(0<chunkSize);
+        LASSERT(NULL != createFunc);
+        LASSERT(NULL != destroyFunc);
+        destroy();
+
+        chunkSize_ = lcore::minimum(chunkSize, capacity);
+        createFunc_ = createFunc;
+        destroyFunc_ = destroyFunc;
+        data_ = data;
+
+        //Take all indices out, then put back only made ones
+        free_.initialize(capacity);
+        unused_ = LIME_NEW s32[capacity];
+        made_ = LIME_NEW u8[capacity];
+        for(s32 i=0; i<capacity; ++i){
+            free_.pop();
+            unused_[i] = capacity-1-i;
+            made_[i] = 0;
+        }
+        numUnused_ = capacity;
+        numSlots_ = 0;
+        numUsed_ = 0;
+        idleCount_ = 0;
+        return 0<grow(chunkSize_);
+    }
+
+    void SlotPool::destroy()
+    {
+        if(NULL == made_){
+            return;
+        }
+        for(s32 i=0; i<free_.capacity(); ++i){
+            if(made_[i]){
+                destroyFunc_(i, data_);
+            }
+        }
+        LIME_DELETE_ARRAY(made_);
+        LIME_DELETE_ARRAY(unused_);
+        numUnused_ = 0;
+        numSlots_ = 0;
+        numUsed_ = 0;
+    }
+
+    s32 SlotPool::pop()
+    {
+        s32 index = free_.pop();
+        if(0<=index){
+            lcore::atomicIncrement(&numUsed_);
+        }
+        return index;
+    }
+
+    void SlotPool::push(s32 index)
+    {
+        LASSERT(made_[index]);
+        lcore::atomicDecrement(&numUsed_);
+        free_.push(index);
+    }
+
+    void SlotPool::update(s32 trimDelay)
+    {
+        //Keep a whole chunk free, so a burst of pops between updates does not run out
+        s32 numFree = numSlots_ - numUsed_;
+        if(numFree < chunkSize_ && 0<numUnused_){
+            grow(chunkSize_);
+            idleCount_ = 0;
+            return;
+        }
+
+        if(!canTrim()){
+            idleCount_ = 0;
+            return;
+        }
+        if(++idleCount_<trimDelay){
+            return;
+        }
+        trim(lcore::minimum(chunkSize_, numSlots_-chunkSize_));
+        idleCount_ = 0;
+    }
+
+    s32 SlotPool::grow(s32 numSlots)
+    {
+        s32 count = 0;
+        while(count<numSlots && 0<numUnused_){
+            s32 index = unused_[numUnused_-1];
+            if(!createFunc_(index, data_)){
+                break;
+            }
+            --numUnused_;
+            made_[index] = 1;
+            lcore::atomicIncrement(&numSlots_);
+            free_.push(index);
+            ++count;
+        }
+        return count;
+    }
+
+    s32 SlotPool::trim(s32 numSlots)
+    {
+        s32 count = 0;
+        while(count<numSlots){
+            s32 index = free_.pop();
+            if(index<0){
+                break;
+            }
+            lcore::atomicDecrement(&numSlots_);
+            made_[index] = 0;
+            destroyFunc_(index, data_);
+            unused_[numUnused_++] = index;
+            ++count;
+        }
+        return count;
+    }
+}
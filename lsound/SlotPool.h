@@ -0,0 +1,93 @@
+#ifndef INC_LSOUND_SLOTPOOL_H__
+#define INC_LSOUND_SLOTPOOL_H__
+/**
+@file SlotPool.h
+@author t-sakai
+@date 2015/08/15 create
+*/
+#include "lsound.h"
+#include <lcore/async/LockFree.h>
+
+namespace lsound
+{
+    /**
+    @brief Indices of slots whose resources are made in chunks up to a capacity.
+    Any thread can pop and push, only the owner's background thread grows and trims.
+    Indices of slots do not change, so handles stay valid while the pool grows.
+    */
+    class SlotPool
+    {
+    public:
+        /// Make resources of a slot, false if failed
+        typedef bool (*CreateFunc)(s32 index, void* data);
+        typedef void (*DestroyFunc)(s32 index, void* data);
+
+        SlotPool();
+        ~SlotPool();
+
+        /**
+        @param capacity ... slots never exceed this
+        @param chunkSize ... slots made or destroyed at once, made here too
+        */
+        bool create(s32 capacity, s32 chunkSize, CreateFunc createFunc, DestroyFunc destroyFunc, void* data);
+        void destroy();
+
+        /// @return index of a free slot, -1 if no slot is free
+        s32 pop();
+        void push(s32 index);
+
+        /**
+        @brief Grow by a chunk when less than a chunk is free, trim a chunk after idle for trimDelay calls
+        */
+        void update(s32 trimDelay);
+
+        /// @return number of made slots
+        s32 grow(s32 numSlots);
+        /// @return number of destroyed slots
+        s32 trim(s32 numSlots);
+
+        inline s32 getCapacity() const;
+        inline s32 getNumSlots() const;
+        inline s32 getNumUsed() const;
+        /// Whether more than the first chunk is made, and a whole chunk stays free after trimming
+        inline bool canTrim() const;
+
+    private:
+        SlotPool(const SlotPool&);
+        SlotPool& operator=(const SlotPool&);
+
+        s32 chunkSize_;
+        CreateFunc createFunc_;
+        DestroyFunc destroyFunc_;
+        void* data_;
+
+        lcore::LockFreeIndexStack free_;
+        s32* unused_; ///< indices of slots not made, only the owner touches
+        s32 numUnused_;
+        u8* made_;
+        volatile s32 numSlots_;
+        volatile s32 numUsed_;
+        s32 idleCount_;
+    };
+
+    inline s32 SlotPool::getCapacity() const
+    {
+        return free_.capacity();
+    }
+
+    inline s32 SlotPool::getNumSlots() const
+    {
+        return numSlots_;
+    }
+
+    inline s32 SlotPool::getNumUsed() const
+    {
+        return numUsed_;
+    }
+
+    inline bool SlotPool::canTrim() const
+    {
+        return chunkSize_<numSlots_ && chunkSize_*2 <= (numSlots_-numUsed_);
+    }
+}
+#endif //INC_LSOUND_SLOTPOOL_H__
@@ -7,8 +7,8 @@
 */
 #include "lsound_api.h"
 
-#if defined(LSOUND_API_WASAPI)
-#include "Wasapi/UserPlayer.h"
+#if defined(LSOUND_API_WASAPI) || defined(LSOUND_API_OFFLINE)
+#include "dsp/UserPlayer.h"
 
 #elif defined(LSOUND_API_OPENAL)
 #include "OpenAL/UserPlayer.h"
@@ -0,0 +1,106 @@
+/**
+@file VoiceTable.cpp
+@author t-sakai
+@date 2015/08/12 create
+*/
+#include "VoiceTable.h"
+
+namespace lsound
+{
+    namespace
+    {
+        /// Each array starts at a cache line
+        inline u32 alignLine(u32 size)
+        {
+            return (size + 63) & ~63U;
+        }
+    }
+
+    VoiceTable::VoiceTable()
+        :userFlags_(NULL)
+        ,innerFlags_(NULL)
+        ,states_(NULL)
+        ,gains_(NULL)
+        ,loudness_(NULL)
+        ,priorities_(NULL)
+        ,sounds_(NULL)
+        ,maxInstances_(NULL)
+        ,polyphonies_(NULL)
+        ,positions_(NULL)
+        ,deadlines_(NULL)
+        ,streams_(NULL)
+        ,capacity_(0)
+        ,memory_(NULL)
+    {
+    }
+
+    VoiceTable::~VoiceTable()
+    {
+        destroy();
+    }
+
+    void VoiceTable::create(s32 capacity)
+    {
+        LASSERT(0<capacity);
+        destroy();
+
+        u32 sizeDeadlines = alignLine(sizeof(u64)*capacity);
+        u32 sizeStreams = alignLine(sizeof(Stream*)*capacity);
+        u32 sizeStates = alignLine(sizeof(s32)*capacity);
+        u32 sizeGains = alignLine(sizeof(f32)*capacity);
+        u32 sizePriorities = alignLine(sizeof(u8)*capacity);
+        u32 sizePositions = alignLine(sizeof(u32)*capacity);
+        u32 sizeFlags = alignLine(sizeof(u16)*capacity);
+
+        u32 size = sizeDeadlines + sizeStreams + sizeStates + sizeGains*2 + sizePositions*2 + sizeFlags*2 + sizePriorities*3;
+        memory_ = reinterpret_cast<u8*>(LIME_ALIGNED_MALLOC(size, 64));
+        capacity_ = capacity;
+
+        u8* memory = memory_;
+        deadlines_ = reinterpret_cast<u64*>(memory); memory += sizeDeadlines;
+        streams_ = reinterpret_cast<Stream**>(memory); memory += sizeStreams;
+        states_ = reinterpret_cast<s32*>(memory); memory += sizeStates;
+        gains_ = reinterpret_cast<f32*>(memory); memory += sizeGains;
+        loudness_ = reinterpret_cast<f32*>(memory); memory += sizeGains;
+        positions_ = reinterpret_cast<u32*>(memory); memory += sizePositions;
+        sounds_ = reinterpret_cast<u32*>(memory); memory += sizePositions;
+        userFlags_ = reinterpret_cast<u16*>(memory); memory += sizeFlags;
+        innerFlags_ = reinterpret_cast<u16*>(memory); memory += sizeFlags;
+        priorities_ = reinterpret_cast<u8*>(memory); memory += sizePriorities;
+        maxInstances_ = reinterpret_cast<u8*>(memory); memory += sizePriorities;
+        polyphonies_ = reinterpret_cast<u8*>(memory);
+
+        for(s32 i=0; i<capacity; ++i){
+            deadlines_[i] = 0;
+            streams_[i] = NULL;
+            states_[i] = State_Initial;
+            gains_[i] = 1.0f;
+            loudness_[i] = 1.0f;
+            priorities_[i] = 0;
+            sounds_[i] = 0;
+            maxInstances_[i] = 0;
+            polyphonies_[i] = Polyphony_Reject;
+            positions_[i] = 0;
+            userFlags_[i] = 0;
+            innerFlags_[i] = 0;
+        }
+    }
+
+    void VoiceTable::destroy()
+    {
+        LIME_ALIGNED_FREE(memory_, 64);
+        userFlags_ = NULL;
+        innerFlags_ = NULL;
+        states_ = NULL;
+        gains_ = NULL;
+        loudness_ = NULL;
+        priorities_ = NULL;
+        sounds_ = NULL;
+        maxInstances_ = NULL;
+        polyphonies_ = NULL;
+        positions_ = NULL;
+        deadlines_ = NULL;
+        streams_ = NULL;
+        capacity_ = 0;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef INC_LSOUND_VOICETABLE_H__
+#define INC_LSOUND_VOICETABLE_H__
+/**
+@file VoiceTable.h
+@author t-sakai
+@date 2015/08/12 create
+*/
+#include "lsound.h"
+
+namespace lsound
+{
+    class Stream;
+
+    /**
+    @brief Hot fields of voices, one array per field indexed by the voice index.
+    Update passes over many voices touch only the arrays they need.
+    */
+    class VoiceTable
+    {
+    public:
+        VoiceTable();
+        ~VoiceTable();
+
+        void create(s32 capacity);
+        void destroy();
+
+        inline s32 getCapacity() const;
+
+        u16* userFlags_;
+        u16* innerFlags_;
+        s32* states_;
+        f32* gains_;
+        f32* loudness_; ///< root mean square of the sound at gain 1
+        u8* priorities_;
+        u32* sounds_; ///< pack and entry, for instance limits
+        u8* maxInstances_; ///< 0 for no limit
+        u8* polyphonies_;
+        u32* positions_; ///< played frames
+        u64* deadlines_; ///< microseconds, for backends scheduling refills
+        Stream** streams_;
+
+    private:
+        VoiceTable(const VoiceTable&);
+        VoiceTable& operator=(const VoiceTable&);
+
+        s32 capacity_;
+        u8* memory_;
+    };
+
+    inline s32 VoiceTable::getCapacity() const
+    {
+        return capacity_;
+    }
+}
+#endif //INC_LSOUND_VOICETABLE_H__
@@ -8,9 +8,6 @@
 #include <Audioclient.h>
 #include <Audiopolicy.h>
 #include <lcore/CLibrary.h>
-#include "../opus/Stream.h"
-#include "../opus/Resource.h"
-#include "UserPlayer.h"
 
 #define LSOUND_CONTEXT_DEBUG
 
@@ -98,35 +95,12 @@ namespace
             //printf("session state: %d\n", audioSessionState);
 
             //VKNGXg
-            context->contextLock_.enter();
-            Player* requestList = context->getRequestList();
-            context->contextLock_.leave();
-            while(NULL != requestList){
-                LSOUND_DECL_START;
-                Player* request = requestList;
-                requestList = requestList->getNext();
-                
-                if(context->initPlayer(request)){
-                    request->link(&context->playList_);
-                }else{
-                    context->releasePlayer(request);
-                }
-                LSOUND_DECL_STOP("initial:%f\n")
-            }
+            LSOUND_DECL_START;
+            context->startRequests();
+            LSOUND_DECL_STOP("initial:%f\n")
 
             //XV
-            Player* endList = context->updatePlayers();
-
-            //INGXg
-            {
-                lcore::CSLock lock(context->contextLock_);
-                while(NULL != endList){
-                    Player* current = endList;
-                    endList = endList->getNext();
-                    current->resetLink();
-                    context->releasePlayer(current);
-                }
-            }
+            context->mixPlayers();
         }
 
         context->clear();
@@ -136,43 +110,36 @@ namespace
         return 0;
     }
 
-    Player* Context::updatePlayers()
+    void Context::mixPlayers()
     {
-        Player* endList = NULL;
-        Player* player = playList_.getNext();
-        while(player != &playList_){
-
-            Player* current = player;
-            player = player->getNext();
-
-            //DWORD ret = WaitForSingleObject(player->fillEvent_, 0);
-            //if(WAIT_OBJECT_0 != ret){
-            //    continue;
-            //}
-
-            if(!current->update()){
-                current->clear();
-                current->unlink();
-                current->setNext(endList);
-                endList = current;
-            }
+        u32 requestFrames = device_.getNumWritableFrames();
+        if(requestFrames<(device_.getBufferFrames()>>1)){
+            return;
+        }
+        u8* data = device_.lock(requestFrames);
+        if(NULL == data){
+            return;
         }
-        return endList;
-    }
 
-    bool Context::initPlayer(Player* player)
-    {
-        player->resetLink();
-        return player->initialize();
+        //The mixer holds only a few blocks, so mix each one after the last is read out
+        const u32 bytesPerFrame = device_.getNumChannels()*device_.getBytesPerSample();
+        u32 writtenFrames = 0;
+        while(writtenFrames<requestFrames){
+            if(mixer_.getNumAvailableFrames()<=0){
+                mixBlock();
+            }
+            writtenFrames += mixer_.read(data + writtenFrames*bytesPerFrame, requestFrames-writtenFrames, 1.0f);
+        }
+        device_.unlock(writtenFrames);
     }
 
-
     Context* Context::instance_ = NULL;
 
     bool Context::initialize(const InitParam& initParam)
     {
         LASSERT(0<initParam.numQueuedBuffers_ && initParam.numQueuedBuffers_<=lsound::NumMaxBuffers);
-        LASSERT(0<initParam.maxPlayers_);
+        LASSERT(0<initParam.maxPlayers_ && initParam.maxPlayers_<=MaxHandleIndex);
+        LASSERT(0<initParam.maxUserPlayers_ && initParam.maxUserPlayers_<=MaxHandleIndex);
 
         if(NULL != instance_){
             return true;
@@ -266,46 +233,31 @@ namespace
         device_.simpleVolume_ = simpleVolume;
         device_.simpleVolume_->SetMasterVolume(1.0f, NULL);
 
-        initStreams();
-        initPlayers();
-        initUserPlayers();
+        if(!createClient()){
+            device_.destroy();
+            return false;
+        }
+
+        if(!createVoices(device_.getNumChannels(), device_.getBytesPerSample(), device_.getSamplesPerSec())){
+            device_.destroy();
+            return false;
+        }
+
+        mixPlayers();
+        device_.start();
         return true;
     }
 
     void Context::destroyDevice()
     {
-        LIME_DELETE_ARRAY(userPlayers_);
-        LIME_DELETE_ARRAY(players_);
-
-        u8* streams = reinterpret_cast<u8*>(streams_);
-        LIME_FREE(streams);
-        streams = NULL;
-
+        destroyVoices();
         device_.destroy();
     }
 
     Context::Context(const InitParam& initParam)
-        :numStreams_(0)
-        ,streamTop_(NULL)
-        ,streams_(NULL)
-        ,numPlayers_(0)
-        ,players_(NULL)
-        ,numUserPlayers_(0)
-        ,userPlayerTop_(NULL)
-        ,userPlayers_(NULL)
-        ,numRequests_(0)
-        ,requestList_(NULL)
+        :MixerContext(initParam)
+        ,waitTime_(initParam.waitTime_)
     {
-        initParam_ = initParam;
-        waitTime_ = initParam_.waitTime_;
-
-        playerTop_.resetLink();
-        playList_.resetLink();
-
-        for(s32 i=0; i<NumMaxPacks; ++i){
-            packResources_[i] = NULL;
-        }
-
         initEvent_ = CreateEventEx(NULL, NULL, 0, EVENT_MODIFY_STATE|SYNCHRONIZE);
         exitEvent_ = CreateEventEx(NULL, NULL, 0, EVENT_MODIFY_STATE|SYNCHRONIZE);
         waitEvent_ = CreateEventEx(NULL, NULL, 0, EVENT_MODIFY_STATE|SYNCHRONIZE);
@@ -334,48 +286,6 @@ namespace
         LSOUND_CLOSEHANDLE(waitEvent_);
         LSOUND_CLOSEHANDLE(exitEvent_);
         LSOUND_CLOSEHANDLE(initEvent_);
-
-        for(s32 i=0; i<NumMaxPacks; ++i){
-            LIME_DELETE(packResources_[i]);
-        }
-    }
-
-    void Context::clear()
-    {
-        lcore::CSLock lock(contextLock_);
-
-        Player* endList = NULL;
-
-        Player* player = playList_.getNext();
-        while(player != &playList_){
-            Player* current = player;
-            player = player->getNext();
-
-            current->clear();
-            current->unlink();
-            current->setNext(endList);
-            endList = current;
-        }
-
-        //INGXgAVKNGXg
-        Player* requestList = getRequestList();
-
-        while(NULL != requestList){
-            Player* request = requestList;
-            requestList = requestList->getNext();
-            request->resetLink();
-
-            request->clear();
-            request->setNext(endList);
-            endList = request;
-        }
-
-        while(NULL != endList){
-            Player* current = endList;
-            endList = endList->getNext();
-            current->resetLink();
-            releasePlayer(current);
-        }
     }
 
     void Context::setGain(f32 gain)
@@ -389,263 +299,28 @@ namespace
         lcore::CSLock lock(contextLock_);
         if(pause){
             waitTime_ = lcore::thread::Infinite;
+            device_.stop();
         }else{
             waitTime_ = initParam_.waitTime_;
+            device_.start();
             SetEvent(waitEvent_);
         }
     }
 
     void Context::updateRequests()
     {
-        if(numRequests_){
+        if(0<takeNumRequests()){
             SetEvent(waitEvent_);
-            numRequests_ = 0;
-        }
-    }
-
-    s32 Context::loadResourcePack(s32 id, const Char* path, bool stream)
-    {
-        LASSERT(0<=id && id<NumMaxPacks);
-        lcore::CSLock lock(contextLock_);
-
-        PackResource* packResource = NULL;
-        if(stream){
-            packResource = PackFile::open(path);
-        }else{
-            packResource = PackMemory::open(path);
-        }
-
-        if(NULL == packResource){
-            return -1;
-        }
-
-        LIME_DELETE(packResources_[id]);
-        packResources_[id] = packResource;
-        return id;
-    }
-
-    bool Context::play(s32 packId, s32 id, f32 gain)
-    {
-        LASSERT(0<=packId && packId<NumMaxPacks);
-        LASSERT(0<=id);
-        lcore::CSLock lock(contextLock_);
-
-        PackResource* packResource = packResources_[packId];
-        if(NULL == packResource){
-            return false;
-        }
-        if(packResource->getNumFiles()<=id){
-            return false;
-        }
-
-        Player* player;
-        StreamEntry* streamEntry;
-        {
-            if(numPlayers_<=0){
-                return false;
-            }
-            player = getPlayer();
-
-            if(NULL == streamTop_){
-                releasePlayer(player);
-                return false;
-            }
-            streamEntry = getStream();
-        }
-
-        Stream* stream;
-        switch(packResource->getType())
-        {
-        case PackResource::ResourceType_File:
-            {
-
-                FileStream* fileStream = LIME_PLACEMENT_NEW(streamEntry) FileStream();
-                PackFile* packFile = reinterpret_cast<PackFile*>(packResource);
-                File* file;
-                s32 start, end;
-                packFile->get(id, file, start, end);
-                fileStream->set(file, start, end);
-                stream = fileStream;
-            }
-            break;
-
-        case PackResource::ResourceType_Memory:
-            {
-                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry) MemoryStream();
-                PackMemory* packMemory = reinterpret_cast<PackMemory*>(packResource);
-                Memory* memory;
-                u32 size;
-                s32 offset;
-                packMemory->get(id, memory, size, offset);
-                memoryStream->set(size, offset, memory);
-                stream = memoryStream;
-            }
-            break;
-
-        default:
-            {
-                releasePlayer(player);
-                releaseStream((Stream*)streamEntry);
-            }
-            return false;
-        }
-
-        if(!stream->open() || stream->getTotal()<=0){
-            releasePlayer(player);
-            releaseStream(stream);
-            return false;
-        }
-        player->setStream(stream);
-        player->setGain(gain);
-        player->clear();
-
-        player->setNext(requestList_);
-        requestList_ = player;
-
-        ++numRequests_;
-        return true;
-    }
-
-    UserPlayer* Context::createUserPlayer(s32 packId, s32 id)
-    {
-        LASSERT(0<=packId && packId<NumMaxPacks);
-        LASSERT(0<=id);
-        lcore::CSLock lock(contextLock_);
-
-        PackResource* packResource = packResources_[packId];
-        if(NULL == packResource){
-            return NULL;
-        }
-        if(packResource->getNumFiles()<=id){
-            return NULL;
-        }
-
-        UserPlayer* userPlayer;
-        Player* player;
-        StreamEntry* streamEntry;
-        {
-            if(numUserPlayers_<=0){
-                return NULL;
-            }
-
-            userPlayer = getUserPlayer();
-
-            if(numPlayers_<=0){
-                releaseUserPlayer(userPlayer);
-                return NULL;
-            }
-            player = getPlayer();
-
-            if(NULL == streamTop_){
-                releaseUserPlayer(userPlayer);
-                releasePlayer(player);
-                return NULL;
-            }
-            streamEntry = getStream();
-        }
-
-        Stream* stream;
-        switch(packResource->getType())
-        {
-        case PackResource::ResourceType_File:
-            {
-
-                FileStream* fileStream = LIME_PLACEMENT_NEW(streamEntry) FileStream();
-                PackFile* packFile = reinterpret_cast<PackFile*>(packResource);
-                File* file;
-                s32 start, end;
-                packFile->get(id, file, start, end);
-                fileStream->set(file, start, end);
-                stream = fileStream;
-            }
-            break;
-
-        case PackResource::ResourceType_Memory:
-            {
-                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry) MemoryStream();
-                PackMemory* packMemory = reinterpret_cast<PackMemory*>(packResource);
-                Memory* memory;
-                u32 size;
-                s32 offset;
-                packMemory->get(id, memory, size, offset);
-                memoryStream->set(size, offset, memory);
-                stream = memoryStream;
-            }
-            break;
-
-        default:
-            {
-                releaseUserPlayer(userPlayer);
-                releasePlayer(player);
-                releaseStream((Stream*)streamEntry);
-            }
-            return NULL;
         }
-
-        if(!stream->open() || stream->getTotal()<=0){
-            releaseUserPlayer(userPlayer);
-            releasePlayer(player);
-            releaseStream(stream);
-            return NULL;
-        }
-        player->setStream(stream);
-        player->setGain(1.0f);
-        player->setInnerFlag(Player::InnerFlag_UserPlayer);
-        
-        player->clear();
-        player->userPlayer_ = userPlayer;
-        userPlayer->impl_.player_ = player;
-        userPlayer->initialized_ = 0;
-        userPlayer->state_ = State_Initial;
-
-        player->setNext(requestList_);
-        requestList_ = player;
-        ++numRequests_;
-        return userPlayer;
-    }
-
-    void Context::destroyUserPlayer(UserPlayer* player)
-    {
-        if(NULL == player){
-            return;
-        }
-        lcore::CSLock lock(contextLock_);
-        player->impl_.player_->stop();
-        releaseUserPlayer(player);
     }
 
     u32 Context::getWaitTime()
     {
-        lcore::CSLock lock(contextLock_);
         return waitTime_;
     }
 
-    void Context::initStreams()
+    bool Context::createClient()
     {
-        LASSERT(NULL == streams_);
-        numStreams_ = initParam_.maxPlayers_;
-        u32 elemSize = lcore::maximum(sizeof(FileStream), sizeof(MemoryStream));
-        u8* buffer = (u8*)LIME_MALLOC(elemSize * initParam_.maxPlayers_);
-
-        StreamEntry* entry;
-        for(s32 i=0; i<(initParam_.maxPlayers_-1); ++i){
-            entry = reinterpret_cast<StreamEntry*>(buffer + i*elemSize);
-            entry->next_ = reinterpret_cast<StreamEntry*>(buffer + (i+1)*elemSize);
-        }
-        entry = reinterpret_cast<StreamEntry*>(buffer + (initParam_.maxPlayers_-1)*elemSize);
-        entry->next_ = NULL;
-
-        streamTop_ = reinterpret_cast<StreamEntry*>(buffer);
-        streams_ = reinterpret_cast<StreamEntry*>(buffer);
-    }
-
-    void Context::initPlayers()
-    {
-        LASSERT(NULL == players_);
-        players_ = LIME_NEW Player[initParam_.maxPlayers_];
-
-        numPlayers_ = 0;
-
         HRESULT hr;
         IAudioClient* audioClient = NULL;
 
@@ -681,14 +356,14 @@ namespace
                 NULL,
                 (void**)&audioClient);
         if(FAILED(hr)){
-            return;
+            return false;
         }
 
         WAVEFORMATEX* mixFormat = NULL;
         hr = audioClient->IsFormatSupported(AUDCLNT_SHAREMODE_SHARED, &fmt.Format, &mixFormat);
         if(FAILED(hr)){
             audioClient->Release();
-            return;
+            return false;
         }
         if(NULL != mixFormat){
             if(mixFormat->wFormatTag == WAVE_FORMAT_EXTENSIBLE){
@@ -719,122 +394,24 @@ namespace
             hr = audioClient->IsFormatSupported(AUDCLNT_SHAREMODE_SHARED, &fmt.Format, &mixFormat);
             if(FAILED(hr)){
                 audioClient->Release();
-                return;
+                return false;
             }
             LSOUND_TASKMEMFREE(mixFormat);
             if(fmt.Format.wBitsPerSample == 8){
                 audioClient->Release();
-                return;
+                return false;
             }
             if(SampleRate_96000<fmt.Format.nSamplesPerSec){
                 audioClient->Release();
-                return;
+                return false;
             }
         }
         audioClient->Release();
         audioClient = NULL;
 
-        for(s32 i=initParam_.maxPlayers_-1; 0<=i; --i){
-            hr = device_.device_->Activate(
-                IID_IAudioClient,
-                CLSCTX_INPROC_SERVER,
-                NULL,
-                (void**)&audioClient);
-            if(FAILED(hr)){
-                continue;
-            }
-            if(!players_[i].create(initParam_.numQueuedBuffers_, audioClient, fmt.Format)){
-                continue;
-            }
-            players_[i].link(playerTop_.getNext());
-            ++numPlayers_;
-        }
-    }
-
-    void Context::initUserPlayers()
-    {
-        LASSERT(NULL == userPlayers_);
-        numUserPlayers_ = initParam_.maxUserPlayers_;
-        userPlayers_ = LIME_NEW UserPlayer[initParam_.maxUserPlayers_];
-
-        for(s32 i=0; i<(initParam_.maxUserPlayers_-1); ++i){
-            userPlayers_[i].impl_.next_ = &userPlayers_[i+1];
-        }
-        userPlayers_[initParam_.maxUserPlayers_-1].impl_.next_ = NULL;
-        userPlayerTop_ = &userPlayers_[0];
-    }
-
-    Context::StreamEntry* Context::getStream()
-    {
-        StreamEntry* entry = streamTop_;
-        streamTop_ = streamTop_->next_;
-        --numStreams_;
-        return entry;
-    }
-
-    void Context::releaseStream(Stream* stream)
-    {
-        LASSERT(NULL != stream);
-        stream->~Stream();
-        StreamEntry* entry = reinterpret_cast<StreamEntry*>(stream);
-        entry->next_ = streamTop_;
-        streamTop_ = entry;
-        ++numStreams_;
-    }
-
-    Player* Context::getPlayer()
-    {
-        Player* player = playerTop_.getNext();
-        player->unlink();
-        player->userFlags_ = 0;
-        player->innerFlags_ = 0;
-        player->userPlayer_ = NULL;
-        player->state_ = lsound::State_Initial;
-        --numPlayers_;
-        return player;
-    }
-
-    void Context::releasePlayer(Player* player)
-    {
-        LASSERT(NULL != player);
-        //player->resetLink();
-
-        if(NULL != player->stream_){
-            releaseStream(player->stream_);
-            player->stream_ = NULL;
+        if(!device_.createClient(static_cast<s8>(initParam_.numQueuedBuffers_), fmt.Format)){
+            return false;
         }
-        player->link(&playerTop_);
-        ++numPlayers_;
-    }
-
-    UserPlayer* Context::getUserPlayer()
-    {
-        UserPlayer* player = userPlayerTop_;
-        userPlayerTop_ = userPlayerTop_->impl_.next_;
-        player->flags_ = 0;
-        --numUserPlayers_;
-        return player;
-    }
-
-    void Context::releaseUserPlayer(UserPlayer* player)
-    {
-        LASSERT(NULL != player);
-        player->impl_.next_ = userPlayerTop_;
-        userPlayerTop_ = player;
-        ++numUserPlayers_;
-    }
-
-    void Context::addRequest(Player* player)
-    {
-        LASSERT(NULL != player);
-        player->setNext(requestList_);
-        requestList_ = player;
-    }
-
-    Player* Context::getRequestList()
-    {
-        Player* ret = requestList_;
-        requestList_ = NULL;
-        return ret;
+        return true;
     }
 }
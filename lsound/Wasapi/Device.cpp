@@ -7,7 +7,7 @@
 #include <Audioclient.h>
 #include <Audiopolicy.h>
 #include "../opus/Stream.h"
-#include "Player.h"
+#include "../dsp/Player.h"
 
 namespace lsound
 {
@@ -16,6 +16,12 @@ namespace lsound
         ,audioSessionManager_(NULL)
         //,audioSessionControl_(NULL)
         ,simpleVolume_(NULL)
+        ,audioClient_(NULL)
+        ,audioRenderClient_(NULL)
+        ,numChannels_(0)
+        ,bytesPerSample_(0)
+        ,samplesPerSec_(0)
+        ,bufferFrames_(0)
     {
     }
 
@@ -26,9 +32,101 @@ namespace lsound
 
     void Device::destroy()
     {
+        destroyClient();
         LSOUND_RELEASE(simpleVolume_);
         //LSOUND_RELEASE(audioSessionControl_);
         LSOUND_RELEASE(audioSessionManager_);
         LSOUND_RELEASE(device_);
     }
+
+    bool Device::createClient(s8 numBuffers, const WAVEFORMATEX& fmt)
+    {
+        LASSERT(0<numBuffers && numBuffers<=NumMaxBuffers);
+        LASSERT(NULL != device_);
+
+        destroyClient();
+
+        HRESULT hr = device_->Activate(
+            IID_IAudioClient,
+            CLSCTX_INPROC_SERVER,
+            NULL,
+            (void**)&audioClient_);
+        if(FAILED(hr)){
+            return false;
+        }
+
+        f64 duration = 1000.0 * 1000.0 * 10.0*((f64)BufferNumSamplesPerChannel/fmt.nSamplesPerSec);
+        REFERENCE_TIME requestedDuration = static_cast<REFERENCE_TIME>(duration*numBuffers + 0.5);
+
+        hr = audioClient_->Initialize(
+            AUDCLNT_SHAREMODE_SHARED,
+            AUDCLNT_STREAMFLAGS_NOPERSIST,
+            requestedDuration,
+            0,
+            &fmt,
+            NULL);
+        if(FAILED(hr)){
+            destroyClient();
+            return false;
+        }
+
+        hr = audioClient_->GetService(IID_IAudioRenderClient, (void**)&audioRenderClient_);
+        if(FAILED(hr)){
+            destroyClient();
+            return false;
+        }
+
+        numChannels_ = fmt.nChannels;
+        bytesPerSample_ = fmt.wBitsPerSample/8;
+        samplesPerSec_ = fmt.nSamplesPerSec;
+        bufferFrames_ = 0;
+        audioClient_->GetBufferSize(&bufferFrames_);
+        return true;
+    }
+
+    void Device::destroyClient()
+    {
+        if(NULL != audioClient_){
+            audioClient_->Stop();
+        }
+        LSOUND_RELEASE(audioRenderClient_);
+        LSOUND_RELEASE(audioClient_);
+        bufferFrames_ = 0;
+    }
+
+    void Device::start()
+    {
+        if(NULL != audioClient_){
+            audioClient_->Start();
+        }
+    }
+
+    void Device::stop()
+    {
+        if(NULL != audioClient_){
+            audioClient_->Stop();
+        }
+    }
+
+    u32 Device::getNumWritableFrames()
+    {
+        UINT32 numFramesPadding = 0;
+        HRESULT hr = audioClient_->GetCurrentPadding(&numFramesPadding);
+        if(FAILED(hr)){
+            return 0;
+        }
+        return bufferFrames_ - numFramesPadding;
+    }
+
+    u8* Device::lock(u32 numFrames)
+    {
+        BYTE* data = NULL;
+        HRESULT hr = audioRenderClient_->GetBuffer(numFrames, &data);
+        return (FAILED(hr))? NULL : data;
+    }
+
+    void Device::unlock(u32 numFrames)
+    {
+        audioRenderClient_->ReleaseBuffer(numFrames, 0);
+    }
 }
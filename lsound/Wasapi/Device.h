@@ -6,6 +6,7 @@
 @date 2015/07/06 create
 */
 #include "../lsound.h"
+#include <Audioclient.h>
 
 struct IAudioSessionManager;
 struct IAudioSessionControl;
@@ -23,6 +24,27 @@ namespace lsound
 
         inline bool valid() const;
         void destroy();
+
+        /**
+        @brief Create the single output stream all players are mixed into
+        */
+        bool createClient(s8 numBuffers, const WAVEFORMATEX& fmt);
+        void destroyClient();
+
+        void start();
+        void stop();
+
+        /**
+        @return number of frames which can be written
+        */
+        u32 getNumWritableFrames();
+        u8* lock(u32 numFrames);
+        void unlock(u32 numFrames);
+
+        inline u16 getNumChannels() const;
+        inline u16 getBytesPerSample() const;
+        inline u32 getSamplesPerSec() const;
+        inline u32 getBufferFrames() const;
     private:
         friend class Context;
 
@@ -30,11 +52,38 @@ namespace lsound
         IAudioSessionManager* audioSessionManager_;
         //IAudioSessionControl* audioSessionControl_;
         ISimpleAudioVolume* simpleVolume_;
+
+        IAudioClient* audioClient_;
+        IAudioRenderClient* audioRenderClient_;
+        u16 numChannels_;
+        u16 bytesPerSample_;
+        u32 samplesPerSec_;
+        u32 bufferFrames_;
     };
 
     inline bool Device::valid() const
     {
         return (NULL != device_);
     }
+
+    inline u16 Device::getNumChannels() const
+    {
+        return numChannels_;
+    }
+
+    inline u16 Device::getBytesPerSample() const
+    {
+        return bytesPerSample_;
+    }
+
+    inline u32 Device::getSamplesPerSec() const
+    {
+        return samplesPerSec_;
+    }
+
+    inline u32 Device::getBufferFrames() const
+    {
+        return bufferFrames_;
+    }
 }
 #endif //INC_LSOUND_WASAPI_DEVICE_H__
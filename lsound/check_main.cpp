@@ -17,7 +17,8 @@ int main(int argc, char** argv)
         context.loadResourcePack(0, "..\\android\\app\\src\\main\\assets\\bgm.pak", true);
         context.loadResourcePack(1, "..\\android\\app\\src\\main\\assets\\se.pak", false);
 #if 1
-        lsound::UserPlayer* player = context.createUserPlayer(0, 0);
+        lsound::Handle handle = context.createUserPlayer(0, 0);
+        lsound::UserPlayer* player = context.findUserPlayer(handle);
         player->setFlag(lsound::PlayerFlag_Loop);
         player->play();
 
@@ -40,7 +41,7 @@ int main(int argc, char** argv)
                 break;
             }
         }
-        context.destroyUserPlayer(player);
+        context.destroyUserPlayer(handle);
 #endif
         lsound::Context::terminate();
     }
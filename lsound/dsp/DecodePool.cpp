@@ -0,0 +1,145 @@
+/**
+@file DecodePool.cpp
+@author t-sakai
+@date 2015/08/07 create
+*/
+#include "DecodePool.h"
+#include <lcore/CLibrary.h>
+
+namespace lsound
+{
+    //--------------------------------------------------------
+    //---
+    //--- DecodePool::Worker
+    //---
+    //--------------------------------------------------------
+    DecodePool::Worker::Worker()
+        :pool_(NULL)
+        ,index_(0)
+        ,startEvent_(false, false)
+        ,doneEvent_(false, false)
+    {
+    }
+
+    DecodePool::Worker::~Worker()
+    {
+    }
+
+    void DecodePool::Worker::kick()
+    {
+        startEvent_.set();
+    }
+
+    void DecodePool::Worker::wait()
+    {
+        doneEvent_.wait(lcore::thread::Infinite);
+    }
+
+    void DecodePool::Worker::exit()
+    {
+        stop();
+        startEvent_.set();
+        join();
+    }
+
+    void DecodePool::Worker::run()
+    {
+        for(;;){
+            startEvent_.wait(lcore::thread::Infinite);
+            if(!canRun()){
+                break;
+            }
+            pool_->execute(index_);
+            doneEvent_.set();
+        }
+    }
+
+    //--------------------------------------------------------
+    //---
+    //--- DecodePool
+    //---
+    //--------------------------------------------------------
+    DecodePool::DecodePool()
+        :numWorkers_(0)
+        ,numRunning_(0)
+        ,proc_(NULL)
+        ,data_(NULL)
+        ,scratches_(NULL)
+        ,workers_(NULL)
+    {
+    }
+
+    DecodePool::~DecodePool()
+    {
+        destroy();
+    }
+
+    bool DecodePool::create(s32 numWorkers)
+    {
+        destroy();
+        numWorkers = lcore::clamp(numWorkers, 1, MaxWorkers);
+
+        scratches_ = reinterpret_cast<Scratch*>(LIME_ALIGNED_MALLOC(sizeof(Scratch)*numWorkers, 16));
+        if(NULL == scratches_){
+            return false;
+        }
+        numWorkers_ = 1;
+        if(1<numWorkers){
+            workers_ = LIME_NEW Worker[numWorkers-1];
+            for(s32 i=1; i<numWorkers; ++i){
+                Worker& worker = workers_[i-1];
+                worker.pool_ = this;
+                worker.index_ = i;
+                if(!worker.create()){
+                    break;
+                }
+                worker.start();
+                ++numWorkers_;
+            }
+        }
+        return true;
+    }
+
+    void DecodePool::destroy()
+    {
+        for(s32 i=1; i<numWorkers_; ++i){
+            workers_[i-1].exit();
+        }
+        LIME_DELETE_ARRAY(workers_);
+        LIME_ALIGNED_FREE(scratches_, 16);
+        numWorkers_ = 0;
+        numRunning_ = 0;
+    }
+
+    void DecodePool::run(Proc proc, void* data, s32 numWorkers)
+    {
+        LASSERT(NULL != proc);
+        LASSERT(0<numWorkers_);
+
+        proc_ = proc;
+        data_ = data;
+        numRunning_ = lcore::clamp(numWorkers, 1, numWorkers_);
+
+        for(s32 i=1; i<numRunning_; ++i){
+            workers_[i-1].kick();
+        }
+        execute(0);
+        for(s32 i=1; i<numRunning_; ++i){
+            workers_[i-1].wait();
+        }
+    }
+
+    void DecodePool::gather(Mixer& mixer)
+    {
+        for(s32 i=0; i<numRunning_; ++i){
+            mixer.mix(scratches_[i].bus_);
+        }
+    }
+
+    void DecodePool::execute(s32 worker)
+    {
+        Scratch& scratch = scratches_[worker];
+        lcore::memset(scratch.bus_, 0, sizeof(scratch.bus_));
+        proc_(data_, worker, numRunning_, scratch.pcm_, scratch.bus_);
+    }
+}
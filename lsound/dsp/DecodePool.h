@@ -0,0 +1,102 @@
+#ifndef INC_LSOUND_DECODEPOOL_H__
+#define INC_LSOUND_DECODEPOOL_H__
+/**
+@file DecodePool.h
+@author t-sakai
+@date 2015/08/07 create
+*/
+#include "../lsound.h"
+#include <lcore/async/SyncObject.h>
+#include <lcore/async/Thread.h>
+#include "Mixer.h"
+
+namespace lsound
+{
+    /**
+    @brief Runs a decode job on the calling thread and on worker threads, once per mixer block.
+
+    Each worker has its own pcm scratch and partial bus, so jobs share nothing while running.
+    Worker 0 is the calling thread.
+    */
+    class DecodePool
+    {
+    public:
+        static const s32 MaxWorkers = 8;
+        static const u32 ScratchLength = Mixer::BlockFrames*Mixer::BusNumChannels;
+
+        /**
+        @param data ... user data
+        @param worker ... index of worker, [0, numWorkers)
+        @param numWorkers ... number of workers running the job
+        @param pcm ... scratch buffer of ScratchLength, voices are decoded in float
+        @param bus ... partial bus of ScratchLength, cleared before the call
+        */
+        typedef void (*Proc)(void* data, s32 worker, s32 numWorkers, LSfloat* pcm, LSfloat* bus);
+
+        DecodePool();
+        ~DecodePool();
+
+        /**
+        @param numWorkers ... including the calling thread
+        */
+        bool create(s32 numWorkers);
+        void destroy();
+
+        inline s32 getNumWorkers() const;
+
+        /**
+        @brief Run proc on numWorkers workers and wait for all of them
+        @param numWorkers ... clamped to [1, getNumWorkers()]
+        */
+        void run(Proc proc, void* data, s32 numWorkers);
+
+        /**
+        @brief Add partial buses of the last run to the mixer
+        */
+        void gather(Mixer& mixer);
+    private:
+        DecodePool(const DecodePool&);
+        DecodePool& operator=(const DecodePool&);
+
+        struct Scratch
+        {
+            LIME_ALIGN16 LSfloat pcm_[ScratchLength];
+            LIME_ALIGN16 LSfloat bus_[ScratchLength];
+        };
+
+        class Worker : public lcore::Thread
+        {
+        public:
+            Worker();
+            virtual ~Worker();
+
+            void kick();
+            void wait();
+            void exit();
+
+            DecodePool* pool_;
+            s32 index_;
+        protected:
+            virtual void run();
+
+        private:
+            lcore::Event startEvent_;
+            lcore::Event doneEvent_;
+        };
+
+        void execute(s32 worker);
+
+        s32 numWorkers_;
+        s32 numRunning_;
+        Proc proc_;
+        void* data_;
+        Scratch* scratches_;
+        Worker* workers_;
+    };
+
+    inline s32 DecodePool::getNumWorkers() const
+    {
+        return numWorkers_;
+    }
+}
+#endif //INC_LSOUND_DECODEPOOL_H__
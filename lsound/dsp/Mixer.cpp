@@ -0,0 +1,189 @@
+/**
+@file Mixer.cpp
+@author t-sakai
+@date 2015/08/05 create
+*/
+#include "Mixer.h"
+#include <lcore/CLibrary.h>
+
+namespace lsound
+{
+    Mixer::Mixer()
+        :dstNumChannels_(0)
+        ,dstBytesPerSample_(0)
+        ,dstSamplesPerSec_(0)
+        ,outStart_(0)
+        ,outEnd_(0)
+        ,resampler_(NULL)
+        ,ditherFunc_(NULL)
+    {
+        initializeDither(dither_, 0x5EED1234U);
+    }
+
+    Mixer::~Mixer()
+    {
+        destroy();
+    }
+
+    bool Mixer::create(u16 dstNumChannels, u16 dstBytesPerSample, s32 dstSamplesPerSec, Polyphase::Quality quality)
+    {
+        LASSERT(Channels_Mono == dstNumChannels || Channels_Stereo == dstNumChannels);
+        LASSERT(2 == dstBytesPerSample || 4 == dstBytesPerSample);
+
+        destroy();
+        if(dstSamplesPerSec<=0 || MaxDstSamplesPerSec<dstSamplesPerSec){
+            return false;
+        }
+        dstNumChannels_ = dstNumChannels;
+        dstBytesPerSample_ = dstBytesPerSample;
+        dstSamplesPerSec_ = dstSamplesPerSec;
+        if(NULL == ditherFunc_){
+            ditherFunc_ = getDitherFunc(false);
+        }
+
+        if(BusSamplesPerSec != dstSamplesPerSec_ && !polyphase_.create(BusNumChannels, BusSamplesPerSec, dstSamplesPerSec_, quality, BlockFrames)){
+            resampler_ = speex_resampler_init(BusNumChannels, BusSamplesPerSec, dstSamplesPerSec_, SPEEX_RESAMPLER_QUALITY_DEFAULT, NULL);
+            if(NULL == resampler_){
+                return false;
+            }
+        }
+        reset();
+        return true;
+    }
+
+    void Mixer::destroy()
+    {
+        polyphase_.destroy();
+        if(NULL != resampler_){
+            speex_resampler_destroy(resampler_);
+            resampler_ = NULL;
+        }
+        dstNumChannels_ = 0;
+        dstBytesPerSample_ = 0;
+        dstSamplesPerSec_ = 0;
+    }
+
+    void Mixer::reset()
+    {
+        outStart_ = outEnd_ = 0;
+        polyphase_.reset();
+        if(NULL != resampler_){
+            speex_resampler_reset_mem(resampler_);
+        }
+    }
+
+    void Mixer::setNoiseShaping(bool enable)
+    {
+        ditherFunc_ = getDitherFunc(enable);
+    }
+
+    void Mixer::beginBlock()
+    {
+        lcore::memset(bus_, 0, sizeof(bus_));
+    }
+
+    void Mixer::mix(const LSfloat* pcm, u32 numFrames, f32 gain)
+    {
+        accumulate(bus_, pcm, numFrames, gain);
+    }
+
+    void Mixer::mix(const LSfloat* bus)
+    {
+        LASSERT(NULL != bus);
+        for(u32 i=0; i<(BlockFrames*BusNumChannels); ++i){
+            bus_[i] += bus[i];
+        }
+    }
+
+    void Mixer::accumulate(LSfloat* bus, const LSfloat* pcm, u32 numFrames, f32 gain)
+    {
+        LASSERT(NULL != bus);
+        LASSERT(NULL != pcm);
+        LASSERT(numFrames<=BlockFrames);
+
+        u32 numSamples = numFrames*BusNumChannels;
+        for(u32 i=0; i<numSamples; ++i){
+            bus[i] += gain * pcm[i];
+        }
+    }
+
+    void Mixer::endBlock()
+    {
+        //Move remaining frames to the top
+        if(0<outStart_){
+            u32 remain = outEnd_ - outStart_;
+            memmove(out_, out_ + outStart_*BusNumChannels, sizeof(LSfloat)*remain*BusNumChannels);
+            outStart_ = 0;
+            outEnd_ = remain;
+        }
+        LASSERT(outEnd_+MaxBlockOutFrames <= OutFrames);
+
+        LSfloat* out = out_ + outEnd_*BusNumChannels;
+        if(polyphase_.valid()){
+            u32 inN = BlockFrames;
+            u32 outN = MaxBlockOutFrames;
+            polyphase_.process(bus_, inN, out, outN);
+            outEnd_ += outN;
+            return;
+        }
+        if(NULL == resampler_){
+            lcore::memcpy(out, bus_, sizeof(bus_));
+            outEnd_ += BlockFrames;
+            return;
+        }
+
+        //Resample once on the master bus
+        spx_uint32_t inN = BlockFrames;
+        spx_uint32_t outN = MaxBlockOutFrames;
+        speex_resampler_process_interleaved_float(resampler_, bus_, &inN, out, &outN);
+        outEnd_ += outN;
+    }
+
+    u32 Mixer::read(void* dst, u32 numFrames, f32 gain)
+    {
+        LASSERT(NULL != dst);
+        numFrames = lcore::minimum(numFrames, getNumAvailableFrames());
+        const LSfloat* src = out_ + outStart_*BusNumChannels;
+
+        switch(dstBytesPerSample_)
+        {
+        case 2:
+            {
+                //The only quantization of the pipeline
+                LSshort* d = reinterpret_cast<LSshort*>(dst);
+                if(Channels_Stereo == dstNumChannels_){
+                    ditherFunc_(d, src, numFrames*BusNumChannels, BusNumChannels, gain, dither_);
+                }else{
+                    LIME_ALIGN16 LSfloat mono[DownmixFrames];
+                    for(u32 i=0; i<numFrames; i+=DownmixFrames){
+                        u32 n = lcore::minimum(numFrames-i, DownmixFrames);
+                        conv_Float2ToFloat1(mono, src + i*BusNumChannels, n);
+                        ditherFunc_(d+i, mono, n, Channels_Mono, gain, dither_);
+                    }
+                }
+            }
+            break;
+        case 4:
+            {
+                LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+                if(Channels_Stereo == dstNumChannels_){
+                    u32 numSamples = numFrames*BusNumChannels;
+                    for(u32 i=0; i<numSamples; ++i){
+                        d[i] = lcore::clamp(gain*src[i], -1.0f, 1.0f);
+                    }
+                }else{
+                    f32 g = 0.5f*gain;
+                    for(u32 i=0; i<numFrames; ++i){
+                        d[i] = lcore::clamp(g*(src[2*i+0] + src[2*i+1]), -1.0f, 1.0f);
+                    }
+                }
+            }
+            break;
+        default:
+            LASSERT(false);
+            return 0;
+        }
+        outStart_ += numFrames;
+        return numFrames;
+    }
+}
@@ -0,0 +1,132 @@
+#ifndef INC_LSOUND_MIXER_H__
+#define INC_LSOUND_MIXER_H__
+/**
+@file Mixer.h
+@author t-sakai
+@date 2015/08/05 create
+*/
+#include "../lsound.h"
+#include "dsp.h"
+#include "Polyphase.h"
+#include <speex/speex_resampler.h>
+
+namespace lsound
+{
+    /**
+    @brief Software mixer. Sums all voices on a 48kHz stereo bus, then resamples and converts once for the device.
+    Voices stay in float until read, where 16bit devices get the only dither and quantization.
+    Device rates which Polyphase supports are resampled by it, the rest by speex.
+
+    Only a few blocks are held, so a device period is filled by reading each block out before mixing the next,
+    @code
+    while(0<request){
+        if(mixer.getNumAvailableFrames()<=0){
+            mixer.beginBlock();
+            for each voice: mixer.mix(pcm, numFrames, gain);
+            mixer.endBlock();
+        }
+        u32 n = mixer.read(dst, request, gain);
+        dst += n frames;
+        request -= n;
+    }
+    @endcode
+    */
+    class Mixer
+    {
+    public:
+        static const s32 BusSamplesPerSec = SampleRate_48000;
+        static const u16 BusNumChannels = Channels_Stereo;
+        /// 20ms at 48kHz, a multiple of opus frame sizes
+        static const u32 BlockFrames = 960;
+        static const s32 MaxDstSamplesPerSec = SampleRate_96000;
+
+        Mixer();
+        ~Mixer();
+
+        bool create(u16 dstNumChannels, u16 dstBytesPerSample, s32 dstSamplesPerSec, Polyphase::Quality quality=Polyphase::Quality_Default);
+        void destroy();
+        void reset();
+
+        /**
+        @brief Shape the dither of 16bit output out of the most audible band
+        */
+        void setNoiseShaping(bool enable);
+
+        inline u16 getDstNumChannels() const;
+        inline u16 getDstBytesPerSample() const;
+        inline s32 getDstSamplesPerSec() const;
+
+        /// Frames at the device rate which can be read without mixing
+        inline u32 getNumAvailableFrames() const;
+
+        void beginBlock();
+
+        /**
+        @brief Add a voice into the bus
+        @param pcm ... interleaved stereo at the bus rate
+        @param numFrames ... less than or equal to BlockFrames
+        */
+        void mix(const LSfloat* pcm, u32 numFrames, f32 gain);
+
+        /**
+        @brief Add a partial bus of BlockFrames frames
+        */
+        void mix(const LSfloat* bus);
+        void endBlock();
+
+        /**
+        @brief Add a voice into a bus which has the same layout as the mixer's bus
+        */
+        static void accumulate(LSfloat* bus, const LSfloat* pcm, u32 numFrames, f32 gain);
+
+        /**
+        @brief Read mixed frames in the device format
+        @return number of frames
+        */
+        u32 read(void* dst, u32 numFrames, f32 gain);
+    private:
+        Mixer(const Mixer&);
+        Mixer& operator=(const Mixer&);
+
+        static const u32 MaxBlockOutFrames = BlockFrames*(MaxDstSamplesPerSec/BusSamplesPerSec) + 16;
+        static const u32 OutFrames = MaxBlockOutFrames*2;
+        /// Frames of mono output downmixed at once before quantization
+        static const u32 DownmixFrames = 256;
+
+        u16 dstNumChannels_;
+        u16 dstBytesPerSample_;
+        s32 dstSamplesPerSec_;
+
+        u32 outStart_;
+        u32 outEnd_;
+        Polyphase polyphase_;
+        SpeexResamplerState* resampler_;
+        DitherFunc ditherFunc_;
+        DitherState dither_;
+
+        LIME_ALIGN16 LSfloat bus_[BlockFrames*BusNumChannels];
+        LIME_ALIGN16 LSfloat resampled_[MaxBlockOutFrames*BusNumChannels];
+        LIME_ALIGN16 LSfloat out_[OutFrames*BusNumChannels];
+    };
+
+    inline u16 Mixer::getDstNumChannels() const
+    {
+        return dstNumChannels_;
+    }
+
+    inline u16 Mixer::getDstBytesPerSample() const
+    {
+        return dstBytesPerSample_;
+    }
+
+    inline s32 Mixer::getDstSamplesPerSec() const
+    {
+        return dstSamplesPerSec_;
+    }
+
+    inline u32 Mixer::getNumAvailableFrames() const
+    {
+        return outEnd_ - outStart_;
+    }
+}
+#endif //INC_LSOUND_MIXER_H__
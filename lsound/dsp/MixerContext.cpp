@@ -0,0 +1,743 @@
+/**
+@file MixerContext.cpp
+@author t-sakai
+@date 2015/08/18 create
+*/
+#include "MixerContext.h"
+#include <lcore/CLibrary.h>
+#include "../opus/Stream.h"
+#include "../opus/Resource.h"
+#include "UserPlayer.h"
+
+namespace lsound
+{
+    MixerContext::MixerContext(const InitParam& initParam)
+        :initParam_(initParam)
+        ,streamSize_(0)
+        ,streams_(NULL)
+        ,players_(NULL)
+        ,playing_(NULL)
+        ,starting_(NULL)
+        ,activeResults_(NULL)
+        ,numStarting_(0)
+        ,keys_(NULL)
+        ,numVirtual_(0)
+        ,userPlayers_(NULL)
+        ,numRequests_(0)
+        ,requestList_(-1)
+        ,window_(0)
+        ,numPlaying_(0)
+    {
+        for(s32 i=0; i<NumMaxPacks; ++i){
+            packResources_[i] = NULL;
+        }
+        for(s32 i=0; i<NumTriggerSlots; ++i){
+            triggers_[i].sound_ = 0;
+            triggers_[i].window_ = -1;
+            triggers_[i].handle_ = InvalidHandle;
+        }
+    }
+
+    MixerContext::~MixerContext()
+    {
+        for(s32 i=0; i<NumMaxPacks; ++i){
+            LIME_DELETE(packResources_[i]);
+        }
+    }
+
+    bool MixerContext::createVoices(u16 numChannels, u16 bytesPerSample, s32 samplesPerSec)
+    {
+        if(!mixer_.create(numChannels, bytesPerSample, samplesPerSec)){
+            return false;
+        }
+        mixer_.setNoiseShaping(initParam_.noiseShaping_);
+        initStreams();
+        initPlayers();
+        initUserPlayers();
+        decodePool_.create(initParam_.numDecodeWorkers_);
+        return true;
+    }
+
+    void MixerContext::destroyVoices()
+    {
+        decodePool_.destroy();
+        LIME_DELETE_ARRAY(userPlayers_);
+        LIME_DELETE_ARRAY(keys_);
+        LIME_DELETE_ARRAY(activeResults_);
+        LIME_DELETE_ARRAY(starting_);
+        LIME_DELETE_ARRAY(playing_);
+        LIME_DELETE_ARRAY(players_);
+        voices_.destroy();
+
+        streamPool_.destroy();
+        LIME_DELETE_ARRAY(streams_);
+
+        mixer_.destroy();
+    }
+
+    void MixerContext::clear()
+    {
+        lcore::CSLock lock(contextLock_);
+
+        for(s32 i=0; i<numPlaying_; ++i){
+            Player* current = &players_[playing_[i]];
+            current->clear();
+            releasePlayer(current);
+        }
+        numPlaying_ = 0;
+
+        s32 request = getRequestList();
+        while(0<=request){
+            Player* current = &players_[request];
+            request = current->next_;
+            current->clear();
+            releasePlayer(current);
+        }
+    }
+
+    void MixerContext::mixBlock()
+    {
+        selectVoices();
+
+        //Decode on workers, each one sums its players into its own partial bus
+        s32 numWorkers = (numPlaying_ - numVirtual_ + MinPlayersPerWorker - 1)/MinPlayersPerWorker;
+        decodePool_.run(decodeProc, this, numWorkers);
+
+        mixer_.beginBlock();
+        decodePool_.gather(mixer_);
+        mixer_.endBlock();
+
+        //Pack playing ones to the front, keeping their order
+        s32 count = 0;
+        for(s32 i=0; i<numPlaying_; ++i){
+            if(activeResults_[i]){
+                playing_[count] = playing_[i];
+                ++count;
+                continue;
+            }
+            Player* current = &players_[playing_[i]];
+            current->clear();
+            releasePlayer(current);
+        }
+        numPlaying_ = count;
+    }
+
+    void MixerContext::selectVoices()
+    {
+        static const u32 AudibilityMask = 0xFFFFFFU;
+
+        for(s32 i=0; i<numPlaying_; ++i){
+            u16 index = playing_[i];
+            f32 audibility = lcore::clamp01(voices_.gains_[index]*voices_.loudness_[index]);
+            keys_[index] = (static_cast<u32>(voices_.priorities_[index])<<24) | static_cast<u32>(audibility*AudibilityMask);
+        }
+
+        //Insertion sort, the order hardly changes between blocks
+        for(s32 i=1; i<numPlaying_; ++i){
+            u16 index = playing_[i];
+            u32 key = keys_[index];
+            s32 j = i;
+            for(; 0<j && keys_[playing_[j-1]]<key; --j){
+                playing_[j] = playing_[j-1];
+            }
+            playing_[j] = index;
+        }
+
+        u32 threshold = static_cast<u32>(lcore::clamp01(initParam_.virtualThreshold_)*AudibilityMask);
+        s32 maxReal = (0<initParam_.maxRealVoices_)? initParam_.maxRealVoices_ : numPlaying_;
+        s32 numReal = 0;
+        numVirtual_ = 0;
+        for(s32 i=0; i<numPlaying_; ++i){
+            u16 index = playing_[i];
+            bool isVirtual = (maxReal<=numReal) || ((keys_[index] & AudibilityMask)<threshold);
+            players_[index].setVirtual(isVirtual);
+            if(isVirtual){
+                ++numVirtual_;
+            }else if(State_Playing == voices_.states_[index]){
+                ++numReal;
+            }
+        }
+
+        //Stop one-shot virtual voices from the least valuable, while free players run short
+        s32 numFree = freePlayers_.size();
+        for(s32 i=numPlaying_-1; 0<=i && numFree<NumCullReserve; --i){
+            u16 index = playing_[i];
+            if(!players_[index].checkInnerFlag(Player::InnerFlag_Virtual)){
+                break;
+            }
+            if(NULL != players_[index].userPlayer_ || (voices_.userFlags_[index] & PlayerFlag_Loop)){
+                continue;
+            }
+            //Released after this block
+            voices_.states_[index] = State_Stopped;
+            ++numFree;
+        }
+    }
+
+    void MixerContext::decodeProc(void* data, s32 worker, s32 numWorkers, LSfloat* pcm, LSfloat* bus)
+    {
+        MixerContext* context = reinterpret_cast<MixerContext*>(data);
+        for(s32 i=worker; i<context->numPlaying_; i+=numWorkers){
+            Player& player = context->players_[context->playing_[i]];
+            context->activeResults_[i] = (player.update(bus, pcm, Mixer::BlockFrames))? 1 : 0;
+        }
+    }
+
+    void MixerContext::startRequests()
+    {
+        //Stream slots are made and released here, not in play
+        streamPool_.update(initParam_.poolTrimDelay_);
+
+        //Later plays do not merge into the requests taken here.
+        //play merges gains under the lock, so the window closes and the list is taken at once
+        s32 request;
+        {
+            lcore::CSLock lock(contextLock_);
+            ++window_;
+            request = getRequestList();
+        }
+        if(request<0){
+            return;
+        }
+
+        numStarting_ = 0;
+        while(0<=request){
+            starting_[numStarting_] = static_cast<u16>(request);
+            ++numStarting_;
+            request = players_[request].next_;
+        }
+        limitInstances();
+
+        //Open streams on workers, opening parses headers and reads files
+        decodePool_.run(startProc, this, numStarting_);
+
+        for(s32 i=0; i<numStarting_; ++i){
+            if(activeResults_[i]){
+                playing_[numPlaying_] = starting_[i];
+                ++numPlaying_;
+            }else{
+                releasePlayer(&players_[starting_[i]]);
+            }
+        }
+    }
+
+    void MixerContext::limitInstances()
+    {
+        s32 count = 0;
+        for(s32 i=0; i<numStarting_; ++i){
+            u16 index = starting_[i];
+            u8 maxInstances = voices_.maxInstances_[index];
+            if(maxInstances<=0){
+                starting_[count] = index;
+                ++count;
+                continue;
+            }
+
+            u32 sound = voices_.sounds_[index];
+            u8 polyphony = voices_.polyphonies_[index];
+            s32 numInstances = 0;
+            s32 victim = -1;
+            for(s32 j=0; j<numPlaying_; ++j){
+                u16 other = playing_[j];
+                if(sound != voices_.sounds_[other] || voices_.maxInstances_[other]<=0 || State_Stopped == voices_.states_[other]){
+                    continue;
+                }
+                ++numInstances;
+                if(victim<0){
+                    victim = other;
+                }else if(Polyphony_StealOldest == polyphony){
+                    if(voices_.positions_[victim]<voices_.positions_[other]){
+                        victim = other;
+                    }
+                }else if(voices_.gains_[other]<voices_.gains_[victim]){
+                    victim = other;
+                }
+            }
+            for(s32 j=0; j<count; ++j){
+                if(sound == voices_.sounds_[starting_[j]]){
+                    ++numInstances;
+                }
+            }
+
+            if(maxInstances<=numInstances){
+                if(Polyphony_Reject == polyphony || victim<0){
+                    releasePlayer(&players_[index]);
+                    continue;
+                }
+                //Released after the next block
+                voices_.states_[victim] = State_Stopped;
+            }
+            starting_[count] = index;
+            ++count;
+        }
+        numStarting_ = count;
+    }
+
+    void MixerContext::startProc(void* data, s32 worker, s32 numWorkers, LSfloat* /*pcm*/, LSfloat* /*bus*/)
+    {
+        MixerContext* context = reinterpret_cast<MixerContext*>(data);
+        for(s32 i=worker; i<context->numStarting_; i+=numWorkers){
+            context->activeResults_[i] = (context->initPlayer(&context->players_[context->starting_[i]]))? 1 : 0;
+        }
+    }
+
+    bool MixerContext::initPlayer(Player* player)
+    {
+        return player->initialize();
+    }
+
+    s32 MixerContext::loadResourcePack(s32 id, const Char* path, bool stream)
+    {
+        LASSERT(0<=id && id<NumMaxPacks);
+        lcore::CSLock lock(contextLock_);
+
+        PackResource* packResource = NULL;
+        if(stream){
+            packResource = PackFile::open(path, initParam_.readBlockSize_, initParam_.numReadBlocks_);
+        }else{
+            packResource = PackMemory::open(path);
+        }
+
+        if(NULL == packResource){
+            return -1;
+        }
+
+        LIME_DELETE(packResources_[id]);
+        packResources_[id] = packResource;
+        return id;
+    }
+
+    s32 MixerContext::mapResourcePack(s32 id, const Char* path)
+    {
+        LASSERT(0<=id && id<NumMaxPacks);
+        lcore::CSLock lock(contextLock_);
+
+        PackResource* packResource = PackMapped::open(path);
+        if(NULL == packResource){
+            return -1;
+        }
+
+        LIME_DELETE(packResources_[id]);
+        packResources_[id] = packResource;
+        return id;
+    }
+
+    s32 MixerContext::cacheResourcePack(s32 id, f32 maxSeconds, bool half)
+    {
+        LASSERT(0<=id && id<NumMaxPacks);
+        lcore::CSLock lock(contextLock_);
+
+        PackResource* packResource = packResources_[id];
+        if(NULL == packResource || PackResource::ResourceType_Memory != packResource->getType()){
+            return 0;
+        }
+        u32 maxFrames = static_cast<u32>(maxSeconds * Mixer::BusSamplesPerSec);
+        PcmBlock::Format format = (half)? PcmBlock::Format_Half : PcmBlock::Format_Short;
+        return reinterpret_cast<PackMemory*>(packResource)->cache(maxFrames, format);
+    }
+
+    void MixerContext::setPriority(s32 packId, s32 id, u8 priority)
+    {
+        LASSERT(0<=packId && packId<NumMaxPacks);
+        lcore::CSLock lock(contextLock_);
+
+        PackResource* packResource = packResources_[packId];
+        if(NULL == packResource || id<0 || packResource->getNumFiles()<=id){
+            return;
+        }
+        packResource->setPriority(id, priority);
+    }
+
+    void MixerContext::setLoudness(s32 packId, s32 id, f32 loudness)
+    {
+        LASSERT(0<=packId && packId<NumMaxPacks);
+        lcore::CSLock lock(contextLock_);
+
+        PackResource* packResource = packResources_[packId];
+        if(NULL == packResource || id<0 || packResource->getNumFiles()<=id){
+            return;
+        }
+        packResource->setLoudness(id, loudness);
+    }
+
+    void MixerContext::setPolyphony(s32 packId, s32 id, u8 maxInstances, Polyphony polyphony)
+    {
+        LASSERT(0<=packId && packId<NumMaxPacks);
+        lcore::CSLock lock(contextLock_);
+
+        PackResource* packResource = packResources_[packId];
+        if(NULL == packResource || id<0 || packResource->getNumFiles()<=id){
+            return;
+        }
+        packResource->setPolyphony(id, maxInstances, polyphony);
+    }
+
+    Handle MixerContext::play(s32 packId, s32 id, f32 gain)
+    {
+        LASSERT(0<=packId && packId<NumMaxPacks);
+        LASSERT(0<=id);
+        lcore::CSLock lock(contextLock_);
+
+        PackResource* packResource = packResources_[packId];
+        if(NULL == packResource){
+            return InvalidHandle;
+        }
+        if(packResource->getNumFiles()<=id){
+            return InvalidHandle;
+        }
+
+        //Merge into the voice of the same entry requested in this window
+        u32 sound = getSound(packId, id);
+        s32 window = window_;
+        Trigger& trigger = triggers_[(sound ^ (sound>>11)) & (NumTriggerSlots-1)];
+        if(sound == trigger.sound_ && window == trigger.window_ && isPlaying(trigger.handle_)){
+            f32& voiceGain = voices_.gains_[getHandleIndex(trigger.handle_)];
+            voiceGain = lcore::maximum(voiceGain, lcore::minimum(voiceGain+gain, 1.0f));
+            return trigger.handle_;
+        }
+
+        PcmBlock* pcm = getPcm(packResource, id);
+        Player* player = getPlayer();
+        if(NULL == player){
+            return InvalidHandle;
+        }
+        StreamEntry* streamEntry = NULL;
+        if(NULL == pcm){
+            streamEntry = getStream();
+            if(NULL == streamEntry){
+                releasePlayer(player);
+                return InvalidHandle;
+            }
+        }
+
+        if(NULL != pcm){
+            pcm->addRef();
+            player->setPcm(pcm);
+        }else{
+            Stream* stream = createStream(streamEntry, packResource, id);
+            if(NULL == stream){
+                releasePlayer(player);
+                return InvalidHandle;
+            }
+            player->setStream(stream);
+            player->setInnerFlag(Player::InnerFlag_Open);
+        }
+        player->setGain(gain);
+        voices_.priorities_[player->index_] = packResource->getPriority(id);
+        voices_.loudness_[player->index_] = packResource->getLoudness(id);
+        voices_.sounds_[player->index_] = sound;
+        voices_.maxInstances_[player->index_] = packResource->getMaxInstances(id);
+        voices_.polyphonies_[player->index_] = packResource->getPolyphony(id);
+        player->clear();
+
+        Handle handle = player->getHandle();
+        trigger.sound_ = sound;
+        trigger.window_ = window;
+        trigger.handle_ = handle;
+        addRequest(player);
+        return handle;
+    }
+
+    Handle MixerContext::createUserPlayer(s32 packId, s32 id)
+    {
+        LASSERT(0<=packId && packId<NumMaxPacks);
+        LASSERT(0<=id);
+        lcore::CSLock lock(contextLock_);
+
+        PackResource* packResource = packResources_[packId];
+        if(NULL == packResource){
+            return InvalidHandle;
+        }
+        if(packResource->getNumFiles()<=id){
+            return InvalidHandle;
+        }
+
+        PcmBlock* pcm = getPcm(packResource, id);
+        UserPlayer* userPlayer = getUserPlayer();
+        if(NULL == userPlayer){
+            return InvalidHandle;
+        }
+        Player* player = getPlayer();
+        if(NULL == player){
+            releaseUserPlayer(userPlayer);
+            return InvalidHandle;
+        }
+        StreamEntry* streamEntry = NULL;
+        if(NULL == pcm){
+            streamEntry = getStream();
+            if(NULL == streamEntry){
+                releaseUserPlayer(userPlayer);
+                releasePlayer(player);
+                return InvalidHandle;
+            }
+        }
+
+        if(NULL != pcm){
+            pcm->addRef();
+            player->setPcm(pcm);
+        }else{
+            Stream* stream = createStream(streamEntry, packResource, id);
+            if(NULL == stream){
+                releaseUserPlayer(userPlayer);
+                releasePlayer(player);
+                return InvalidHandle;
+            }
+            player->setStream(stream);
+            player->setInnerFlag(Player::InnerFlag_Open);
+        }
+        player->setGain(1.0f);
+        voices_.priorities_[player->index_] = packResource->getPriority(id);
+        voices_.loudness_[player->index_] = packResource->getLoudness(id);
+        voices_.sounds_[player->index_] = getSound(packId, id);
+        voices_.maxInstances_[player->index_] = 0;
+        player->setInnerFlag(Player::InnerFlag_UserPlayer);
+
+        player->clear();
+        player->userPlayer_ = userPlayer;
+        //Released by the caller and the player each
+        lcore::atomicIncrement(&userPlayer->refCount_);
+
+        Handle handle = makeHandle(static_cast<s32>(userPlayer - userPlayers_), static_cast<u16>(userPlayer->generation_));
+        addRequest(player);
+        return handle;
+    }
+
+    void MixerContext::destroyUserPlayer(Handle handle)
+    {
+        UserPlayer* player = findUserPlayer(handle);
+        if(NULL == player){
+            return;
+        }
+        //Reject the handle from now, only the caller retiring its generation releases the reference.
+        //The slot is reused after the player releases it too
+        s32 generation = getHandleGeneration(handle);
+        if(generation != lcore::atomicCompareExchange(&player->generation_, nextGeneration(static_cast<u16>(generation)), generation)){
+            return;
+        }
+        //The player stops at the next update, then releases its reference
+        lcore::atomicExchange(&player->request_, UserPlayer::Request_Stop);
+        releaseUserPlayer(player);
+    }
+
+    PcmBlock* MixerContext::getPcm(PackResource* packResource, s32 id)
+    {
+        if(PackResource::ResourceType_Memory != packResource->getType()){
+            return NULL;
+        }
+        return reinterpret_cast<PackMemory*>(packResource)->getPcm(id);
+    }
+
+    Stream* MixerContext::createStream(StreamEntry* streamEntry, PackResource* packResource, s32 id)
+    {
+        Stream* stream;
+        switch(packResource->getType())
+        {
+        case PackResource::ResourceType_File:
+            {
+                FileStream* fileStream = LIME_PLACEMENT_NEW(streamEntry+1) FileStream();
+                PackFile* packFile = reinterpret_cast<PackFile*>(packResource);
+                File* file;
+                s32 start, end;
+                packFile->get(id, file, start, end);
+                fileStream->set(file, start, end);
+                packResource->setStreamInfo(id, *fileStream);
+                stream = fileStream;
+            }
+            break;
+
+        case PackResource::ResourceType_Memory:
+            {
+                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry+1) MemoryStream();
+                PackMemory* packMemory = reinterpret_cast<PackMemory*>(packResource);
+                Memory* memory;
+                u32 size;
+                s32 offset;
+                packMemory->get(id, memory, size, offset);
+                memoryStream->set(size, offset, memory);
+                packResource->setStreamInfo(id, *memoryStream);
+                stream = memoryStream;
+            }
+            break;
+
+        case PackResource::ResourceType_Mapped:
+            {
+                MemoryStream* memoryStream = LIME_PLACEMENT_NEW(streamEntry+1) MemoryStream();
+                PackMapped* packMapped = reinterpret_cast<PackMapped*>(packResource);
+                Memory* memory;
+                u32 size;
+                s32 offset;
+                packMapped->get(id, memory, size, offset);
+                packMapped->prefetch(id);
+                memoryStream->set(size, offset, memory);
+                packResource->setStreamInfo(id, *memoryStream);
+                stream = memoryStream;
+            }
+            break;
+
+        default:
+            streamPool_.push(streamEntry->index_);
+            return NULL;
+        }
+
+        return stream;
+    }
+
+    void MixerContext::initStreams()
+    {
+        LASSERT(NULL == streams_);
+        streamSize_ = lcore::maximum(sizeof(FileStream), sizeof(MemoryStream));
+        streams_ = LIME_NEW StreamEntry*[initParam_.maxPlayers_];
+        for(s32 i=0; i<initParam_.maxPlayers_; ++i){
+            streams_[i] = NULL;
+        }
+        streamPool_.create(initParam_.maxPlayers_, initParam_.poolChunkSize_, createStreamProc, destroyStreamProc, this);
+    }
+
+    void MixerContext::initPlayers()
+    {
+        LASSERT(NULL == players_);
+        players_ = LIME_NEW Player[initParam_.maxPlayers_];
+        voices_.create(initParam_.maxPlayers_);
+        for(s32 i=0; i<initParam_.maxPlayers_; ++i){
+            players_[i].table_ = &voices_;
+            players_[i].index_ = static_cast<u16>(i);
+        }
+        playing_ = LIME_NEW u16[initParam_.maxPlayers_];
+        starting_ = LIME_NEW u16[initParam_.maxPlayers_];
+        activeResults_ = LIME_NEW u8[initParam_.maxPlayers_];
+        keys_ = LIME_NEW u32[initParam_.maxPlayers_];
+        freePlayers_.initialize(initParam_.maxPlayers_);
+    }
+
+    void MixerContext::initUserPlayers()
+    {
+        LASSERT(NULL == userPlayers_);
+        userPlayers_ = LIME_NEW UserPlayer[initParam_.maxUserPlayers_];
+        freeUserPlayers_.initialize(initParam_.maxUserPlayers_);
+    }
+
+    bool MixerContext::createStreamProc(s32 index, void* data)
+    {
+        MixerContext* context = reinterpret_cast<MixerContext*>(data);
+        void* memory = LIME_MALLOC(sizeof(StreamEntry) + context->streamSize_);
+        if(NULL == memory){
+            return false;
+        }
+        StreamEntry* entry = reinterpret_cast<StreamEntry*>(memory);
+        entry->index_ = index;
+        context->streams_[index] = entry;
+        return true;
+    }
+
+    void MixerContext::destroyStreamProc(s32 index, void* data)
+    {
+        MixerContext* context = reinterpret_cast<MixerContext*>(data);
+        LIME_FREE(context->streams_[index]);
+    }
+
+    MixerContext::StreamEntry* MixerContext::getStream()
+    {
+        s32 index = streamPool_.pop();
+        return (index<0)? NULL : streams_[index];
+    }
+
+    void MixerContext::releaseStream(Stream* stream)
+    {
+        LASSERT(NULL != stream);
+        stream->~Stream();
+        StreamEntry* entry = reinterpret_cast<StreamEntry*>(stream) - 1;
+        streamPool_.push(entry->index_);
+    }
+
+    Player* MixerContext::getPlayer()
+    {
+        s32 index = freePlayers_.pop();
+        if(index<0){
+            return NULL;
+        }
+        Player* player = &players_[index];
+        voices_.userFlags_[index] = 0;
+        voices_.innerFlags_[index] = 0;
+        voices_.states_[index] = State_Initial;
+        player->userPlayer_ = NULL;
+        return player;
+    }
+
+    void MixerContext::releasePlayer(Player* player)
+    {
+        LASSERT(NULL != player);
+
+        Stream*& stream = voices_.streams_[player->index_];
+        if(NULL != stream){
+            releaseStream(stream);
+            stream = NULL;
+        }
+        if(NULL != player->pcm_){
+            player->pcm_->release();
+            player->pcm_ = NULL;
+        }
+        if(NULL != player->userPlayer_){
+            player->userPlayer_->publish(State_Stopped, voices_.positions_[player->index_], 0.0f);
+            releaseUserPlayer(player->userPlayer_);
+            player->userPlayer_ = NULL;
+        }
+        player->generation_ = nextGeneration(player->generation_);
+        freePlayers_.push(player->index_);
+    }
+
+    UserPlayer* MixerContext::getUserPlayer()
+    {
+        s32 index = freeUserPlayers_.pop();
+        if(index<0){
+            return NULL;
+        }
+        UserPlayer* player = &userPlayers_[index];
+        player->reset();
+        return player;
+    }
+
+    void MixerContext::releaseUserPlayer(UserPlayer* player)
+    {
+        LASSERT(NULL != player);
+        if(0 == lcore::atomicDecrement(&player->refCount_)){
+            freeUserPlayers_.push(static_cast<s32>(player - userPlayers_));
+        }
+    }
+
+    void MixerContext::addRequest(Player* player)
+    {
+        LASSERT(NULL != player);
+        for(;;){
+            s32 top = requestList_;
+            player->next_ = top;
+            if(top == lcore::atomicCompareExchange(&requestList_, player->index_, top)){
+                break;
+            }
+        }
+        lcore::atomicIncrement(&numRequests_);
+    }
+
+    s32 MixerContext::getRequestList()
+    {
+        return lcore::atomicExchange(&requestList_, -1);
+    }
+
+    UserPlayer* MixerContext::findUserPlayer(Handle handle)
+    {
+        s32 index = getHandleIndex(handle);
+        if(initParam_.maxUserPlayers_<=index){
+            return NULL;
+        }
+        UserPlayer* player = &userPlayers_[index];
+        return (getHandleGeneration(handle) == player->generation_)? player : NULL;
+    }
+
+    bool MixerContext::isPlaying(Handle handle) const
+    {
+        s32 index = getHandleIndex(handle);
+        if(initParam_.maxPlayers_<=index){
+            return false;
+        }
+        return getHandleGeneration(handle) == players_[index].generation_;
+    }
+}
@@ -0,0 +1,253 @@
+#ifndef INC_LSOUND_MIXERCONTEXT_H__
+#define INC_LSOUND_MIXERCONTEXT_H__
+/**
+@file MixerContext.h
+@author t-sakai
+@date 2015/08/18 create
+*/
+#include "../lsound.h"
+#include <lcore/async/SyncObject.h>
+#include <lcore/async/LockFree.h>
+
+#include "../SlotPool.h"
+#include "Mixer.h"
+#include "DecodePool.h"
+#include "Player.h"
+
+namespace lsound
+{
+    class PackResource;
+    class PcmBlock;
+    class Stream;
+
+    /**
+    @brief Voices and resources of contexts which sum all players by a software mixer into one stream.
+    Derived contexts own the device, and mix blocks with mixBlock when it needs frames.
+    */
+    class MixerContext
+    {
+    public:
+        struct InitParam
+        {
+            InitParam()
+                :numQueuedBuffers_(3)
+                ,maxPlayers_(128)
+                ,poolChunkSize_(16)
+                ,poolTrimDelay_(1000)
+                ,maxRealVoices_(32)
+                ,virtualThreshold_(0.001f)
+                ,maxUserPlayers_(4)
+                ,waitTime_(30)
+                ,readBlockSize_(64*1024)
+                ,numReadBlocks_(16)
+                ,numDecodeWorkers_(2)
+                ,noiseShaping_(false)
+            {}
+
+            s32 numQueuedBuffers_;
+            s32 maxPlayers_;
+            s32 poolChunkSize_; //stream slots made at once, first in initialize then by the context when few are free
+            s32 poolTrimDelay_; //blocks mixed with many free stream slots before a chunk of them is released
+            s32 maxRealVoices_; //voices decoded at once, the rest only advance, 0 for no limit
+            f32 virtualThreshold_; //voices quieter than this are not decoded, gain x loudness
+            s32 maxUserPlayers_;
+            u32 waitTime_;
+            u32 readBlockSize_; //read-ahead block of streamed packs
+            s32 numReadBlocks_; //blocks shared by streams of a pack, 0 to read directly
+            s32 numDecodeWorkers_; //including the context thread
+            bool noiseShaping_; //shape the dither of 16bit output
+        };
+
+        void clear();
+
+        s32 loadResourcePack(s32 id, const Char* path, bool stream);
+
+        /**
+        @brief Map a pack into memory, its entries are read on demand without copying
+        */
+        s32 mapResourcePack(s32 id, const Char* path);
+
+        /**
+        @brief Decode short entries of an on-memory pack once, their players skip decoding
+        @return number of cached entries
+        @param maxSeconds ... entries longer than this are streamed as before
+        @param half ... store as 16bit float
+        */
+        s32 cacheResourcePack(s32 id, f32 maxSeconds, bool half);
+
+        /**
+        @brief Voices of an entry with higher priority are decoded first when too many play
+        */
+        void setPriority(s32 packId, s32 id, u8 priority);
+
+        /**
+        @brief Root mean square of an entry at gain 1, cached entries are measured when decoded
+        */
+        void setLoudness(s32 packId, s32 id, f32 loudness);
+
+        /**
+        @brief Limit voices of an entry playing at once
+        @param maxInstances ... 0 for no limit
+        @param polyphony ... what happens to a new voice over the limit
+        */
+        void setPolyphony(s32 packId, s32 id, u8 maxInstances, Polyphony polyphony);
+
+        /**
+        @brief Plays of the same entry before the context takes requests are merged into one voice,
+        then its gain is the sum of theirs, up to 1
+        @return handle of the voice, InvalidHandle if failed
+        */
+        Handle play(s32 packId, s32 id, f32 gain=1.0f);
+        Handle createUserPlayer(s32 packId, s32 id);
+        void destroyUserPlayer(Handle handle);
+
+        /**
+        @return NULL if the handle has been destroyed
+        */
+        UserPlayer* findUserPlayer(Handle handle);
+
+        /**
+        @brief Whether the voice has not been released yet, paused ones too
+        */
+        bool isPlaying(Handle handle) const;
+
+        inline s32 getNumPlayingPlayers() const;
+        inline s32 getNumVirtualVoices() const;
+    protected:
+        MixerContext(const InitParam& initParam);
+        ~MixerContext();
+
+        /**
+        @brief Create the mixer for the device format, then voices
+        */
+        bool createVoices(u16 numChannels, u16 bytesPerSample, s32 samplesPerSec);
+        void destroyVoices();
+
+        /// Mix a block of all playing players
+        void mixBlock();
+
+        /**
+        @brief Open streams of requested players off the caller's thread, then start them
+        */
+        void startRequests();
+
+        /// Number of requests since the last call
+        inline s32 takeNumRequests();
+
+        lcore::CriticalSection contextLock_;
+        InitParam initParam_;
+        Mixer mixer_;
+
+    private:
+        MixerContext(const MixerContext&);
+        MixerContext& operator=(const MixerContext&);
+
+        /// Players per worker below which decoding is not split further
+        static const s32 MinPlayersPerWorker = 4;
+        /// Free players kept for new requests by stopping the least valuable virtual voices
+        static const s32 NumCullReserve = 4;
+
+        /**
+        @brief Sort playing players by priority and audibility, make the rest of maxRealVoices_ virtual
+        */
+        void selectVoices();
+        static void decodeProc(void* data, s32 worker, s32 numWorkers, LSfloat* pcm, LSfloat* bus);
+
+        /**
+        @brief Drop or steal for requested players over the instance limits, before their streams are opened
+        */
+        void limitInstances();
+        static void startProc(void* data, s32 worker, s32 numWorkers, LSfloat* pcm, LSfloat* bus);
+
+        /// Header of a stream slot, streamSize_ bytes of the stream follow
+        struct StreamEntry
+        {
+            s32 index_;
+            s32 padding_[3];
+        };
+
+        /// Slots of voices requested by play in the current window, by their entries
+        static const s32 NumTriggerSlots = 64;
+
+        struct Trigger
+        {
+            u32 sound_;
+            s32 window_;
+            Handle handle_;
+        };
+
+        static inline u32 getSound(s32 packId, s32 id)
+        {
+            return (static_cast<u32>(packId)<<16) | static_cast<u32>(id);
+        }
+
+        void initStreams();
+        void initPlayers();
+        void initUserPlayers();
+
+        bool initPlayer(Player* player);
+
+        static PcmBlock* getPcm(PackResource* packResource, s32 id);
+        /// Construct a stream of an entry, it is opened later by the player
+        Stream* createStream(StreamEntry* streamEntry, PackResource* packResource, s32 id);
+
+        static bool createStreamProc(s32 index, void* data);
+        static void destroyStreamProc(s32 index, void* data);
+        StreamEntry* getStream();
+        void releaseStream(Stream* stream);
+
+        Player* getPlayer();
+        void releasePlayer(Player* player);
+
+        UserPlayer* getUserPlayer();
+        void releaseUserPlayer(UserPlayer* player);
+
+        void addRequest(Player* player);
+        /// Index of the top request, -1 if empty
+        s32 getRequestList();
+
+        DecodePool decodePool_;
+
+        u32 streamSize_;
+        SlotPool streamPool_;
+        StreamEntry** streams_; ///< NULL for slots not made
+
+        lcore::LockFreeIndexStack freePlayers_;
+        Player* players_;
+        VoiceTable voices_;
+        u16* playing_; ///< indices of playing players
+        u16* starting_; ///< indices of players being started
+        u8* activeResults_;
+        s32 numStarting_;
+        u32* keys_; ///< priority and audibility of players for selectVoices
+        s32 numVirtual_;
+
+        lcore::LockFreeIndexStack freeUserPlayers_;
+        UserPlayer* userPlayers_;
+
+        PackResource* packResources_[NumMaxPacks];
+
+        //Pushed by any thread, taken at once by the context
+        volatile s32 numRequests_;
+        volatile s32 requestList_;
+        s32 window_; ///< incremented each time the context takes requests, under contextLock_
+        Trigger triggers_[NumTriggerSlots];
+        s32 numPlaying_;
+    };
+
+    inline s32 MixerContext::getNumPlayingPlayers() const
+    {
+        return numPlaying_;
+    }
+
+    inline s32 MixerContext::getNumVirtualVoices() const
+    {
+        return numVirtual_;
+    }
+
+    inline s32 MixerContext::takeNumRequests()
+    {
+        return lcore::atomicExchange(&numRequests_, 0);
+    }
+}
+#endif //INC_LSOUND_MIXERCONTEXT_H__
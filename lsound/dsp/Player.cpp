@@ -0,0 +1,319 @@
+/**
+@file Player.cpp
+@author t-sakai
+@date 2014/07/08 create
+*/
+#include "Player.h"
+
+#include "../opus/Stream.h"
+#include "../opus/Resource.h"
+#include "Mixer.h"
+#include "UserPlayer.h"
+
+
+namespace lsound
+{
+    Player::Player()
+        :table_(NULL)
+        ,index_(0)
+        ,generation_(1)
+        ,next_(-1)
+        ,pcm_(NULL)
+        ,pcmPosition_(0)
+        ,cursor_(0)
+        ,userPlayer_(NULL)
+    {
+    }
+
+    Player::~Player()
+    {
+    }
+
+    u16 Player::getUserFlags()
+    {
+        if(NULL == userPlayer_){
+            return table_->userFlags_[index_];
+        }
+
+        return static_cast<u16>(userPlayer_->flags_);
+    }
+
+    void Player::clear()
+    {
+        Stream* stream = table_->streams_[index_];
+        if(stream && !checkInnerFlag(InnerFlag_Open)){
+            stream->seek(0);
+        }
+        pcmPosition_ = 0;
+        cursor_ = 0;
+        table_->states_[index_] = State_Initial;
+        table_->positions_[index_] = 0;
+    }
+
+    void Player::rewind()
+    {
+        Stream* stream = table_->streams_[index_];
+        if(stream && !checkInnerFlag(InnerFlag_Open)){
+            stream->seek(0);
+        }
+        pcmPosition_ = 0;
+        cursor_ = 0;
+        table_->positions_[index_] = 0;
+        table_->states_[index_] = State_Stopped;
+    }
+
+    void Player::play()
+    {
+        table_->states_[index_] = State_Playing;
+    }
+
+    void Player::pause()
+    {
+        table_->states_[index_] = State_Paused;
+    }
+
+    void Player::stop()
+    {
+        rewind();
+    }
+
+    State Player::getState()
+    {
+        return (State)table_->states_[index_];
+    }
+
+    void Player::setState(s32 state)
+    {
+        table_->states_[index_] = state;
+    }
+
+    u32 Player::getSampleOffset()
+    {
+        return table_->positions_[index_];
+    }
+
+    void Player::setPosition(f32 /*x*/, f32 /*y*/, f32 /*z*/)
+    {
+    }
+
+    void Player::setGain(f32 gain)
+    {
+        table_->gains_[index_] = gain;
+    }
+
+    void Player::setPitch(f32 /*pitch*/)
+    {
+    }
+
+    void Player::setStream(Stream* stream)
+    {
+        LASSERT(NULL == stream || Mixer::BusSamplesPerSec == stream->getSampleRate());
+        table_->streams_[index_] = stream;
+    }
+
+    void Player::setPcm(PcmBlock* pcm)
+    {
+        pcm_ = pcm;
+        pcmPosition_ = 0;
+    }
+
+    u32 Player::fill(LSfloat* pcm, u32 requestFrames, u16 userFlags)
+    {
+        if(NULL != pcm_){
+            return fillFromPcm(pcm, requestFrames, userFlags);
+        }
+        Stream* stream = table_->streams_[index_];
+        u32 readFrames = 0;
+        u32 frames = requestFrames;
+        while(readFrames<requestFrames){
+            //Float is not dithered nor quantized by the decoder
+            s32 s = stream->read_float_stereo(pcm, frames*Mixer::BusNumChannels);
+            if(s<0){
+                break;
+            }
+            readFrames += s;
+            if(stream->getTotal()<=stream->getPosition()){
+                //Reached the end, seek to the top if looping
+                if(userFlags & PlayerFlag_Loop){
+                    stream->seek(0);
+                }else{
+                    break;
+                }
+            }else if(s<=0){
+                break;
+            }
+            frames -= s;
+            pcm += s*Mixer::BusNumChannels;
+        }
+        return readFrames;
+    }
+
+    u32 Player::fillFromPcm(LSfloat* pcm, u32 requestFrames, u16 userFlags)
+    {
+        u32 readFrames = 0;
+        while(readFrames<requestFrames){
+            u32 s = pcm_->read(pcm + readFrames*Mixer::BusNumChannels, pcmPosition_, requestFrames-readFrames);
+            pcmPosition_ += s;
+            readFrames += s;
+            if(pcm_->getNumFrames()<=pcmPosition_){
+                if(0 == (userFlags & PlayerFlag_Loop)){
+                    break;
+                }
+                pcmPosition_ = 0;
+            }
+        }
+        return readFrames;
+    }
+
+    bool Player::isEnd() const
+    {
+        if(NULL != pcm_){
+            return pcm_->getNumFrames()<=pcmPosition_;
+        }
+        const Stream* stream = table_->streams_[index_];
+        return stream->getTotal()<=stream->getPosition();
+    }
+
+    bool Player::initialize()
+    {
+        if(checkInnerFlag(InnerFlag_Open)){
+            resetInnerFlag(InnerFlag_Open);
+            Stream* stream = table_->streams_[index_];
+            if(!stream->open() || stream->getTotal()<=0){
+                if(NULL != userPlayer_){
+                    userPlayer_->publish(State_Stopped, 0, 0.0f);
+                }
+                return false;
+            }
+        }
+
+        table_->states_[index_] = State_Playing;
+        if(NULL != userPlayer_){
+            applyUserControls();
+            userPlayer_->publish(table_->states_[index_], table_->positions_[index_], 0.0f);
+        }
+        return true;
+    }
+
+    void Player::applyUserControls()
+    {
+        s32 controls = userPlayer_->takeControls();
+        if(controls & UserPlayer::Control_Gain){
+            setGain(userPlayer_->gain_);
+        }
+        if(controls & UserPlayer::Control_Pitch){
+            setPitch(userPlayer_->pitch_);
+        }
+
+        switch(userPlayer_->takeRequest())
+        {
+        case UserPlayer::Request_Play:
+            play();
+            break;
+        case UserPlayer::Request_Pause:
+            pause();
+            break;
+        case UserPlayer::Request_Stop:
+            stop();
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool Player::update(LSfloat* bus, LSfloat* pcm, u32 numFrames)
+    {
+        if(NULL == userPlayer_){
+            return mix(bus, pcm, numFrames);
+        }
+
+        applyUserControls();
+        bool playing = mix(bus, pcm, numFrames);
+        //Mixer backends decode every block, nothing is queued
+        userPlayer_->publish((playing)? table_->states_[index_] : State_Stopped, table_->positions_[index_], 0.0f);
+        return playing;
+    }
+
+    bool Player::mix(LSfloat* bus, LSfloat* pcm, u32 numFrames)
+    {
+        State state = getState();
+        switch(state)
+        {
+        case State_Initial:
+        case State_Stopped:
+            return false;
+        case State_Paused:
+            return true;
+        default:
+            break;
+        }
+
+        u16 userFlags = getUserFlags();
+        if(checkInnerFlag(InnerFlag_Virtual)){
+            return skip(numFrames, userFlags);
+        }
+        if(checkInnerFlag(InnerFlag_Seek)){
+            resetInnerFlag(InnerFlag_Seek);
+            if(NULL != pcm_){
+                pcmPosition_ = cursor_;
+            }else{
+                table_->streams_[index_]->seek(cursor_);
+            }
+        }
+
+        u32 readFrames = fill(pcm, numFrames, userFlags);
+        table_->positions_[index_] += readFrames;
+
+        Mixer::accumulate(bus, pcm, readFrames, table_->gains_[index_]);
+
+        if(readFrames<numFrames && isEnd()){
+            return 0 != (userFlags & PlayerFlag_Loop);
+        }
+        return true;
+    }
+
+    void Player::setVirtual(bool enable)
+    {
+        if(enable == checkInnerFlag(InnerFlag_Virtual)){
+            return;
+        }
+        if(enable){
+            setInnerFlag(InnerFlag_Virtual);
+            //The cursor is already there if the voice has not been decoded since it became real
+            if(checkInnerFlag(InnerFlag_Seek)){
+                resetInnerFlag(InnerFlag_Seek);
+            }else{
+                cursor_ = (NULL != pcm_)? pcmPosition_ : static_cast<u32>(table_->streams_[index_]->getPosition());
+            }
+        }else{
+            resetInnerFlag(InnerFlag_Virtual);
+            setInnerFlag(InnerFlag_Seek);
+        }
+    }
+
+    bool Player::skip(u32 numFrames, u16 userFlags)
+    {
+        u32 total = getTotalFrames();
+        if(cursor_+numFrames<total){
+            cursor_ += numFrames;
+            table_->positions_[index_] += numFrames;
+            return true;
+        }
+        if(0 == (userFlags & PlayerFlag_Loop) || total<=0){
+            table_->positions_[index_] += total - lcore::minimum(cursor_, total);
+            cursor_ = total;
+            return false;
+        }
+        cursor_ = (cursor_+numFrames) % total;
+        table_->positions_[index_] += numFrames;
+        return true;
+    }
+
+    u32 Player::getTotalFrames() const
+    {
+        if(NULL != pcm_){
+            return pcm_->getNumFrames();
+        }
+        return static_cast<u32>(table_->streams_[index_]->getTotal());
+    }
+}
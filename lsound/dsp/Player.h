@@ -0,0 +1,153 @@
+#ifndef INC_LSOUND_DSP_PLAYER_H__
+#define INC_LSOUND_DSP_PLAYER_H__
+/**
+@file Player.h
+@author t-sakai
+@date 2015/07/06 create
+*/
+#include "../lsound.h"
+#include "dsp.h"
+#include "../VoiceTable.h"
+
+namespace lsound
+{
+    class Stream;
+    class PcmBlock;
+    class UserPlayer;
+
+    //--------------------------------------------------------
+    //---
+    //--- Player
+    //---
+    //--------------------------------------------------------
+    class Player
+    {
+    public:
+        static const s16 NumMaxBuffers = lsound::NumMaxBuffers;
+
+        enum InnerFlag
+        {
+            InnerFlag_UserPlayer = (0x01U<<0),
+            InnerFlag_Open = (0x01U<<1), ///< stream is opened by initialize
+            InnerFlag_Virtual = (0x01U<<2), ///< not decoded, only the position advances
+            InnerFlag_Seek = (0x01U<<3), ///< seek to cursor_ before the next decode
+        };
+
+        Player();
+        ~Player();
+
+        inline Handle getHandle() const;
+        u16 getUserFlags();
+
+        inline bool checkUserFlag(PlayerFlag flag) const;
+        inline void setUserFlag(PlayerFlag flag);
+        inline void resetUserFlag(PlayerFlag flag);
+
+        inline bool checkInnerFlag(InnerFlag flag) const;
+        inline void setInnerFlag(InnerFlag flag);
+        inline void resetInnerFlag(InnerFlag flag);
+
+        void rewind();
+
+        void play();
+        void pause();
+        void stop();
+
+        State getState();
+        void setState(s32 state);
+        u32 getSampleOffset();
+
+        void setPosition(f32 x, f32 y, f32 z);
+        void setGain(f32 gain);
+        void setPitch(f32 pitch);
+
+        void setStream(Stream* stream);
+
+        /**
+        @brief Play a decoded block instead of a stream
+        */
+        void setPcm(PcmBlock* pcm);
+
+        /**
+        @brief Open the stream if requested, called on the context side
+        */
+        bool initialize();
+
+        /**
+        @brief Decode numFrames stereo frames and add them to a bus
+        @return false if playing has finished
+        @param bus ... bus which has the layout of the mixer's one
+        @param pcm ... scratch buffer, at least numFrames*2 samples
+        */
+        bool update(LSfloat* bus, LSfloat* pcm, u32 numFrames);
+    private:
+        friend class MixerContext;
+
+        Player(const Player& rhs);
+        Player& operator=(const Player& rhs);
+
+        void clear();
+
+        /// Consume controls written to the user player
+        void applyUserControls();
+        bool mix(LSfloat* bus, LSfloat* pcm, u32 numFrames);
+
+        /**
+        @brief Stop or restart decoding, called by the context between blocks
+        */
+        void setVirtual(bool enable);
+        /// Advance the position of a virtual voice
+        bool skip(u32 numFrames, u16 userFlags);
+        u32 getTotalFrames() const;
+
+        u32 fill(LSfloat* pcm, u32 requestFrames, u16 userFlags);
+        u32 fillFromPcm(LSfloat* pcm, u32 requestFrames, u16 userFlags);
+        bool isEnd() const;
+
+        VoiceTable* table_; ///< flags, state, gain, position and stream are in the context's table
+        u16 index_;
+        volatile u16 generation_; ///< incremented when released
+        s32 next_; ///< index of the next request
+
+        PcmBlock* pcm_;
+        u32 pcmPosition_;
+        u32 cursor_; ///< frame in the sound where a virtual voice resumes
+        UserPlayer* userPlayer_;
+    };
+
+    inline Handle Player::getHandle() const
+    {
+        return makeHandle(index_, generation_);
+    }
+
+    inline bool Player::checkUserFlag(PlayerFlag flag) const
+    {
+        return 0 != (table_->userFlags_[index_] & flag);
+    }
+
+    inline void Player::setUserFlag(PlayerFlag flag)
+    {
+        table_->userFlags_[index_] |= flag;
+    }
+
+    inline void Player::resetUserFlag(PlayerFlag flag)
+    {
+        table_->userFlags_[index_] &= ~flag;
+    }
+
+    inline bool Player::checkInnerFlag(InnerFlag flag) const
+    {
+        return 0 != (table_->innerFlags_[index_] & flag);
+    }
+
+    inline void Player::setInnerFlag(InnerFlag flag)
+    {
+        table_->innerFlags_[index_] |= flag;
+    }
+
+    inline void Player::resetInnerFlag(InnerFlag flag)
+    {
+        table_->innerFlags_[index_] &= ~flag;
+    }
+}
+#endif //INC_LSOUND_DSP_PLAYER_H__
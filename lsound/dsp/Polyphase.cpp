@@ -0,0 +1,327 @@
+/**
+@file Polyphase.cpp
+@author t-sakai
+@date 2015/08/17 create
+*/
+#include "Polyphase.h"
+#include <lcore/CLibrary.h>
+#include <lcore/async/SyncObject.h>
+
+namespace lsound
+{
+namespace
+{
+    static const f64 PI = 3.14159265358979323846;
+
+    /// Stop band attenuation in dB and transition width in the ratio of the nyquist, of each quality
+    struct FilterParam
+    {
+        f64 attenuation_;
+        f64 transition_;
+    };
+
+    static const FilterParam FilterParams[Polyphase::Quality_Num] =
+    {
+        {50.0, 0.25},
+        {70.0, 0.15},
+        {96.0, 0.10},
+    };
+
+    /// Ratios decimating more than this need too long filters
+    static const s32 MaxDecimation = 4;
+
+    f64 besselI0(f64 x)
+    {
+        f64 sum = 1.0;
+        f64 term = 1.0;
+        f64 h = 0.5*x;
+        for(s32 i=1; i<64; ++i){
+            f64 t = h/i;
+            term *= t*t;
+            sum += term;
+            if(term<(sum*1.0e-12)){
+                break;
+            }
+        }
+        return sum;
+    }
+
+    f64 sinc(f64 x)
+    {
+        if(-1.0e-9<x && x<1.0e-9){
+            return 1.0;
+        }
+        return sin(PI*x)/(PI*x);
+    }
+
+    lcore::CriticalSection bankLock_;
+}
+
+    Polyphase::Bank Polyphase::banks_[MaxBanks];
+    s32 Polyphase::numBanks_ = 0;
+
+namespace
+{
+    /// Banks live until exit
+    struct BankReleaser
+    {
+        ~BankReleaser()
+        {
+            Polyphase::releaseBanks();
+        }
+    };
+
+    BankReleaser bankReleaser_;
+}
+
+    bool Polyphase::isSupported(s32 srcSamplesPerSec, s32 dstSamplesPerSec)
+    {
+        if(srcSamplesPerSec<=0 || dstSamplesPerSec<=0 || srcSamplesPerSec == dstSamplesPerSec){
+            return false;
+        }
+        s32 g = gcd(srcSamplesPerSec, dstSamplesPerSec);
+        s32 up = dstSamplesPerSec/g;
+        s32 down = srcSamplesPerSec/g;
+        return up<=MaxPhases && down<=(up*MaxDecimation);
+    }
+
+    void Polyphase::releaseBanks()
+    {
+        lcore::CSLock lock(bankLock_);
+        for(s32 i=0; i<numBanks_; ++i){
+            LIME_ALIGNED_FREE(banks_[i].taps_, TapsAlign);
+        }
+        numBanks_ = 0;
+    }
+
+    Polyphase::Polyphase()
+        :bank_(NULL)
+        ,filterFunc_(NULL)
+        ,numChannels_(0)
+        ,step_(0)
+        ,frac_(0)
+        ,phase_(0)
+        ,position_(0)
+        ,count_(0)
+        ,capacity_(0)
+        ,history_(NULL)
+    {
+    }
+
+    Polyphase::~Polyphase()
+    {
+        destroy();
+    }
+
+    bool Polyphase::create(u16 numChannels, s32 srcSamplesPerSec, s32 dstSamplesPerSec, Quality quality, u32 maxInFrames)
+    {
+        LASSERT(1 == numChannels || 2 == numChannels);
+        LASSERT(0<=quality && quality<Quality_Num);
+
+        destroy();
+        if(!isSupported(srcSamplesPerSec, dstSamplesPerSec)){
+            return false;
+        }
+        s32 g = gcd(srcSamplesPerSec, dstSamplesPerSec);
+        const Bank* bank = getBank(dstSamplesPerSec/g, srcSamplesPerSec/g, quality);
+        if(NULL == bank){
+            return false;
+        }
+
+        u32 capacity = bank->numTaps_ + maxInFrames;
+        capacity = (capacity + 7) & ~7U;
+        history_ = reinterpret_cast<f32*>(LIME_ALIGNED_MALLOC(sizeof(f32)*capacity*numChannels, TapsAlign));
+        if(NULL == history_){
+            return false;
+        }
+        bank_ = bank;
+        filterFunc_ = getFilterFunc(numChannels);
+        numChannels_ = numChannels;
+        step_ = bank->down_/bank->up_;
+        frac_ = bank->down_%bank->up_;
+        capacity_ = capacity;
+        reset();
+        return true;
+    }
+
+    void Polyphase::destroy()
+    {
+        LIME_ALIGNED_FREE(history_, TapsAlign);
+        bank_ = NULL;
+        filterFunc_ = NULL;
+        numChannels_ = 0;
+        capacity_ = 0;
+        count_ = 0;
+    }
+
+    void Polyphase::reset()
+    {
+        if(NULL == bank_){
+            return;
+        }
+        //Centers of filters meet input frames from the first
+        phase_ = 0;
+        position_ = 0;
+        count_ = bank_->numTaps_/2 - 1;
+        lcore::memset(history_, 0, sizeof(f32)*capacity_*numChannels_);
+    }
+
+    void Polyphase::process(const LSfloat* in, u32& inFrames, LSfloat* out, u32& outFrames)
+    {
+        LASSERT(NULL != bank_);
+        inFrames = push(in, inFrames);
+        outFrames = filter(out, outFrames);
+    }
+
+    void Polyphase::process(const LSshort* in, u32& inFrames, LSshort* out, u32& outFrames)
+    {
+        LASSERT(NULL != bank_);
+        static const u32 BlockFrames = 256;
+        LIME_ALIGN16 LSfloat block[BlockFrames*MaxChannels];
+
+        inFrames = push(in, inFrames);
+        u32 written = 0;
+        while(written<outFrames){
+            u32 numFrames = filter(block, lcore::minimum(outFrames-written, BlockFrames));
+            if(numFrames<=0){
+                break;
+            }
+            LSshort* o = out + written*numChannels_;
+            u32 numSamples = numFrames*numChannels_;
+            for(u32 i=0; i<numSamples; ++i){
+                o[i] = toShort(block[i]);
+            }
+            written += numFrames;
+        }
+        outFrames = written;
+    }
+
+    template<class T>
+    u32 Polyphase::push(const T* in, u32 inFrames)
+    {
+        static const f32 Scale = (sizeof(T) == sizeof(LSshort))? (1.0f/32768.0f) : 1.0f;
+
+        inFrames = lcore::minimum(inFrames, capacity_-count_);
+        for(u16 c=0; c<numChannels_; ++c){
+            f32* h = history_ + capacity_*c + count_;
+            const T* s = in + c;
+            for(u32 i=0; i<inFrames; ++i){
+                h[i] = Scale * s[i*numChannels_];
+            }
+        }
+        count_ += inFrames;
+        return inFrames;
+    }
+
+    u32 Polyphase::filter(LSfloat* out, u32 outFrames)
+    {
+        const s32 numTaps = bank_->numTaps_;
+        const s32 up = bank_->up_;
+        const f32* x[MaxChannels];
+
+        u32 n = 0;
+        while(n<outFrames && (position_+numTaps)<=count_){
+            for(u16 c=0; c<numChannels_; ++c){
+                x[c] = history_ + capacity_*c + position_;
+            }
+            filterFunc_(out + n*numChannels_, bank_->taps_ + phase_*numTaps, x, numTaps);
+            ++n;
+
+            position_ += step_;
+            phase_ += frac_;
+            if(up<=phase_){
+                phase_ -= up;
+                ++position_;
+            }
+        }
+
+        //Move the rest to the top
+        if(0<position_){
+            u32 remain = (position_<count_)? count_-position_ : 0;
+            for(u16 c=0; c<numChannels_; ++c){
+                f32* h = history_ + capacity_*c;
+                memmove(h, h+position_, sizeof(f32)*remain);
+            }
+            position_ -= count_-remain;
+            count_ = remain;
+        }
+        return n;
+    }
+
+    s32 Polyphase::gcd(s32 a, s32 b)
+    {
+        while(0 != b){
+            s32 t = a%b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    const Polyphase::Bank* Polyphase::getBank(s32 up, s32 down, Quality quality)
+    {
+        lcore::CSLock lock(bankLock_);
+        for(s32 i=0; i<numBanks_; ++i){
+            if(banks_[i].up_ == up && banks_[i].down_ == down && banks_[i].quality_ == quality){
+                return &banks_[i];
+            }
+        }
+        if(MaxBanks<=numBanks_){
+            return NULL;
+        }
+        if(!createBank(banks_[numBanks_], up, down, quality)){
+            return NULL;
+        }
+        return &banks_[numBanks_++];
+    }
+
+    bool Polyphase::createBank(Bank& bank, s32 up, s32 down, Quality quality)
+    {
+        //Kaiser windowed sinc, cut off below the lower nyquist
+        const FilterParam& param = FilterParams[quality];
+        f64 ratio = (up<down)? static_cast<f64>(up)/down : 1.0;
+        f64 cutoff = ratio*(1.0 - 0.5*param.transition_);
+        f64 width = PI*ratio*param.transition_;
+        f64 attenuation = param.attenuation_;
+        f64 beta = (50.0<attenuation)
+            ? 0.1102*(attenuation-8.7)
+            : 0.5842*pow(attenuation-21.0, 0.4) + 0.07886*(attenuation-21.0);
+
+        s32 numTaps = static_cast<s32>(ceil((attenuation-8.0)/(2.285*width))) + 1;
+        numTaps = (numTaps+7) & ~7;
+
+        f32* taps = reinterpret_cast<f32*>(LIME_ALIGNED_MALLOC(sizeof(f32)*numTaps*up, TapsAlign));
+        if(NULL == taps){
+            return false;
+        }
+
+        f64 half = 0.5*numTaps;
+        f64 i0beta = besselI0(beta);
+        for(s32 p=0; p<up; ++p){
+            f32* t = taps + p*numTaps;
+            f64 phase = static_cast<f64>(p)/up;
+            f64 sum = 0.0;
+            for(s32 k=0; k<numTaps; ++k){
+                //Distance from the center of the filter to the tap
+                f64 x = (half - 1.0 - k) + phase;
+                f64 r = x/half;
+                f64 w = (r<=-1.0 || 1.0<=r)? 0.0 : besselI0(beta*sqrt(1.0-r*r))/i0beta;
+                f64 v = cutoff*sinc(cutoff*x)*w;
+                t[k] = static_cast<f32>(v);
+                sum += v;
+            }
+            //Unit gain for each phase
+            f32 scale = static_cast<f32>(1.0/sum);
+            for(s32 k=0; k<numTaps; ++k){
+                t[k] *= scale;
+            }
+        }
+
+        bank.up_ = up;
+        bank.down_ = down;
+        bank.quality_ = quality;
+        bank.numTaps_ = numTaps;
+        bank.taps_ = taps;
+        return true;
+    }
+}
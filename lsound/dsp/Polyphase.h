@@ -0,0 +1,113 @@
+#ifndef INC_LSOUND_POLYPHASE_H__
+#define INC_LSOUND_POLYPHASE_H__
+/**
+@file Polyphase.h
+@author t-sakai
+@date 2015/08/17 create
+*/
+#include "../lsound.h"
+#include "dsp.h"
+
+namespace lsound
+{
+    /**
+    @brief Polyphase fir resampler of a rational ratio, such as 48kHz and 44.1kHz, 32kHz or 24kHz.
+    Filter banks are made once for a ratio and a quality, then shared by all instances.
+    */
+    class Polyphase
+    {
+    public:
+        enum Quality
+        {
+            Quality_Cheap =0, ///< short filter for sound effects
+            Quality_Default,
+            Quality_High, ///< long filter for music
+            Quality_Num,
+        };
+
+        static const s32 MaxChannels = 2;
+        /// Phases of a bank, ratios which need more are left to others
+        static const s32 MaxPhases = 160;
+        static const s32 TapsAlign = 32;
+
+        /**
+        @brief Whether the ratio of the rates can be resampled by a bank
+        */
+        static bool isSupported(s32 srcSamplesPerSec, s32 dstSamplesPerSec);
+
+        /**
+        @brief Free shared banks, while no instance is alive
+        */
+        static void releaseBanks();
+
+        Polyphase();
+        ~Polyphase();
+
+        /**
+        @param maxInFrames ... frames taken by a process at most
+        */
+        bool create(u16 numChannels, s32 srcSamplesPerSec, s32 dstSamplesPerSec, Quality quality, u32 maxInFrames);
+        void destroy();
+        void reset();
+
+        inline bool valid() const;
+        inline s32 getNumTaps() const;
+
+        /**
+        @brief Resample interleaved frames
+        @param inFrames ... frames of in, then frames taken
+        @param outFrames ... capacity of out, then frames written
+        */
+        void process(const LSfloat* in, u32& inFrames, LSfloat* out, u32& outFrames);
+        void process(const LSshort* in, u32& inFrames, LSshort* out, u32& outFrames);
+    private:
+        Polyphase(const Polyphase&);
+        Polyphase& operator=(const Polyphase&);
+
+        struct Bank
+        {
+            s32 up_; ///< number of phases
+            s32 down_;
+            s32 quality_;
+            s32 numTaps_;
+            f32* taps_; ///< numTaps_ of each phase, aligned to TapsAlign
+        };
+
+        static const s32 MaxBanks = 32;
+
+        static Bank banks_[MaxBanks];
+        static s32 numBanks_;
+
+        static s32 gcd(s32 a, s32 b);
+        static const Bank* getBank(s32 up, s32 down, Quality quality);
+        static bool createBank(Bank& bank, s32 up, s32 down, Quality quality);
+
+        /// Append frames to the histories, return the number taken
+        template<class T>
+        u32 push(const T* in, u32 inFrames);
+        /// Filter frames while the histories have all taps of them
+        u32 filter(LSfloat* out, u32 outFrames);
+
+        const Bank* bank_;
+        FilterFunc filterFunc_;
+        u16 numChannels_;
+        s32 step_; ///< whole input frames per output
+        s32 frac_; ///< fraction of input frames per output, in phases
+        s32 phase_;
+        u32 position_; ///< start of the filter in the histories
+        u32 count_; ///< frames in the histories
+        u32 capacity_;
+        f32* history_; ///< planar, capacity_ frames of each channel
+    };
+
+    inline bool Polyphase::valid() const
+    {
+        return NULL != bank_;
+    }
+
+    inline s32 Polyphase::getNumTaps() const
+    {
+        return (NULL != bank_)? bank_->numTaps_ : 0;
+    }
+}
+#endif //INC_LSOUND_POLYPHASE_H__
@@ -8,18 +8,65 @@
 
 namespace lsound
 {
-    LSfloat Resampler::sharedBuffer0_[SharedBufferLength*2];
-    LSfloat Resampler::sharedBuffer1_[SharedBufferLength*2];
+namespace
+{
+    template<class T, class U>
+    struct IsSame
+    {
+        static const bool value = false;
+    };
+
+    template<class T>
+    struct IsSame<T, T>
+    {
+        static const bool value = true;
+    };
+
+    inline s32 readStream(Stream* stream, LSshort* pcm, s32 size)
+    {
+        return stream->read(pcm, size);
+    }
+
+    inline s32 readStream(Stream* stream, LSfloat* pcm, s32 size)
+    {
+        return stream->read_float(pcm, size);
+    }
+
+    inline void process(SpeexResamplerState* resampler, const LSshort* in, spx_uint32_t& inN, LSshort* out, spx_uint32_t& outN)
+    {
+        speex_resampler_process_interleaved_int(resampler, in, &inN, out, &outN);
+    }
+
+    inline void process(SpeexResamplerState* resampler, const LSfloat* in, spx_uint32_t& inN, LSfloat* out, spx_uint32_t& outN)
+    {
+        speex_resampler_process_interleaved_float(resampler, in, &inN, out, &outN);
+    }
+
+    /// Speex qualities of Polyphase::Quality for other ratios
+    static const s32 SpeexQualities[Polyphase::Quality_Num] =
+    {
+        2,
+        SPEEX_RESAMPLER_QUALITY_DEFAULT,
+        8,
+    };
+}
 
     Resampler::Resampler()
-        :convertTypeFunc_(NULL)
+        :readFunc_(NULL)
+        ,convertTypeFunc_(NULL)
+        ,blockFrames_(BlockFrames)
+        ,scratchSize_(0)
+        ,scratch_(NULL)
         ,srcNumChannels_(0)
         ,srcBytesPerSample_(0)
         ,srcSamplesPerSec_(0)
         ,dstNumChannels_(0)
         ,dstBytesPerSample_(0)
         ,dstSamplesPerSec_(0)
+        ,quality_(Polyphase::Quality_Default)
+        ,usePolyphase_(true)
         ,resamplerChannels_(0)
+        ,resamplerQuality_(0)
         ,resampler_(NULL)
     {
     }
@@ -27,6 +74,7 @@ namespace lsound
     Resampler::~Resampler()
     {
         destroyResampler();
+        LIME_ALIGNED_FREE(scratch_, ScratchAlign);
     }
 
     void Resampler::setSource(
@@ -49,112 +97,203 @@ namespace lsound
         dstSamplesPerSec_ = dstSamplesPerSec;
     }
 
-    void Resampler::initialize()
+    void Resampler::setBlockFrames(u32 blockFrames)
+    {
+        LASSERT(1<blockFrames);
+        blockFrames_ = blockFrames;
+    }
+
+    void Resampler::setQuality(Polyphase::Quality quality)
     {
-        if(dstSamplesPerSec_ == srcSamplesPerSec_){
-            convertTypeFunc_ = getConvTypeFunc(
-                dstNumChannels_,
-                dstBytesPerSample_,
-                srcNumChannels_,
-                srcBytesPerSample_);
+        LASSERT(0<=quality && quality<Polyphase::Quality_Num);
+        quality_ = quality;
+    }
 
-        }else{
-            if(resamplerChannels_ != srcNumChannels_){
+    void Resampler::setUsePolyphase(bool usePolyphase)
+    {
+        usePolyphase_ = usePolyphase;
+    }
+
+    bool Resampler::initialize()
+    {
+        LASSERT(2 == srcBytesPerSample_ || 4 == srcBytesPerSample_);
+        LASSERT(2 == dstBytesPerSample_ || 4 == dstBytesPerSample_);
+
+        //Grow only, formats of a player change little
+        u32 scratchSize = blockFrames_ * srcNumChannels_ * srcBytesPerSample_ * 2;
+        scratchSize = (scratchSize + (ScratchAlign-1)) & ~(ScratchAlign-1);
+        if(scratchSize_<scratchSize){
+            LIME_ALIGNED_FREE(scratch_, ScratchAlign);
+            scratchSize_ = 0;
+            scratch_ = reinterpret_cast<u8*>(LIME_ALIGNED_MALLOC(scratchSize, ScratchAlign));
+            if(NULL == scratch_){
+                readFunc_ = NULL;
+                return false;
+            }
+            scratchSize_ = scratchSize;
+        }
+
+        bool resample = (dstSamplesPerSec_ != srcSamplesPerSec_);
+        polyphase_.destroy();
+        if(resample && usePolyphase_){
+            polyphase_.create(srcNumChannels_, srcSamplesPerSec_, dstSamplesPerSec_, quality_, blockFrames_);
+        }
+        if(polyphase_.valid()){
+            destroyResampler();
+        }else if(resample){
+            s32 quality = SpeexQualities[quality_];
+            if(resamplerChannels_ != srcNumChannels_ || resamplerQuality_ != quality){
                 destroyResampler();
             }
             if(NULL == resampler_){
-                resampler_ = speex_resampler_init(srcNumChannels_, srcSamplesPerSec_, dstSamplesPerSec_, SPEEX_RESAMPLER_QUALITY_DEFAULT, NULL);
+                resampler_ = speex_resampler_init(srcNumChannels_, srcSamplesPerSec_, dstSamplesPerSec_, quality, NULL);
+                resamplerChannels_ = srcNumChannels_;
+                resamplerQuality_ = quality;
             }else{
                 speex_resampler_set_rate(resampler_, srcSamplesPerSec_, dstSamplesPerSec_);
                 speex_resampler_reset_mem(resampler_);
             }
+        }
 
-            resampleRate_ = static_cast<f32>(dstSamplesPerSec_)/srcSamplesPerSec_;
+        //Resampled in the source format, then converted once
+        convertTypeFunc_ = getConvTypeFunc(
+            dstNumChannels_,
+            dstBytesPerSample_,
+            srcNumChannels_,
+            srcBytesPerSample_);
 
-            convertTypeFunc_ = getConvTypeFunc(
-                dstNumChannels_,
-                dstBytesPerSample_,
-                srcNumChannels_,
-                dstBytesPerSample_);
+        if(2 == srcBytesPerSample_){
+            readFunc_ = (2 == dstBytesPerSample_)
+                ? selectChannels<LSshort, LSshort>(srcNumChannels_, dstNumChannels_, resample)
+                : selectChannels<LSshort, LSfloat>(srcNumChannels_, dstNumChannels_, resample);
+        }else{
+            readFunc_ = (2 == dstBytesPerSample_)
+                ? selectChannels<LSfloat, LSshort>(srcNumChannels_, dstNumChannels_, resample)
+                : selectChannels<LSfloat, LSfloat>(srcNumChannels_, dstNumChannels_, resample);
         }
+        return true;
     }
 
     void Resampler::reset()
     {
+        polyphase_.reset();
         if(NULL != resampler_){
             speex_resampler_reset_mem(resampler_);
         }
     }
 
-    s32 Resampler::read(LSshort* pcm, u32 numSamples, Stream* stream)
+    s32 Resampler::read(LSshort* pcm, u32 numFrames, Stream* stream)
+    {
+        LASSERT(2 == dstBytesPerSample_);
+        LASSERT(NULL != readFunc_);
+        return readFunc_(*this, pcm, numFrames, stream);
+    }
+
+    s32 Resampler::read(LSfloat* pcm, u32 numFrames, Stream* stream)
     {
-        if(dstSamplesPerSec_ == srcSamplesPerSec_){
+        LASSERT(4 == dstBytesPerSample_);
+        LASSERT(NULL != readFunc_);
+        return readFunc_(*this, pcm, numFrames, stream);
+    }
 
-            if(NULL != convertTypeFunc_){
-                LSshort* buffer = reinterpret_cast<LSshort*>(sharedBuffer0_);
-                s32 readSamples = stream->read(buffer, numSamples);
-                if(readSamples<0){
-                    return readSamples;
-                }
-                convertTypeFunc_(pcm, buffer, readSamples);
-                return readSamples;
+    template<class SrcType, class DstType, s32 SrcChannels, s32 DstChannels, bool Resample>
+    s32 Resampler::readBlocks(Resampler& resampler, void* pcm, u32 numFrames, Stream* stream)
+    {
+        static const bool Convert = !IsSame<SrcType, DstType>::value || (SrcChannels != DstChannels);
+
+        DstType* dst = reinterpret_cast<DstType*>(pcm);
+        const u32 blockFrames = resampler.blockFrames_;
+        SrcType* decoded = reinterpret_cast<SrcType*>(resampler.scratch_);
+        SrcType* resampled = decoded + blockFrames*SrcChannels;
 
-            } else{
-                return stream->read(pcm, numSamples);
+        u32 written = 0;
+        while(written<numFrames){
+            DstType* d = dst + written*DstChannels;
+            u32 outFrames = lcore::minimum(numFrames-written, blockFrames);
+            u32 inFrames = outFrames;
+            if(Resample){
+                //Leave a frame for the phase of the resampler
+                inFrames = static_cast<u32>((static_cast<u64>(outFrames-1)*resampler.srcSamplesPerSec_)/resampler.dstSamplesPerSec_);
+                inFrames = lcore::minimum(inFrames, blockFrames);
+                if(inFrames<=0){
+                    break;
+                }
             }
 
-        }else{
-            LSshort* buffer0 = reinterpret_cast<LSshort*>(sharedBuffer0_);
-            s32 readSamples = stream->read(buffer0, numSamples);
-            if(readSamples<0){
-                return readSamples;
+            //Each stage writes into the destination when the next has nothing to do
+            SrcType* in = (Convert || Resample)? decoded : reinterpret_cast<SrcType*>(d);
+            s32 readFrames = readStream(stream, in, inFrames*SrcChannels);
+            if(readFrames<=0){
+                if(readFrames<0 && written<=0){
+                    return readFrames;
+                }
+                break;
             }
 
-            u32 inN = numSamples;
-            u32 outN = static_cast<u32>(resampleRate_*numSamples);
-            if(NULL != convertTypeFunc_){
-                LSshort* buffer1 = reinterpret_cast<LSshort*>(sharedBuffer1_);
-                speex_resampler_process_interleaved_int(resampler_, buffer0, &inN, buffer1, &outN);
-                convertTypeFunc_(pcm, buffer1, outN);
-            }else{
-                speex_resampler_process_interleaved_int(resampler_, buffer0, &inN, pcm, &outN);
+            const SrcType* out = in;
+            u32 numOut = readFrames;
+            if(Resample){
+                SrcType* o = (Convert)? resampled : reinterpret_cast<SrcType*>(d);
+                u32 inN = readFrames;
+                u32 outN = outFrames;
+                resampler.resample(in, inN, o, outN);
+                out = o;
+                numOut = outN;
             }
-            return static_cast<s32>(outN);
+            if(Convert){
+                resampler.convertTypeFunc_(d, out, numOut);
+            }
+            written += numOut;
         }
+        return static_cast<s32>(written);
     }
 
-    s32 Resampler::read(LSfloat* pcm, u32 numSamples, Stream* stream)
+    template<class SrcType, class DstType, s32 SrcChannels, s32 DstChannels>
+    Resampler::ReadFunc Resampler::selectResample(bool resample)
     {
-        if(dstSamplesPerSec_ == srcSamplesPerSec_){
-            if(NULL != convertTypeFunc_){
-                s32 readSamples = stream->read_float(sharedBuffer0_, numSamples);
-
-                if(readSamples<0){
-                    return readSamples;
-                }
-                convertTypeFunc_(pcm, sharedBuffer0_, readSamples);
-                return readSamples;
-
-            } else{
-                return stream->read_float(pcm, numSamples);
-            }
+        return (resample)
+            ? readBlocks<SrcType, DstType, SrcChannels, DstChannels, true>
+            : readBlocks<SrcType, DstType, SrcChannels, DstChannels, false>;
+    }
 
+    template<class SrcType, class DstType>
+    Resampler::ReadFunc Resampler::selectChannels(u16 srcNumChannels, u16 dstNumChannels, bool resample)
+    {
+        if(Channels_Mono == srcNumChannels){
+            return (Channels_Mono == dstNumChannels)
+                ? selectResample<SrcType, DstType, 1, 1>(resample)
+                : selectResample<SrcType, DstType, 1, 2>(resample);
         }else{
-            s32 readSamples = stream->read_float(sharedBuffer0_, numSamples);
-            if(readSamples<0){
-                return readSamples;
-            }
+            return (Channels_Mono == dstNumChannels)
+                ? selectResample<SrcType, DstType, 2, 1>(resample)
+                : selectResample<SrcType, DstType, 2, 2>(resample);
+        }
+    }
 
-            u32 inN = readSamples;
-            u32 outN = static_cast<u32>(resampleRate_*readSamples);
-            if(NULL != convertTypeFunc_){
-                speex_resampler_process_interleaved_float(resampler_, sharedBuffer0_, &inN, sharedBuffer1_, &outN);
-                convertTypeFunc_(pcm, sharedBuffer1_, outN);
-            }else{
-                speex_resampler_process_interleaved_float(resampler_, sharedBuffer0_, &inN, pcm, &outN);
-            }
-            return static_cast<s32>(outN);
+    void Resampler::resample(const LSshort* in, u32& inFrames, LSshort* out, u32& outFrames)
+    {
+        if(polyphase_.valid()){
+            polyphase_.process(in, inFrames, out, outFrames);
+            return;
+        }
+        spx_uint32_t inN = inFrames;
+        spx_uint32_t outN = outFrames;
+        process(resampler_, in, inN, out, outN);
+        inFrames = inN;
+        outFrames = outN;
+    }
+
+    void Resampler::resample(const LSfloat* in, u32& inFrames, LSfloat* out, u32& outFrames)
+    {
+        if(polyphase_.valid()){
+            polyphase_.process(in, inFrames, out, outFrames);
+            return;
         }
+        spx_uint32_t inN = inFrames;
+        spx_uint32_t outN = outFrames;
+        process(resampler_, in, inN, out, outN);
+        inFrames = inN;
+        outFrames = outN;
     }
 
     void Resampler::destroyResampler()
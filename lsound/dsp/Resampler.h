@@ -1,24 +1,37 @@
-#ifndef INC_LSOUND_RESAMPLER_H__
-#define INC_LSOUND_RESAMPLER_H__
+#ifndef INC_LSOUND_RESAMPLER_H__
+#define INC_LSOUND_RESAMPLER_H__
 /**
 @file Resampler.h
 @author t-sakai
 @date 2015/07/09 create
-*/
-#include "../lsound.h"
-#include "dsp.h"
-#include <speex/speex_resampler.h>
-
+*/
+#include "../lsound.h"
+#include "dsp.h"
+#include "Polyphase.h"
+#include <speex/speex_resampler.h>
+
 namespace lsound
 {
     class Stream;
 
+    /**
+    @brief Decode, resample and convert a stream block by block, straight into the destination.
+    Used by the resample tools and benchmarks only, players are resampled by Mixer while mixing.
+    A pipeline specialized for the formats is selected in initialize.
+    Ratios which Polyphase supports are resampled by it, the rest by speex.
+    Each instance owns its scratch and speex state and shares nothing with others,
+    so instances run on any threads at once, but one instance is used by one thread at a time.
+    */
     class Resampler
     {
     public:
         static const s32 MaxTableHalfLength = 8;
         static const s32 MaxTableLength = (MaxTableHalfLength*2+1);
 
+        /// Default frames going through all stages at once, blocks of every stage stay in the first level cache
+        static const s32 BlockFrames = 256;
+        static const s32 ScratchAlign = 16;
+
         Resampler();
         ~Resampler();
 
@@ -32,9 +45,35 @@ namespace lsound
             u16 dstBytesPerSample,
             s32 dstSamplesPerSec);
 
-        void initialize();
+        /**
+        @brief Frames of a block, takes effect on the next initialize
+        */
+        void setBlockFrames(u32 blockFrames);
+
+        /**
+        @brief Cheap for sound effects, high for music. Takes effect on the next initialize
+        */
+        void setQuality(Polyphase::Quality quality);
+
+        /**
+        @brief Resample by speex even if a polyphase filter can, to compare them
+        */
+        void setUsePolyphase(bool usePolyphase);
+
+        /**
+        @brief Allocate the scratch of the formats and select a pipeline
+        @return false if failed to allocate
+        */
+        bool initialize();
         void reset();
 
+        inline u32 getBlockFrames() const;
+        inline Polyphase::Quality getQuality() const;
+        /// Whether a polyphase filter resamples after initialize
+        inline bool isPolyphase() const;
+        /// Bytes of the scratch, two blocks in the source format
+        inline u32 getScratchSize() const;
+
         inline u16 getSrcNumChannels() const;
         inline u16 getSrcBytesPerSample() const;
         inline s32 getSrcSamplesPerSec() const;
@@ -43,16 +82,42 @@ namespace lsound
         inline u16 getDstBytesPerSample() const;
         inline s32 getDstSamplesPerSec() const;
 
-        s32 read(LSshort* pcm, u32 numSamples, Stream* stream);
-        s32 read(LSfloat* pcm, u32 numSamples, Stream* stream);
+        /**
+        @return number of frames at the destination rate, negative if failed
+        @param numFrames ... capacity of pcm in frames
+        */
+        s32 read(LSshort* pcm, u32 numFrames, Stream* stream);
+        s32 read(LSfloat* pcm, u32 numFrames, Stream* stream);
     private:
         Resampler(const Resampler&);
         Resampler& operator=(const Resampler&);
 
+        typedef s32 (*ReadFunc)(Resampler& resampler, void* pcm, u32 numFrames, Stream* stream);
+
+        /**
+        @brief Pipeline of a format, SrcType is the type decoded and resampled
+        */
+        template<class SrcType, class DstType, s32 SrcChannels, s32 DstChannels, bool Resample>
+        static s32 readBlocks(Resampler& resampler, void* pcm, u32 numFrames, Stream* stream);
+
+        template<class SrcType, class DstType, s32 SrcChannels, s32 DstChannels>
+        static ReadFunc selectResample(bool resample);
+
+        template<class SrcType, class DstType>
+        static ReadFunc selectChannels(u16 srcNumChannels, u16 dstNumChannels, bool resample);
+
+        void resample(const LSshort* in, u32& inFrames, LSshort* out, u32& outFrames);
+        void resample(const LSfloat* in, u32& inFrames, LSfloat* out, u32& outFrames);
+
         void destroyResampler();
 
+        ReadFunc readFunc_;
         ConvTypeFunc convertTypeFunc_;
 
+        u32 blockFrames_;
+        u32 scratchSize_;
+        u8* scratch_; ///< decoded and resampled blocks, aligned to ScratchAlign
+
         u16 srcNumChannels_;
         u16 srcBytesPerSample_;
         s32 srcSamplesPerSec_;
@@ -60,13 +125,35 @@ namespace lsound
         u16 dstBytesPerSample_;
         s32 dstSamplesPerSec_;
 
+        Polyphase::Quality quality_;
+        bool usePolyphase_;
+        Polyphase polyphase_;
+
         s32 resamplerChannels_;
-        f32 resampleRate_;
+        s32 resamplerQuality_;
         SpeexResamplerState* resampler_;
-        static LSfloat sharedBuffer0_[SharedBufferLength*2];
-        static LSfloat sharedBuffer1_[SharedBufferLength*2];
     };
 
+    inline u32 Resampler::getBlockFrames() const
+    {
+        return blockFrames_;
+    }
+
+    inline Polyphase::Quality Resampler::getQuality() const
+    {
+        return quality_;
+    }
+
+    inline bool Resampler::isPolyphase() const
+    {
+        return polyphase_.valid();
+    }
+
+    inline u32 Resampler::getScratchSize() const
+    {
+        return scratchSize_;
+    }
+
     inline u16 Resampler::getSrcNumChannels() const
     {
         return srcNumChannels_;
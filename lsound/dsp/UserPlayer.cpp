@@ -0,0 +1,109 @@
+/**
+@file UserPlayer.cpp
+@author t-sakai
+@date 2015/07/07 create
+*/
+#include "UserPlayer.h"
+#include "Player.h"
+
+namespace lsound
+{
+    UserPlayer::UserPlayer()
+        :generation_(1)
+    {
+        reset();
+    }
+
+    UserPlayer::~UserPlayer()
+    {
+    }
+
+    void UserPlayer::reset()
+    {
+        refCount_ = 1;
+        flags_ = 0;
+        controls_ = 0;
+        request_ = Request_None;
+        gain_ = 1.0f;
+        pitch_ = 1.0f;
+        sequence_ = 0;
+        for(s32 i=0; i<2; ++i){
+            snapshots_[i].state_ = State_Initial;
+            snapshots_[i].position_ = 0;
+            snapshots_[i].queuedDuration_ = 0.0f;
+        }
+    }
+
+    bool UserPlayer::checkFlag(PlayerFlag flag)
+    {
+        return 0 != (flags_ & flag);
+    }
+
+    void UserPlayer::setFlag(PlayerFlag flag)
+    {
+        lcore::atomicOr(&flags_, flag);
+    }
+
+    void UserPlayer::resetFlag(PlayerFlag flag)
+    {
+        lcore::atomicAnd(&flags_, ~static_cast<s32>(flag));
+    }
+
+    void UserPlayer::play()
+    {
+        lcore::atomicExchange(&request_, Request_Play);
+    }
+
+    void UserPlayer::pause()
+    {
+        lcore::atomicExchange(&request_, Request_Pause);
+    }
+
+    State UserPlayer::getState()
+    {
+        Snapshot snapshot;
+        getSnapshot(snapshot);
+        return static_cast<State>(snapshot.state_);
+    }
+
+    void UserPlayer::getSnapshot(Snapshot& snapshot)
+    {
+        for(;;){
+            u32 sequence = sequence_ & ~0x01U;
+            lcore::memoryBarrier();
+            snapshot = snapshots_[(sequence>>1) & 0x01U];
+            lcore::memoryBarrier();
+            //The front one is rewritten from the second publish after
+            if((sequence_-sequence)<=2){
+                return;
+            }
+        }
+    }
+
+    void UserPlayer::setGain(f32 gain)
+    {
+        gain_ = gain;
+        lcore::atomicOr(&controls_, Control_Gain);
+    }
+
+    void UserPlayer::setPitch(f32 pitch)
+    {
+        pitch_ = pitch;
+        lcore::atomicOr(&controls_, Control_Pitch);
+    }
+
+    void UserPlayer::publish(s32 state, u32 position, f32 queuedDuration)
+    {
+        u32 sequence = sequence_;
+        sequence_ = sequence + 1;
+        lcore::memoryBarrier();
+
+        Snapshot& back = snapshots_[((sequence>>1)+1) & 0x01U];
+        back.state_ = state;
+        back.position_ = position;
+        back.queuedDuration_ = queuedDuration;
+
+        lcore::memoryBarrier();
+        sequence_ = sequence + 2;
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef INC_LSOUND_DSP_USERPLAYER_H__
+#define INC_LSOUND_DSP_USERPLAYER_H__
+/**
+@file UserPlayer.h
+@author t-sakai
+@date 2015/07/07 create
+*/
+#include "../lsound.h"
+#include <lcore/async/LockFree.h>
+
+namespace lsound
+{
+    class Player;
+
+    /**
+    @brief Controls are written to slots which the context consumes at its next update,
+    the state is read from a snapshot published by the context. Nothing locks.
+    */
+    class UserPlayer
+    {
+    public:
+        struct Snapshot
+        {
+            s32 state_;
+            u32 position_; ///< played frames
+            f32 queuedDuration_; ///< seconds decoded but not played yet
+        };
+
+        bool checkFlag(PlayerFlag flag);
+        void setFlag(PlayerFlag flag);
+        void resetFlag(PlayerFlag flag);
+
+        void play();
+        void pause();
+
+        State getState();
+        void getSnapshot(Snapshot& snapshot);
+
+        void setGain(f32 gain);
+        void setPitch(f32 pitch);
+
+    private:
+        friend class MixerContext;
+        friend class Player;
+
+        UserPlayer(const UserPlayer&);
+        UserPlayer& operator=(const UserPlayer&);
+
+        enum Control
+        {
+            Control_Gain = (0x01U<<0),
+            Control_Pitch = (0x01U<<1),
+        };
+
+        enum Request
+        {
+            Request_None = 0,
+            Request_Play,
+            Request_Pause,
+            Request_Stop,
+        };
+
+        UserPlayer();
+        ~UserPlayer();
+
+        void reset();
+
+        /// Called by the context, take controls written since the last call
+        inline s32 takeControls();
+        inline s32 takeRequest();
+
+        /// Called by the context, only one thread publishes at a time
+        void publish(s32 state, u32 position, f32 queuedDuration);
+
+        volatile s32 refCount_; ///< the caller and the player
+        volatile s32 flags_;
+        volatile s32 controls_;
+        volatile s32 request_;
+        volatile f32 gain_;
+        volatile f32 pitch_;
+
+        /// Incremented before and after writing the back snapshot
+        volatile u32 sequence_;
+        Snapshot snapshots_[2];
+
+        volatile s32 generation_; ///< incremented when destroyed, u16 values in s32 for atomicCompareExchange
+    };
+
+    inline s32 UserPlayer::takeControls()
+    {
+        return (0 == controls_)? 0 : lcore::atomicExchange(&controls_, 0);
+    }
+
+    inline s32 UserPlayer::takeRequest()
+    {
+        return (Request_None == request_)? Request_None : lcore::atomicExchange(&request_, Request_None);
+    }
+}
+#endif //INC_LSOUND_DSP_USERPLAYER_H__
@@ -1,53 +1,57 @@
-/**
-@file dsp.cpp
-@author t-sakai
-@date 2015/07/08 create
-*/
-#include "dsp.h"
-#include <emmintrin.h>
-
-namespace lsound
-{
-    //----------------------------------------------------------------------------
-    //---
-    //--- Convert Number of Channels
-    //---
-    //----------------------------------------------------------------------------
+/**
+@file dsp.cpp
+@author t-sakai
+@date 2015/07/08 create
+*/
+#include "dsp.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define LSOUND_DSP_X86 (1)
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__aarch64__)
+#define LSOUND_DSP_NEON (1)
+#include <arm_neon.h>
+#endif
+
+//Kernels of higher levels are compiled without global flags, and called only when the cpu has them
+#if defined(__GNUC__)
+#define LSOUND_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define LSOUND_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LSOUND_TARGET_SSE41
+#define LSOUND_TARGET_AVX2
+#endif
+
+namespace lsound
+{
+    //----------------------------------------------------------------------------
+    //---
+    //--- Convert Number of Channels
+    //---
+    //----------------------------------------------------------------------------
     void conv_Short1ToShort2(void* dst, const void* s, s32 numSamples)
     {
         LSshort* d = reinterpret_cast<LSshort*>(dst);
         const LSshort* src = reinterpret_cast<const LSshort*>(s);
 
-        s32 num = numSamples >> 3; //8short܂Ƃ߂ď
-        s32 offset = num << 3;
-        s32 rem = numSamples - offset;
-
-        const LSshort* p = src;
-        LSshort* q = d;
-        for(s32 i=0; i<num; ++i){
-            __m128i t = _mm_loadu_si128((const __m128i*)p);
-            __m128i r0 = _mm_unpackhi_epi16(t, t);
-            __m128i r1 = _mm_unpacklo_epi16(t, t);
-            _mm_storeu_si128((__m128i*)(q+0), r1);
-            _mm_storeu_si128((__m128i*)(q+8), r0);
-            p += 8;
-            q += 16;
+        s32 i=0;
+#ifdef LSOUND_DSP_X86
+        for(; (i+8)<=numSamples; i+=8){
+            __m128i t = _mm_loadu_si128((const __m128i*)(src+i));
+            _mm_storeu_si128((__m128i*)(d+2*i+0), _mm_unpacklo_epi16(t, t));
+            _mm_storeu_si128((__m128i*)(d+2*i+8), _mm_unpackhi_epi16(t, t));
         }
-
-        for(s32 i=0; i<rem; ++i){
-            s32 j = i<<1;
-            q[j+0] = p[i];
-            q[j+1] = p[i];
-        }
-
-        //check
-        d = reinterpret_cast<LSshort*>(dst);
-        for(s32 i=0; i<numSamples; ++i){
-            if(d[2*i+0] != src[i]
-                || d[2*i+1] != src[i])
-            {
-                LASSERT(false);
-            }
+#endif
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = src[i];
         }
     }
 
@@ -56,41 +60,21 @@ namespace lsound
         LSshort* d = reinterpret_cast<LSshort*>(dst);
         const LSshort* src = reinterpret_cast<const LSshort*>(s);
 
-        s32 num = numSamples >> 2; //8short܂Ƃ߂ď
-        s32 offset = num << 2;
-        s32 rem = numSamples - offset;
-
-        const __m128i izero = _mm_setzero_si128();
-        __declspec(align(16)) LSshort tmp[8];
-
-        const LSshort* p = src;
-        LSshort* q = d;
-        for(s32 i=0; i<num; ++i){
-            //32bitr0, r1ɕϊ
-            __m128i t0 = _mm_loadu_si128((const __m128i*)p);
-            __m128i t1 = _mm_cmpgt_epi16(izero, t0);
-            __m128i r0 = _mm_unpackhi_epi16(t0, t1);
-            __m128i r1 = _mm_unpacklo_epi16(t0, t1);
-
-            __m128i r2 = _mm_add_epi32(r0, _mm_shuffle_epi32(r0, _MM_SHUFFLE(2, 3, 0, 1)));
-            __m128i r3 = _mm_add_epi32(r1, _mm_shuffle_epi32(r1, _MM_SHUFFLE(2, 3, 0, 1)));
-
-            r2 = _mm_srai_epi32(r2, 1);
-            r3 = _mm_srai_epi32(r3, 1);
-            __m128i r4 = _mm_packs_epi32(r3, r2);
-            _mm_store_si128((__m128i*)tmp, r4);
-            q[0] = tmp[0];
-            q[1] = tmp[2];
-            q[2] = tmp[4];
-            q[3] = tmp[6];
-            p += 8;
-            q += 4;
+        s32 i=0;
+#ifdef LSOUND_DSP_X86
+        //Sum pairs into 32bit
+        const __m128i ione = _mm_set1_epi16(1);
+        for(; (i+8)<=numSamples; i+=8){
+            __m128i r0 = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(src+2*i+0)), ione);
+            __m128i r1 = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(src+2*i+8)), ione);
+            r0 = _mm_srai_epi32(r0, 1);
+            r1 = _mm_srai_epi32(r1, 1);
+            _mm_storeu_si128((__m128i*)(d+i), _mm_packs_epi32(r0, r1));
         }
-
-        for(s32 i=0; i<rem; ++i){
-            s32 j = i<<1;
-            s32 t = (p[j+0] + p[j+1]) >> 1;
-            q[i] = static_cast<LSshort>(t);
+#endif
+        for(; i<numSamples; ++i){
+            s32 t = (src[2*i+0] + src[2*i+1]) >> 1;
+            d[i] = static_cast<LSshort>(t);
         }
     }
 
@@ -99,26 +83,16 @@ namespace lsound
         LSfloat* d = reinterpret_cast<LSfloat*>(dst);
         const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
 
-        s32 num = numSamples >> 2; //4float܂Ƃ߂ď
-        s32 offset = num << 2;
-        s32 rem = numSamples - offset;
-
-        const LSfloat* p = src;
-        LSfloat* q = d;
-        for(s32 i=0; i<num; ++i){
-            __m128 f32_0 = _mm_loadu_ps(p);
-            __m128 f32_1 = _mm_shuffle_ps(f32_0, f32_0, _MM_SHUFFLE(1, 1, 0, 0));
-            __m128 f32_2 = _mm_shuffle_ps(f32_0, f32_0, _MM_SHUFFLE(3, 3, 2, 2));
-
-            _mm_storeu_ps((q+0), f32_1);
-            _mm_storeu_ps((q+4), f32_2);
-            p += 4;
-            q += 8;
+        s32 i=0;
+#ifdef LSOUND_DSP_X86
+        for(; (i+4)<=numSamples; i+=4){
+            __m128 f32_0 = _mm_loadu_ps(src+i);
+            _mm_storeu_ps(d+2*i+0, _mm_unpacklo_ps(f32_0, f32_0));
+            _mm_storeu_ps(d+2*i+4, _mm_unpackhi_ps(f32_0, f32_0));
         }
-
-        for(s32 i=0; i<rem; ++i){
-            s32 j=i<<1;
-            q[j+0] = q[j+1] = p[i];
+#endif
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = src[i];
         }
     }
 
@@ -127,34 +101,27 @@ namespace lsound
         LSfloat* d = reinterpret_cast<LSfloat*>(dst);
         const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
 
-        s32 num = numSamples >> 2; //4float܂Ƃ߂ď
-        s32 offset = num << 2;
-        s32 rem = numSamples - offset;
-        __m128 coff = _mm_set1_ps(0.5f);
-
-        const LSfloat* p = src;
-        LSfloat* q = d;
-        for(s32 i=0; i<num; ++i){
-            __m128 f32_0 = _mm_loadu_ps(p);
-            __m128 f32_1 = _mm_shuffle_ps(f32_0, f32_0, _MM_SHUFFLE(2, 3, 1, 0));
-            __m128 f32_2 = _mm_mul_ps(_mm_add_ps(f32_0, f32_1), coff);
-            __m128 f32_3 = _mm_shuffle_ps(f32_2, f32_2, _MM_SHUFFLE(2, 0, 2, 0));
-
-            _mm_storel_pi((__m64*)q, f32_3);
-            p += 4;
-            q += 2;
+        s32 i=0;
+#ifdef LSOUND_DSP_X86
+        const __m128 coff = _mm_set1_ps(0.5f);
+        for(; (i+4)<=numSamples; i+=4){
+            __m128 f32_0 = _mm_loadu_ps(src+2*i+0);
+            __m128 f32_1 = _mm_loadu_ps(src+2*i+4);
+            //Deinterleave left and right
+            __m128 l = _mm_shuffle_ps(f32_0, f32_1, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 r = _mm_shuffle_ps(f32_0, f32_1, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(d+i, _mm_mul_ps(_mm_add_ps(l, r), coff));
         }
-
-        for(s32 i=0; i<rem; ++i){
-            s32 j=i<<1;
-            q[i] = 0.5f*(p[j+0]+p[j+1]);
+#endif
+        for(; i<numSamples; ++i){
+            d[i] = 0.5f*(src[2*i+0]+src[2*i+1]);
         }
     }
 
-    //----------------------------------------------------------------------------
-    //---
-    //--- Convert Type and Channels
-    //---
+    //----------------------------------------------------------------------------
+    //---
+    //--- Convert Type and Channels
+    //---
     //----------------------------------------------------------------------------
     void conv_Short1ToByte1(void* dst, const void* s, s32 numSamples)
     {
@@ -200,38 +167,27 @@ namespace lsound
         LSfloat* d = reinterpret_cast<LSfloat*>(dst);
         const LSshort* src = reinterpret_cast<const LSshort*>(s);
 
-        s32 num = numSamples >> 3; //8short܂Ƃ߂ď
-        s32 offset = num << 3;
-        s32 rem = numSamples - offset;
-
+        s32 i=0;
+#ifdef LSOUND_DSP_X86
         const __m128i izero = _mm_setzero_si128();
         const __m128 fcoff = _mm_set1_ps(1.0f/32767.0f);
-
-        const LSshort* p = src;
-        LSfloat* q = d;
-        for(s32 i=0; i<num; ++i){
-            //32bit_r0, r1ɕϊ
-            __m128i t0 = _mm_loadu_si128((const __m128i*)p);
+        for(; (i+8)<=numSamples; i+=8){
+            //Sign extend to 32bit
+            __m128i t0 = _mm_loadu_si128((const __m128i*)(src+i));
             __m128i t1 = _mm_cmpgt_epi16(izero, t0);
-            __m128 r0 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(t0, t1));
-            __m128 r1 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(t0, t1));
-
-            r0 = _mm_mul_ps(r0, fcoff);
-            r1 = _mm_mul_ps(r1, fcoff);
-            _mm_storeu_ps((q+0), r1);
-            _mm_storeu_ps((q+4), r0);
-            p += 8;
-            q += 8;
+            __m128 r0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(t0, t1));
+            __m128 r1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(t0, t1));
+            _mm_storeu_ps(d+i+0, _mm_mul_ps(r0, fcoff));
+            _mm_storeu_ps(d+i+4, _mm_mul_ps(r1, fcoff));
         }
-
-        for(s32 i=0; i<rem; ++i){
-            q[i] = toFloat(p[i]);
+#endif
+        for(; i<numSamples; ++i){
+            d[i] = toFloat(src[i]);
         }
     }
 
     void conv_Short2ToFloat2(void* dst, const void* s, s32 numSamples)
     {
-        //XeI2{
         conv_Short1ToFloat1(dst, s, numSamples<<1);
     }
 
@@ -240,92 +196,53 @@ namespace lsound
         LSfloat* d = reinterpret_cast<LSfloat*>(dst);
         const LSshort* src = reinterpret_cast<const LSshort*>(s);
 
-        s32 num = numSamples >> 3; //8short܂Ƃ߂ď
-        s32 offset = num << 3;
-        s32 rem = numSamples - offset;
-
+        s32 i=0;
+#ifdef LSOUND_DSP_X86
         const __m128i izero = _mm_setzero_si128();
         const __m128 fcoff = _mm_set1_ps(1.0f/32767.0f);
-
-        const LSshort* p = src;
-        LSfloat* q = d;
-        for(s32 i=0; i<num; ++i){
-            __m128i t = _mm_loadu_si128((const __m128i*)p);
-            __m128i s16_0 = _mm_unpackhi_epi16(t, t);
-            __m128i s16_1 = _mm_unpacklo_epi16(t, t);
-
-            __m128i t1 = _mm_cmpgt_epi16(izero, s16_0);
-            __m128i t2 = _mm_cmpgt_epi16(izero, s16_1);
-
-            __m128i s32_0 = _mm_unpackhi_epi16(s16_0, t1);
-            __m128i s32_1 = _mm_unpacklo_epi16(s16_0, t1);
-            __m128i s32_2 = _mm_unpackhi_epi16(s16_1, t2);
-            __m128i s32_3 = _mm_unpacklo_epi16(s16_1, t2);
-
-            //32bit_ɕϊ
-            __m128 f32_0 = _mm_mul_ps(_mm_cvtepi32_ps(s32_0), fcoff);
-            __m128 f32_1 = _mm_mul_ps(_mm_cvtepi32_ps(s32_1), fcoff);
-            __m128 f32_2 = _mm_mul_ps(_mm_cvtepi32_ps(s32_2), fcoff);
-            __m128 f32_3 = _mm_mul_ps(_mm_cvtepi32_ps(s32_3), fcoff);
-
-            _mm_storeu_ps((q+0), f32_3);
-            _mm_storeu_ps((q+4), f32_2);
-            _mm_storeu_ps((q+8), f32_1);
-            _mm_storeu_ps((q+12), f32_0);
-
-            p += 8;
-            q += 16;
+        for(; (i+8)<=numSamples; i+=8){
+            __m128i t = _mm_loadu_si128((const __m128i*)(src+i));
+            __m128i s16_0 = _mm_unpacklo_epi16(t, t);
+            __m128i s16_1 = _mm_unpackhi_epi16(t, t);
+            __m128i t0 = _mm_cmpgt_epi16(izero, s16_0);
+            __m128i t1 = _mm_cmpgt_epi16(izero, s16_1);
+
+            LSfloat* q = d + 2*i;
+            _mm_storeu_ps(q+0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(s16_0, t0)), fcoff));
+            _mm_storeu_ps(q+4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(s16_0, t0)), fcoff));
+            _mm_storeu_ps(q+8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(s16_1, t1)), fcoff));
+            _mm_storeu_ps(q+12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(s16_1, t1)), fcoff));
         }
-
-        for(s32 i=0; i<rem; ++i){
-            s32 j = i<<1;
-            q[j+0] = toFloat(p[i]);
-            q[j+1] = toFloat(p[i]);
+#endif
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = toFloat(src[i]);
         }
     }
 
-    void conv_Short2ToFloat1(void* dst, const void* s, s32 numSamples)
-    {
+    void conv_Short2ToFloat1(void* dst, const void* s, s32 numSamples)
+    {
         LSfloat* d = reinterpret_cast<LSfloat*>(dst);
         const LSshort* src = reinterpret_cast<const LSshort*>(s);
 
-        s32 num = numSamples >> 2; //8short܂Ƃ߂ď
-        s32 offset = num << 2;
-        s32 rem = numSamples - offset;
-
-        const __m128i izero = _mm_setzero_si128();
+        s32 i=0;
+#ifdef LSOUND_DSP_X86
+        const __m128i ione = _mm_set1_epi16(1);
         const __m128 fcoff = _mm_set1_ps(0.5f/32767.0f); //half
-
-        const LSshort* p = src;
-        LSfloat* q = d;
-        for(s32 i=0; i<num; ++i){
-            //32bitɕϊ
-            __m128i t0 = _mm_loadu_si128((const __m128i*)p);
-            __m128i t1 = _mm_cmpgt_epi16(izero, t0);
-            __m128i s32_0 = _mm_unpackhi_epi16(t0, t1);
-            __m128i s32_1 = _mm_unpacklo_epi16(t0, t1);
-
-            //32bit_ɕϊ
-            __m128 f32_0 = _mm_mul_ps(_mm_cvtepi32_ps(s32_0), fcoff);
-            __m128 f32_1 = _mm_mul_ps(_mm_cvtepi32_ps(s32_1), fcoff);
-
-            __m128 f32_2 = _mm_add_ps(f32_0, _mm_shuffle_ps(f32_0, f32_0, _MM_SHUFFLE(2, 3, 0, 1)));
-            __m128 f32_3 = _mm_add_ps(f32_1, _mm_shuffle_ps(f32_1, f32_1, _MM_SHUFFLE(2, 3, 0, 1)));
-            __m128 r = _mm_shuffle_ps(f32_3, f32_2, _MM_SHUFFLE(2, 0, 2, 0));
-
-            _mm_storeu_ps(q, r);
-            p += 8;
-            q += 4;
+        for(; (i+8)<=numSamples; i+=8){
+            //Sum pairs into 32bit
+            __m128i s32_0 = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(src+2*i+0)), ione);
+            __m128i s32_1 = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(src+2*i+8)), ione);
+            _mm_storeu_ps(d+i+0, _mm_mul_ps(_mm_cvtepi32_ps(s32_0), fcoff));
+            _mm_storeu_ps(d+i+4, _mm_mul_ps(_mm_cvtepi32_ps(s32_1), fcoff));
+        }
+#endif
+        for(; i<numSamples; ++i){
+            d[i] = 0.5f*(toFloat(src[2*i+0]) + toFloat(src[2*i+1]));
         }
+    }
 
-        for(s32 i=0; i<rem; ++i){
-            s32 j = i<<1;
-            q[i] = 0.5f*(toFloat(p[j+0]) + toFloat(p[j+1]));
-        }
-    }
-
-
-    //----------------------------------------------------------------------------
+
+    //----------------------------------------------------------------------------
     void conv_Float1ToByte1(void* dst, const void* s, s32 numSamples)
     {
         LSbyte* d = reinterpret_cast<LSbyte*>(dst);
@@ -370,187 +287,1062 @@ namespace lsound
         LSshort* d = reinterpret_cast<LSshort*>(dst);
         const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
 
-        s32 num = numSamples >> 2; //4float܂Ƃ߂ď
-        //XgAp4TvO
-        if(0<num){
-            --num;
+        s32 i=0;
+#ifdef LSOUND_DSP_X86
+        //Saturated by packs
+        const __m128 fcoff = _mm_set1_ps(32768.0f);
+        for(; (i+8)<=numSamples; i+=8){
+            __m128i s32_0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src+i+0), fcoff));
+            __m128i s32_1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src+i+4), fcoff));
+            _mm_storeu_si128((__m128i*)(d+i), _mm_packs_epi32(s32_0, s32_1));
+        }
+#endif
+        for(; i<numSamples; ++i){
+            d[i] = toShort(src[i]);
         }
-        s32 offset = num << 2;
-        s32 rem = numSamples - offset;
+    }
+
+    void conv_Float2ToShort2(void* dst, const void* s, s32 numSamples)
+    {
+        conv_Float1ToShort1(dst, s, numSamples<<1);
+    }
+
+    void conv_Float1ToShort2(void* dst, const void* s, s32 numSamples)
+    {
+        LSshort* d = reinterpret_cast<LSshort*>(dst);
+        const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
 
+        s32 i=0;
+#ifdef LSOUND_DSP_X86
         const __m128 fcoff = _mm_set1_ps(32768.0f);
+        for(; (i+8)<=numSamples; i+=8){
+            __m128i s32_0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src+i+0), fcoff));
+            __m128i s32_1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src+i+4), fcoff));
+            __m128i s16_0 = _mm_packs_epi32(s32_0, s32_1);
+            _mm_storeu_si128((__m128i*)(d+2*i+0), _mm_unpacklo_epi16(s16_0, s16_0));
+            _mm_storeu_si128((__m128i*)(d+2*i+8), _mm_unpackhi_epi16(s16_0, s16_0));
+        }
+#endif
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = toShort(src[i]);
+        }
+    }
+
+    void conv_Float2ToShort1(void* dst, const void* s, s32 numSamples)
+    {
+        LSshort* d = reinterpret_cast<LSshort*>(dst);
+        const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
+
+        s32 i=0;
+#ifdef LSOUND_DSP_X86
+        const __m128 fcoff = _mm_set1_ps(32768.0f*0.5f); //half
+        for(; (i+8)<=numSamples; i+=8){
+            const LSfloat* p = src + 2*i;
+            __m128 f32_0 = _mm_loadu_ps(p+0);
+            __m128 f32_1 = _mm_loadu_ps(p+4);
+            __m128 f32_2 = _mm_loadu_ps(p+8);
+            __m128 f32_3 = _mm_loadu_ps(p+12);
+            //Deinterleave left and right
+            __m128 s0 = _mm_add_ps(_mm_shuffle_ps(f32_0, f32_1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(f32_0, f32_1, _MM_SHUFFLE(3, 1, 3, 1)));
+            __m128 s1 = _mm_add_ps(_mm_shuffle_ps(f32_2, f32_3, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(f32_2, f32_3, _MM_SHUFFLE(3, 1, 3, 1)));
+
+            __m128i s32_0 = _mm_cvtps_epi32(_mm_mul_ps(s0, fcoff));
+            __m128i s32_1 = _mm_cvtps_epi32(_mm_mul_ps(s1, fcoff));
+            _mm_storeu_si128((__m128i*)(d+i), _mm_packs_epi32(s32_0, s32_1));
+        }
+#endif
+        for(; i<numSamples; ++i){
+            f32 v = 0.5f*(src[2*i+0] + src[2*i+1]);
+            d[i] = toShort(v);
+        }
+    }
 
-        const LSfloat* p = src;
-        LSshort* q = d;
-        for(s32 i=0; i<num; ++i){
-            __m128 f32_0 = _mm_mul_ps(_mm_loadu_ps(p), fcoff);
-            __m128i s32_0 = _mm_cvtps_epi32(f32_0);
-            __m128i s16_0 = _mm_packs_epi32(s32_0, s32_0);
+    //----------------------------------------------------------------------------
+    //---
+    //--- Filter
+    //---
+    //----------------------------------------------------------------------------
+#ifdef LSOUND_DSP_X86
+    static inline f32 horizontalSum(__m128 v)
+    {
+        __m128 t = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        t = _mm_add_ss(t, _mm_shuffle_ps(t, t, 0x01));
+        return _mm_cvtss_f32(t);
+    }
+#endif
 
-            _mm_storeu_si128((__m128i*)q, s16_0);
-            p += 4;
-            q += 4;
+    void filter_1(LSfloat* dst, const f32* taps, const f32* const* x, s32 numTaps)
+    {
+        const f32* x0 = x[0];
+
+        s32 i=0;
+        f32 sum0 = 0.0f;
+#ifdef LSOUND_DSP_X86
+        __m128 s0 = _mm_setzero_ps();
+        __m128 s1 = _mm_setzero_ps();
+        for(; (i+8)<=numTaps; i+=8){
+            s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_load_ps(taps+i+0), _mm_loadu_ps(x0+i+0)));
+            s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_load_ps(taps+i+4), _mm_loadu_ps(x0+i+4)));
+        }
+        sum0 = horizontalSum(_mm_add_ps(s0, s1));
+#endif
+        for(; i<numTaps; ++i){
+            sum0 += taps[i]*x0[i];
         }
+        dst[0] = sum0;
+    }
 
-        for(s32 i=0; i<rem; ++i){
-            q[i] = toShort(p[i]);
+    void filter_2(LSfloat* dst, const f32* taps, const f32* const* x, s32 numTaps)
+    {
+        const f32* x0 = x[0];
+        const f32* x1 = x[1];
+
+        s32 i=0;
+        f32 sum0 = 0.0f;
+        f32 sum1 = 0.0f;
+#ifdef LSOUND_DSP_X86
+        __m128 s00 = _mm_setzero_ps();
+        __m128 s01 = _mm_setzero_ps();
+        __m128 s10 = _mm_setzero_ps();
+        __m128 s11 = _mm_setzero_ps();
+        for(; (i+8)<=numTaps; i+=8){
+            __m128 t0 = _mm_load_ps(taps+i+0);
+            __m128 t1 = _mm_load_ps(taps+i+4);
+            s00 = _mm_add_ps(s00, _mm_mul_ps(t0, _mm_loadu_ps(x0+i+0)));
+            s01 = _mm_add_ps(s01, _mm_mul_ps(t1, _mm_loadu_ps(x0+i+4)));
+            s10 = _mm_add_ps(s10, _mm_mul_ps(t0, _mm_loadu_ps(x1+i+0)));
+            s11 = _mm_add_ps(s11, _mm_mul_ps(t1, _mm_loadu_ps(x1+i+4)));
+        }
+        sum0 = horizontalSum(_mm_add_ps(s00, s01));
+        sum1 = horizontalSum(_mm_add_ps(s10, s11));
+#endif
+        for(; i<numTaps; ++i){
+            sum0 += taps[i]*x0[i];
+            sum1 += taps[i]*x1[i];
         }
+        dst[0] = sum0;
+        dst[1] = sum1;
     }
 
-    void conv_Float2ToShort2(void* dst, const void* s, s32 numSamples)
+    //----------------------------------------------------------------------------
+    //---
+    //--- Dither
+    //---
+    //----------------------------------------------------------------------------
+    static inline u32 xorshift32(u32& s)
     {
-        conv_Float1ToShort1(dst, s, numSamples<<1);
-    }
-
-    void conv_Float1ToShort2(void* dst, const void* s, s32 numSamples)
+        s ^= s<<13;
+        s ^= s>>17;
+        s ^= s<<5;
+        return s;
+    }
+
+    /// Uniform in [0, 1) from the upper bits
+    static inline f32 toUniform(u32 x)
+    {
+        union
+        {
+            u32 u_;
+            f32 f_;
+        } t;
+        t.u_ = (x>>9) | 0x3F800000U;
+        return t.f_ - 1.0f;
+    }
+
+    /// Triangular in (-1, 1)
+    static inline f32 triangular(u32& s)
+    {
+        f32 r0 = toUniform(xorshift32(s));
+        return r0 - toUniform(xorshift32(s));
+    }
+
+    static inline LSshort quantize(f32 x)
+    {
+        x = lcore::clamp(x, -32768.0f, 32767.0f);
+        return static_cast<LSshort>((x<0.0f)? x-0.5f : x+0.5f);
+    }
+
+#ifdef LSOUND_DSP_X86
+    /// Uniform in [1, 2) of each lane
+    static inline __m128 uniform_SSE2(__m128i& seed)
+    {
+        seed = _mm_xor_si128(seed, _mm_slli_epi32(seed, 13));
+        seed = _mm_xor_si128(seed, _mm_srli_epi32(seed, 17));
+        seed = _mm_xor_si128(seed, _mm_slli_epi32(seed, 5));
+        return _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(seed, 9), _mm_set1_epi32(0x3F800000)));
+    }
+#endif
+
+    void initializeDither(DitherState& state, u32 seed)
+    {
+        //Lanes start apart, zero never comes out of xorshift
+        for(s32 i=0; i<4; ++i){
+            seed = seed*1664525U + 1013904223U;
+            state.seeds_[i] = (0 == seed)? 0x6C078965U : seed;
+        }
+        for(s32 i=0; i<2; ++i){
+            state.errors_[i][0] = state.errors_[i][1] = 0.0f;
+        }
+    }
+
+    void dither_Float(LSshort* dst, const LSfloat* src, s32 numSamples, u16 /*numChannels*/, f32 gain, DitherState& state)
+    {
+        const f32 scale = 32768.0f*gain;
+
+        s32 i=0;
+#ifdef LSOUND_DSP_X86
+        const __m128 fscale = _mm_set1_ps(scale);
+        const __m128 fmin = _mm_set1_ps(-32768.0f);
+        const __m128 fmax = _mm_set1_ps(32767.0f);
+        __m128i seed = _mm_loadu_si128((const __m128i*)state.seeds_);
+        for(; (i+8)<=numSamples; i+=8){
+            __m128 r0 = _mm_sub_ps(uniform_SSE2(seed), uniform_SSE2(seed));
+            __m128 r1 = _mm_sub_ps(uniform_SSE2(seed), uniform_SSE2(seed));
+            __m128 f32_0 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src+i+0), fscale), r0);
+            __m128 f32_1 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src+i+4), fscale), r1);
+            f32_0 = _mm_min_ps(_mm_max_ps(f32_0, fmin), fmax);
+            f32_1 = _mm_min_ps(_mm_max_ps(f32_1, fmin), fmax);
+            _mm_storeu_si128((__m128i*)(dst+i), _mm_packs_epi32(_mm_cvtps_epi32(f32_0), _mm_cvtps_epi32(f32_1)));
+        }
+        _mm_storeu_si128((__m128i*)state.seeds_, seed);
+#endif
+        for(; i<numSamples; ++i){
+            dst[i] = quantize(scale*src[i] + triangular(state.seeds_[i&3]));
+        }
+    }
+
+    void dither_FloatShaped(LSshort* dst, const LSfloat* src, s32 numSamples, u16 numChannels, f32 gain, DitherState& state)
+    {
+        LASSERT(1 == numChannels || 2 == numChannels);
+        const f32 scale = 32768.0f*gain;
+
+        //Second order highpass of errors, (1-z^-1)^2, moves noise above the most audible band
+        for(s32 i=0; i<numSamples; i+=numChannels){
+            for(u16 c=0; c<numChannels; ++c){
+                f32* e = state.errors_[c];
+                f32 x = scale*src[i+c] - (2.0f*e[0] - e[1]);
+                LSshort y = quantize(x + triangular(state.seeds_[c]));
+                e[1] = e[0];
+                e[0] = lcore::clamp(static_cast<f32>(y) - x, -4.0f, 4.0f);
+                dst[i+c] = y;
+            }
+        }
+    }
+
+namespace
+{
+#ifdef LSOUND_DSP_X86
+    //----------------------------------------------------------------------------
+    //---
+    //--- SSE4.1
+    //---
+    //----------------------------------------------------------------------------
+    LSOUND_TARGET_SSE41 void conv_Short1ToFloat1_SSE41(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSshort* src = reinterpret_cast<const LSshort*>(s);
+
+        s32 i=0;
+        const __m128 fcoff = _mm_set1_ps(1.0f/32767.0f);
+        for(; (i+8)<=numSamples; i+=8){
+            __m128i t = _mm_loadu_si128((const __m128i*)(src+i));
+            __m128 r0 = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(t));
+            __m128 r1 = _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(t, 8)));
+            _mm_storeu_ps(d+i+0, _mm_mul_ps(r0, fcoff));
+            _mm_storeu_ps(d+i+4, _mm_mul_ps(r1, fcoff));
+        }
+        for(; i<numSamples; ++i){
+            d[i] = toFloat(src[i]);
+        }
+    }
+
+    LSOUND_TARGET_SSE41 void conv_Short2ToFloat2_SSE41(void* dst, const void* s, s32 numSamples)
+    {
+        conv_Short1ToFloat1_SSE41(dst, s, numSamples<<1);
+    }
+
+    LSOUND_TARGET_SSE41 void conv_Short1ToFloat2_SSE41(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSshort* src = reinterpret_cast<const LSshort*>(s);
+
+        s32 i=0;
+        const __m128 fcoff = _mm_set1_ps(1.0f/32767.0f);
+        for(; (i+8)<=numSamples; i+=8){
+            __m128i t = _mm_loadu_si128((const __m128i*)(src+i));
+            __m128i s16_0 = _mm_unpacklo_epi16(t, t);
+            __m128i s16_1 = _mm_unpackhi_epi16(t, t);
+
+            LSfloat* q = d + 2*i;
+            _mm_storeu_ps(q+0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(s16_0)), fcoff));
+            _mm_storeu_ps(q+4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(s16_0, 8))), fcoff));
+            _mm_storeu_ps(q+8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(s16_1)), fcoff));
+            _mm_storeu_ps(q+12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_srli_si128(s16_1, 8))), fcoff));
+        }
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = toFloat(src[i]);
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    //---
+    //--- AVX2
+    //---
+    //----------------------------------------------------------------------------
+    LSOUND_TARGET_AVX2 void conv_Short1ToFloat1_AVX2(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSshort* src = reinterpret_cast<const LSshort*>(s);
+
+        s32 i=0;
+        const __m256 fcoff = _mm256_set1_ps(1.0f/32767.0f);
+        for(; (i+16)<=numSamples; i+=16){
+            __m256i s32_0 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src+i+0)));
+            __m256i s32_1 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src+i+8)));
+            _mm256_storeu_ps(d+i+0, _mm256_mul_ps(_mm256_cvtepi32_ps(s32_0), fcoff));
+            _mm256_storeu_ps(d+i+8, _mm256_mul_ps(_mm256_cvtepi32_ps(s32_1), fcoff));
+        }
+        for(; i<numSamples; ++i){
+            d[i] = toFloat(src[i]);
+        }
+    }
+
+    LSOUND_TARGET_AVX2 void conv_Short2ToFloat2_AVX2(void* dst, const void* s, s32 numSamples)
+    {
+        conv_Short1ToFloat1_AVX2(dst, s, numSamples<<1);
+    }
+
+    LSOUND_TARGET_AVX2 void conv_Short1ToFloat2_AVX2(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSshort* src = reinterpret_cast<const LSshort*>(s);
+
+        s32 i=0;
+        const __m256 fcoff = _mm256_set1_ps(1.0f/32767.0f);
+        for(; (i+8)<=numSamples; i+=8){
+            __m128i t = _mm_loadu_si128((const __m128i*)(src+i));
+            __m256i s32_0 = _mm256_cvtepi16_epi32(_mm_unpacklo_epi16(t, t));
+            __m256i s32_1 = _mm256_cvtepi16_epi32(_mm_unpackhi_epi16(t, t));
+            _mm256_storeu_ps(d+2*i+0, _mm256_mul_ps(_mm256_cvtepi32_ps(s32_0), fcoff));
+            _mm256_storeu_ps(d+2*i+8, _mm256_mul_ps(_mm256_cvtepi32_ps(s32_1), fcoff));
+        }
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = toFloat(src[i]);
+        }
+    }
+
+    LSOUND_TARGET_AVX2 void conv_Short2ToFloat1_AVX2(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSshort* src = reinterpret_cast<const LSshort*>(s);
+
+        s32 i=0;
+        const __m256i ione = _mm256_set1_epi16(1);
+        const __m256 fcoff = _mm256_set1_ps(0.5f/32767.0f); //half
+        for(; (i+16)<=numSamples; i+=16){
+            //Pairs summed in each 128bit lane keep their order
+            __m256i s32_0 = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(src+2*i+0)), ione);
+            __m256i s32_1 = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(src+2*i+16)), ione);
+            _mm256_storeu_ps(d+i+0, _mm256_mul_ps(_mm256_cvtepi32_ps(s32_0), fcoff));
+            _mm256_storeu_ps(d+i+8, _mm256_mul_ps(_mm256_cvtepi32_ps(s32_1), fcoff));
+        }
+        for(; i<numSamples; ++i){
+            d[i] = 0.5f*(toFloat(src[2*i+0]) + toFloat(src[2*i+1]));
+        }
+    }
+
+    LSOUND_TARGET_AVX2 void conv_Float1ToShort1_AVX2(void* dst, const void* s, s32 numSamples)
     {
         LSshort* d = reinterpret_cast<LSshort*>(dst);
         const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
 
-        s32 num = numSamples >> 2; //4float܂Ƃ߂ď
-        s32 offset = num << 2;
-        s32 rem = numSamples - offset;
+        s32 i=0;
+        const __m256 fcoff = _mm256_set1_ps(32768.0f);
+        for(; (i+16)<=numSamples; i+=16){
+            __m256i s32_0 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src+i+0), fcoff));
+            __m256i s32_1 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src+i+8), fcoff));
+            //packs works in 128bit lanes, put 64bit blocks back in order
+            __m256i s16_0 = _mm256_packs_epi32(s32_0, s32_1);
+            _mm256_storeu_si256((__m256i*)(d+i), _mm256_permute4x64_epi64(s16_0, _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+        for(; i<numSamples; ++i){
+            d[i] = toShort(src[i]);
+        }
+    }
 
-        const __m128 fcoff = _mm_set1_ps(32768.0f);
-        __declspec(align(16)) LSshort tmp[8];
-
-        const LSfloat* p = src;
-        LSshort* q = d;
-        for(s32 i=0; i<num; ++i){
-            __m128 f32_0 = _mm_mul_ps(_mm_loadu_ps(p), fcoff);
-            __m128i s32_0 = _mm_cvtps_epi32(f32_0);
-            __m128i s16_0 = _mm_packs_epi32(s32_0, s32_0);
-
-            _mm_store_si128((__m128i*)tmp, s16_0);
-
-            q[0] = tmp[0];
-            q[1] = tmp[0];
-            q[2] = tmp[1];
-            q[3] = tmp[1];
-            q[4] = tmp[2];
-            q[5] = tmp[2];
-            q[6] = tmp[3];
-            q[7] = tmp[3];
-            p += 4;
-            q += 8;
-        }
-
-        for(s32 i=0; i<rem; ++i){
-            s32 j=i<<1;
-            q[j+0] = q[j+1] = toShort(p[i]);
-        }
-    }
-
-    void conv_Float2ToShort1(void* dst, const void* s, s32 numSamples)
+    LSOUND_TARGET_AVX2 void conv_Float2ToShort2_AVX2(void* dst, const void* s, s32 numSamples)
+    {
+        conv_Float1ToShort1_AVX2(dst, s, numSamples<<1);
+    }
+
+    LSOUND_TARGET_AVX2 void conv_Float1ToShort2_AVX2(void* dst, const void* s, s32 numSamples)
     {
         LSshort* d = reinterpret_cast<LSshort*>(dst);
         const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
 
-        s32 num = numSamples >> 2; //4float܂Ƃ߂ď
-        s32 offset = num << 2;
-        s32 rem = numSamples - offset;
+        s32 i=0;
+        const __m256 fcoff = _mm256_set1_ps(32768.0f);
+        for(; (i+16)<=numSamples; i+=16){
+            __m256i s32_0 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src+i+0), fcoff));
+            __m256i s32_1 = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src+i+8), fcoff));
+            //Lanes hold 0-3 8-11 | 4-7 12-15, so unpacking in lanes gives 0-7 and 8-15
+            __m256i s16_0 = _mm256_packs_epi32(s32_0, s32_1);
+            _mm256_storeu_si256((__m256i*)(d+2*i+0), _mm256_unpacklo_epi16(s16_0, s16_0));
+            _mm256_storeu_si256((__m256i*)(d+2*i+16), _mm256_unpackhi_epi16(s16_0, s16_0));
+        }
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = toShort(src[i]);
+        }
+    }
 
-        const __m128 fcoff = _mm_set1_ps(32768.0f*0.5f); //half
-        __declspec(align(16)) LSshort tmp[8];
+    LSOUND_TARGET_AVX2 void conv_Float2ToShort1_AVX2(void* dst, const void* s, s32 numSamples)
+    {
+        LSshort* d = reinterpret_cast<LSshort*>(dst);
+        const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
 
-        const LSfloat* p = src;
-        LSshort* q = d;
-        for(s32 i=0; i<num; ++i){
-            __m128 f32_0 = _mm_loadu_ps(p);
-            __m128 f32_1 = _mm_add_ps(f32_0, _mm_shuffle_ps(f32_0, f32_0, _MM_SHUFFLE(2, 3, 0, 1)));
-            __m128 f32_2 = _mm_mul_ps(f32_1, fcoff);
+        s32 i=0;
+        const __m256 fcoff = _mm256_set1_ps(32768.0f*0.5f); //half
+        for(; (i+16)<=numSamples; i+=16){
+            const LSfloat* p = src + 2*i;
+            //hadd sums pairs as 0 1 4 5 | 2 3 6 7
+            __m256 f32_0 = _mm256_hadd_ps(_mm256_loadu_ps(p+0), _mm256_loadu_ps(p+8));
+            __m256 f32_1 = _mm256_hadd_ps(_mm256_loadu_ps(p+16), _mm256_loadu_ps(p+24));
+            __m256i s32_0 = _mm256_cvtps_epi32(_mm256_mul_ps(f32_0, fcoff));
+            __m256i s32_1 = _mm256_cvtps_epi32(_mm256_mul_ps(f32_1, fcoff));
+            //packs makes 0 1 4 5 8 9 12 13 | 2 3 6 7 10 11 14 15 in 32bit pairs
+            __m256i s16_0 = _mm256_packs_epi32(s32_0, s32_1);
+            s16_0 = _mm256_permutevar8x32_epi32(s16_0, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+            _mm256_storeu_si256((__m256i*)(d+i), s16_0);
+        }
+        for(; i<numSamples; ++i){
+            f32 v = 0.5f*(src[2*i+0] + src[2*i+1]);
+            d[i] = toShort(v);
+        }
+    }
+
+    LSOUND_TARGET_AVX2 void conv_Float1ToFloat2_AVX2(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
 
-            __m128i s32_0 = _mm_cvtps_epi32(f32_2);
-            __m128i s16_0 = _mm_packs_epi32(s32_0, s32_0);
+        s32 i=0;
+        for(; (i+8)<=numSamples; i+=8){
+            __m256 f32_0 = _mm256_loadu_ps(src+i);
+            __m256 lo = _mm256_unpacklo_ps(f32_0, f32_0);
+            __m256 hi = _mm256_unpackhi_ps(f32_0, f32_0);
+            _mm256_storeu_ps(d+2*i+0, _mm256_permute2f128_ps(lo, hi, 0x20));
+            _mm256_storeu_ps(d+2*i+8, _mm256_permute2f128_ps(lo, hi, 0x31));
+        }
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = src[i];
+        }
+    }
 
-            _mm_store_si128((__m128i*)tmp, s16_0);
+    LSOUND_TARGET_AVX2 void conv_Float2ToFloat1_AVX2(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
 
-            q[0] = tmp[0];
-            q[1] = tmp[2];
-            p += 4;
-            q += 2;
+        s32 i=0;
+        const __m256 coff = _mm256_set1_ps(0.5f);
+        for(; (i+8)<=numSamples; i+=8){
+            //hadd sums pairs as 0 1 4 5 | 2 3 6 7
+            __m256 f32_0 = _mm256_hadd_ps(_mm256_loadu_ps(src+2*i+0), _mm256_loadu_ps(src+2*i+8));
+            f32_0 = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(f32_0), _MM_SHUFFLE(3, 1, 2, 0)));
+            _mm256_storeu_ps(d+i, _mm256_mul_ps(f32_0, coff));
+        }
+        for(; i<numSamples; ++i){
+            d[i] = 0.5f*(src[2*i+0]+src[2*i+1]);
         }
+    }
 
-        for(s32 i=0; i<rem; ++i){
-            s32 j = i<<1;
-            f32 v = 0.5f*(src[j+0] + src[j+1]);
-            q[i] = toShort(v);
-        }
-    }
-
-    //----------------------------------------------------------------------------
-namespace
-{
-    u16 convBytesSampleToID(u16 bytesPerSample)
-    {
-        switch(bytesPerSample)
-        {
-        case 1:
-            return 0;
-        case 2:
-            return 1;
-        case 4:
-            return 2;
-        default:
-            return -1;
-        }
-    }
-
-    u16 convChannelsToID(u16 numChannels)
-    {
-        switch(numChannels)
-        {
-        case 1:
-            return 0;
-        case 2:
-            return 1;
-        default:
-            return -1;
-        }
-    }
-
-    static ConvTypeFunc ConvTypeFuncTable[24] =
-    {
-        //short to byte
-        conv_Short1ToByte1, conv_Short1ToByte2, conv_Short2ToByte1, conv_Short2ToByte2,
-        //short to shot
-        NULL, conv_Short1ToShort2, conv_Short2ToShort1, NULL,
-        //short to float
-        conv_Short1ToFloat1, conv_Short1ToFloat2, conv_Short2ToFloat1, conv_Short2ToFloat2,
-
-        //float to byte
-        conv_Float1ToByte1, conv_Float1ToByte2, conv_Float2ToByte1, conv_Float2ToByte2,
-        //float to short
-        conv_Float1ToShort1, conv_Float1ToShort2, conv_Float2ToShort1, conv_Float2ToShort2,
-        //float to float
-        NULL, conv_Float1ToFloat2, conv_Float2ToFloat1, NULL,
-    };
-}
-
-    ConvTypeFunc getConvTypeFunc(u16 dstNumChannels, u16 dstBytesPerSample, u16 srcNumChannels, u16 srcBytesPerSample)
-    {
-        LASSERT(8 != srcBytesPerSample);
-        dstNumChannels = convChannelsToID(dstNumChannels);
-        dstBytesPerSample = convBytesSampleToID(dstBytesPerSample);
-        srcNumChannels = convChannelsToID(srcNumChannels);
-        srcBytesPerSample = convBytesSampleToID(srcBytesPerSample);
-
-        s32 channel = srcNumChannels*2 + dstNumChannels;
-
-        switch(srcBytesPerSample)
-        {
-        case 1:
-            {
-                s32 type = dstBytesPerSample*4;
-                return ConvTypeFuncTable[type+channel];
-            }
-            break;
-        case 2:
-            {
-                s32 type = dstBytesPerSample*4 + 12;
-                return ConvTypeFuncTable[type+channel];
-            }
-            break;
-        }
-    }
-}
+    //----------------------------------------------------------------------------
+    LSOUND_TARGET_AVX2 void filter_1_AVX2(LSfloat* dst, const f32* taps, const f32* const* x, s32 numTaps)
+    {
+        const f32* x0 = x[0];
+
+        s32 i=0;
+        __m256 s0 = _mm256_setzero_ps();
+        __m256 s1 = _mm256_setzero_ps();
+        for(; (i+16)<=numTaps; i+=16){
+            s0 = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_load_ps(taps+i+0), _mm256_loadu_ps(x0+i+0)));
+            s1 = _mm256_add_ps(s1, _mm256_mul_ps(_mm256_load_ps(taps+i+8), _mm256_loadu_ps(x0+i+8)));
+        }
+        for(; (i+8)<=numTaps; i+=8){
+            s0 = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_load_ps(taps+i), _mm256_loadu_ps(x0+i)));
+        }
+        s0 = _mm256_add_ps(s0, s1);
+        f32 sum0 = horizontalSum(_mm_add_ps(_mm256_castps256_ps128(s0), _mm256_extractf128_ps(s0, 1)));
+        for(; i<numTaps; ++i){
+            sum0 += taps[i]*x0[i];
+        }
+        dst[0] = sum0;
+    }
+
+    LSOUND_TARGET_AVX2 void filter_2_AVX2(LSfloat* dst, const f32* taps, const f32* const* x, s32 numTaps)
+    {
+        const f32* x0 = x[0];
+        const f32* x1 = x[1];
+
+        s32 i=0;
+        __m256 s0 = _mm256_setzero_ps();
+        __m256 s1 = _mm256_setzero_ps();
+        for(; (i+8)<=numTaps; i+=8){
+            __m256 t = _mm256_load_ps(taps+i);
+            s0 = _mm256_add_ps(s0, _mm256_mul_ps(t, _mm256_loadu_ps(x0+i)));
+            s1 = _mm256_add_ps(s1, _mm256_mul_ps(t, _mm256_loadu_ps(x1+i)));
+        }
+        f32 sum0 = horizontalSum(_mm_add_ps(_mm256_castps256_ps128(s0), _mm256_extractf128_ps(s0, 1)));
+        f32 sum1 = horizontalSum(_mm_add_ps(_mm256_castps256_ps128(s1), _mm256_extractf128_ps(s1, 1)));
+        for(; i<numTaps; ++i){
+            sum0 += taps[i]*x0[i];
+            sum1 += taps[i]*x1[i];
+        }
+        dst[0] = sum0;
+        dst[1] = sum1;
+    }
+#endif //LSOUND_DSP_X86
+
+#ifdef LSOUND_DSP_NEON
+    //----------------------------------------------------------------------------
+    //---
+    //--- NEON
+    //---
+    //----------------------------------------------------------------------------
+    /// Round half away from zero, conversions of NEON truncate and saturate
+    inline int32x4_t roundToInt(float32x4_t x)
+    {
+        uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(0x80000000U));
+        float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(sign, vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+        return vcvtq_s32_f32(vaddq_f32(x, half));
+    }
+
+    void conv_Short1ToShort2_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        LSshort* d = reinterpret_cast<LSshort*>(dst);
+        const LSshort* src = reinterpret_cast<const LSshort*>(s);
+
+        s32 i=0;
+        for(; (i+8)<=numSamples; i+=8){
+            int16x8x2_t t;
+            t.val[0] = t.val[1] = vld1q_s16(src+i);
+            vst2q_s16(d+2*i, t);
+        }
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = src[i];
+        }
+    }
+
+    void conv_Short2ToShort1_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        LSshort* d = reinterpret_cast<LSshort*>(dst);
+        const LSshort* src = reinterpret_cast<const LSshort*>(s);
+
+        s32 i=0;
+        for(; (i+8)<=numSamples; i+=8){
+            int16x8x2_t t = vld2q_s16(src+2*i);
+            vst1q_s16(d+i, vhaddq_s16(t.val[0], t.val[1]));
+        }
+        for(; i<numSamples; ++i){
+            s32 t = (src[2*i+0] + src[2*i+1]) >> 1;
+            d[i] = static_cast<LSshort>(t);
+        }
+    }
+
+    void conv_Float1ToFloat2_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
+
+        s32 i=0;
+        for(; (i+4)<=numSamples; i+=4){
+            float32x4x2_t t;
+            t.val[0] = t.val[1] = vld1q_f32(src+i);
+            vst2q_f32(d+2*i, t);
+        }
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = src[i];
+        }
+    }
+
+    void conv_Float2ToFloat1_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
+
+        s32 i=0;
+        for(; (i+4)<=numSamples; i+=4){
+            float32x4x2_t t = vld2q_f32(src+2*i);
+            vst1q_f32(d+i, vmulq_n_f32(vaddq_f32(t.val[0], t.val[1]), 0.5f));
+        }
+        for(; i<numSamples; ++i){
+            d[i] = 0.5f*(src[2*i+0]+src[2*i+1]);
+        }
+    }
+
+    void conv_Short1ToFloat1_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSshort* src = reinterpret_cast<const LSshort*>(s);
+
+        s32 i=0;
+        for(; (i+8)<=numSamples; i+=8){
+            int16x8_t t = vld1q_s16(src+i);
+            float32x4_t r0 = vcvtq_f32_s32(vmovl_s16(vget_low_s16(t)));
+            float32x4_t r1 = vcvtq_f32_s32(vmovl_s16(vget_high_s16(t)));
+            vst1q_f32(d+i+0, vmulq_n_f32(r0, 1.0f/32767.0f));
+            vst1q_f32(d+i+4, vmulq_n_f32(r1, 1.0f/32767.0f));
+        }
+        for(; i<numSamples; ++i){
+            d[i] = toFloat(src[i]);
+        }
+    }
+
+    void conv_Short2ToFloat2_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        conv_Short1ToFloat1_NEON(dst, s, numSamples<<1);
+    }
+
+    void conv_Short1ToFloat2_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSshort* src = reinterpret_cast<const LSshort*>(s);
+
+        s32 i=0;
+        for(; (i+8)<=numSamples; i+=8){
+            int16x8_t t = vld1q_s16(src+i);
+            float32x4x2_t r0, r1;
+            r0.val[0] = r0.val[1] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(t))), 1.0f/32767.0f);
+            r1.val[0] = r1.val[1] = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(t))), 1.0f/32767.0f);
+            vst2q_f32(d+2*i+0, r0);
+            vst2q_f32(d+2*i+8, r1);
+        }
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = toFloat(src[i]);
+        }
+    }
+
+    void conv_Short2ToFloat1_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        LSfloat* d = reinterpret_cast<LSfloat*>(dst);
+        const LSshort* src = reinterpret_cast<const LSshort*>(s);
+
+        s32 i=0;
+        for(; (i+8)<=numSamples; i+=8){
+            int16x8x2_t t = vld2q_s16(src+2*i);
+            int32x4_t s32_0 = vaddl_s16(vget_low_s16(t.val[0]), vget_low_s16(t.val[1]));
+            int32x4_t s32_1 = vaddl_s16(vget_high_s16(t.val[0]), vget_high_s16(t.val[1]));
+            vst1q_f32(d+i+0, vmulq_n_f32(vcvtq_f32_s32(s32_0), 0.5f/32767.0f));
+            vst1q_f32(d+i+4, vmulq_n_f32(vcvtq_f32_s32(s32_1), 0.5f/32767.0f));
+        }
+        for(; i<numSamples; ++i){
+            d[i] = 0.5f*(toFloat(src[2*i+0]) + toFloat(src[2*i+1]));
+        }
+    }
+
+    void conv_Float1ToShort1_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        LSshort* d = reinterpret_cast<LSshort*>(dst);
+        const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
+
+        s32 i=0;
+        for(; (i+8)<=numSamples; i+=8){
+            int32x4_t s32_0 = roundToInt(vmulq_n_f32(vld1q_f32(src+i+0), 32768.0f));
+            int32x4_t s32_1 = roundToInt(vmulq_n_f32(vld1q_f32(src+i+4), 32768.0f));
+            vst1q_s16(d+i, vcombine_s16(vqmovn_s32(s32_0), vqmovn_s32(s32_1)));
+        }
+        for(; i<numSamples; ++i){
+            d[i] = toShort(src[i]);
+        }
+    }
+
+    void conv_Float2ToShort2_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        conv_Float1ToShort1_NEON(dst, s, numSamples<<1);
+    }
+
+    void conv_Float1ToShort2_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        LSshort* d = reinterpret_cast<LSshort*>(dst);
+        const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
+
+        s32 i=0;
+        for(; (i+8)<=numSamples; i+=8){
+            int32x4_t s32_0 = roundToInt(vmulq_n_f32(vld1q_f32(src+i+0), 32768.0f));
+            int32x4_t s32_1 = roundToInt(vmulq_n_f32(vld1q_f32(src+i+4), 32768.0f));
+            int16x8x2_t t;
+            t.val[0] = t.val[1] = vcombine_s16(vqmovn_s32(s32_0), vqmovn_s32(s32_1));
+            vst2q_s16(d+2*i, t);
+        }
+        for(; i<numSamples; ++i){
+            d[2*i+0] = d[2*i+1] = toShort(src[i]);
+        }
+    }
+
+    void conv_Float2ToShort1_NEON(void* dst, const void* s, s32 numSamples)
+    {
+        LSshort* d = reinterpret_cast<LSshort*>(dst);
+        const LSfloat* src = reinterpret_cast<const LSfloat*>(s);
+
+        s32 i=0;
+        for(; (i+8)<=numSamples; i+=8){
+            float32x4x2_t t0 = vld2q_f32(src+2*i+0);
+            float32x4x2_t t1 = vld2q_f32(src+2*i+8);
+            int32x4_t s32_0 = roundToInt(vmulq_n_f32(vaddq_f32(t0.val[0], t0.val[1]), 32768.0f*0.5f));
+            int32x4_t s32_1 = roundToInt(vmulq_n_f32(vaddq_f32(t1.val[0], t1.val[1]), 32768.0f*0.5f));
+            vst1q_s16(d+i, vcombine_s16(vqmovn_s32(s32_0), vqmovn_s32(s32_1)));
+        }
+        for(; i<numSamples; ++i){
+            f32 v = 0.5f*(src[2*i+0] + src[2*i+1]);
+            d[i] = toShort(v);
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    inline f32 horizontalSum_NEON(float32x4_t v)
+    {
+        float32x2_t t = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+        return vget_lane_f32(vpadd_f32(t, t), 0);
+    }
+
+    void filter_1_NEON(LSfloat* dst, const f32* taps, const f32* const* x, s32 numTaps)
+    {
+        const f32* x0 = x[0];
+
+        s32 i=0;
+        float32x4_t s0 = vdupq_n_f32(0.0f);
+        float32x4_t s1 = vdupq_n_f32(0.0f);
+        for(; (i+8)<=numTaps; i+=8){
+            s0 = vmlaq_f32(s0, vld1q_f32(taps+i+0), vld1q_f32(x0+i+0));
+            s1 = vmlaq_f32(s1, vld1q_f32(taps+i+4), vld1q_f32(x0+i+4));
+        }
+        f32 sum0 = horizontalSum_NEON(vaddq_f32(s0, s1));
+        for(; i<numTaps; ++i){
+            sum0 += taps[i]*x0[i];
+        }
+        dst[0] = sum0;
+    }
+
+    void filter_2_NEON(LSfloat* dst, const f32* taps, const f32* const* x, s32 numTaps)
+    {
+        const f32* x0 = x[0];
+        const f32* x1 = x[1];
+
+        s32 i=0;
+        float32x4_t s00 = vdupq_n_f32(0.0f);
+        float32x4_t s01 = vdupq_n_f32(0.0f);
+        float32x4_t s10 = vdupq_n_f32(0.0f);
+        float32x4_t s11 = vdupq_n_f32(0.0f);
+        for(; (i+8)<=numTaps; i+=8){
+            float32x4_t t0 = vld1q_f32(taps+i+0);
+            float32x4_t t1 = vld1q_f32(taps+i+4);
+            s00 = vmlaq_f32(s00, t0, vld1q_f32(x0+i+0));
+            s01 = vmlaq_f32(s01, t1, vld1q_f32(x0+i+4));
+            s10 = vmlaq_f32(s10, t0, vld1q_f32(x1+i+0));
+            s11 = vmlaq_f32(s11, t1, vld1q_f32(x1+i+4));
+        }
+        f32 sum0 = horizontalSum_NEON(vaddq_f32(s00, s01));
+        f32 sum1 = horizontalSum_NEON(vaddq_f32(s10, s11));
+        for(; i<numTaps; ++i){
+            sum0 += taps[i]*x0[i];
+            sum1 += taps[i]*x1[i];
+        }
+        dst[0] = sum0;
+        dst[1] = sum1;
+    }
+
+    //----------------------------------------------------------------------------
+    inline float32x4_t uniform_NEON(uint32x4_t& seed)
+    {
+        seed = veorq_u32(seed, vshlq_n_u32(seed, 13));
+        seed = veorq_u32(seed, vshrq_n_u32(seed, 17));
+        seed = veorq_u32(seed, vshlq_n_u32(seed, 5));
+        return vreinterpretq_f32_u32(vorrq_u32(vshrq_n_u32(seed, 9), vdupq_n_u32(0x3F800000U)));
+    }
+
+    void dither_Float_NEON(LSshort* dst, const LSfloat* src, s32 numSamples, u16 /*numChannels*/, f32 gain, DitherState& state)
+    {
+        const f32 scale = 32768.0f*gain;
+
+        s32 i=0;
+        uint32x4_t seed = vld1q_u32(state.seeds_);
+        for(; (i+8)<=numSamples; i+=8){
+            float32x4_t r0 = vsubq_f32(uniform_NEON(seed), uniform_NEON(seed));
+            float32x4_t r1 = vsubq_f32(uniform_NEON(seed), uniform_NEON(seed));
+            int32x4_t s32_0 = roundToInt(vmlaq_n_f32(r0, vld1q_f32(src+i+0), scale));
+            int32x4_t s32_1 = roundToInt(vmlaq_n_f32(r1, vld1q_f32(src+i+4), scale));
+            vst1q_s16(dst+i, vcombine_s16(vqmovn_s32(s32_0), vqmovn_s32(s32_1)));
+        }
+        vst1q_u32(state.seeds_, seed);
+        for(; i<numSamples; ++i){
+            dst[i] = quantize(scale*src[i] + triangular(state.seeds_[i&3]));
+        }
+    }
+#endif //LSOUND_DSP_NEON
+
+    //----------------------------------------------------------------------------
+    u16 convBytesSampleToID(u16 bytesPerSample)
+    {
+        switch(bytesPerSample)
+        {
+        case 1:
+            return 0;
+        case 2:
+            return 1;
+        case 4:
+            return 2;
+        default:
+            return -1;
+        }
+    }
+
+    u16 convChannelsToID(u16 numChannels)
+    {
+        switch(numChannels)
+        {
+        case 1:
+            return 0;
+        case 2:
+            return 1;
+        default:
+            return -1;
+        }
+    }
+
+    static const s32 NumConvTypeFuncs = 24;
+
+    static const ConvTypeFunc ConvTypeFuncTableBase[NumConvTypeFuncs] =
+    {
+        //short to byte
+        conv_Short1ToByte1, conv_Short1ToByte2, conv_Short2ToByte1, conv_Short2ToByte2,
+        //short to shot
+        NULL, conv_Short1ToShort2, conv_Short2ToShort1, NULL,
+        //short to float
+        conv_Short1ToFloat1, conv_Short1ToFloat2, conv_Short2ToFloat1, conv_Short2ToFloat2,
+
+        //float to byte
+        conv_Float1ToByte1, conv_Float1ToByte2, conv_Float2ToByte1, conv_Float2ToByte2,
+        //float to short
+        conv_Float1ToShort1, conv_Float1ToShort2, conv_Float2ToShort1, conv_Float2ToShort2,
+        //float to float
+        NULL, conv_Float1ToFloat2, conv_Float2ToFloat1, NULL,
+    };
+
+    //Tables of higher levels replace non NULL entries of lower ones
+#ifdef LSOUND_DSP_X86
+    static const ConvTypeFunc ConvTypeFuncTableSSE41[NumConvTypeFuncs] =
+    {
+        NULL, NULL, NULL, NULL,
+        NULL, NULL, NULL, NULL,
+        conv_Short1ToFloat1_SSE41, conv_Short1ToFloat2_SSE41, NULL, conv_Short2ToFloat2_SSE41,
+
+        NULL, NULL, NULL, NULL,
+        NULL, NULL, NULL, NULL,
+        NULL, NULL, NULL, NULL,
+    };
+
+    static const ConvTypeFunc ConvTypeFuncTableAVX2[NumConvTypeFuncs] =
+    {
+        NULL, NULL, NULL, NULL,
+        NULL, NULL, NULL, NULL,
+        conv_Short1ToFloat1_AVX2, conv_Short1ToFloat2_AVX2, conv_Short2ToFloat1_AVX2, conv_Short2ToFloat2_AVX2,
+
+        NULL, NULL, NULL, NULL,
+        conv_Float1ToShort1_AVX2, conv_Float1ToShort2_AVX2, conv_Float2ToShort1_AVX2, conv_Float2ToShort2_AVX2,
+        NULL, conv_Float1ToFloat2_AVX2, conv_Float2ToFloat1_AVX2, NULL,
+    };
+
+    void cpuid(s32 info[4], s32 function)
+    {
+#if defined(_MSC_VER)
+        __cpuidex(info, function, 0);
+#else
+        u32 a=0, b=0, c=0, d=0;
+        __cpuid_count(function, 0, a, b, c, d);
+        info[0] = a; info[1] = b; info[2] = c; info[3] = d;
+#endif
+    }
+
+    /// Whether the os saves ymm registers
+    bool checkOSAVX()
+    {
+#if defined(_MSC_VER)
+        return 0x06U == (_xgetbv(0) & 0x06U);
+#else
+        u32 a, d;
+        __asm__ __volatile__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+        return 0x06U == (a & 0x06U);
+#endif
+    }
+#endif //LSOUND_DSP_X86
+
+#ifdef LSOUND_DSP_NEON
+    static const ConvTypeFunc ConvTypeFuncTableNEON[NumConvTypeFuncs] =
+    {
+        NULL, NULL, NULL, NULL,
+        NULL, conv_Short1ToShort2_NEON, conv_Short2ToShort1_NEON, NULL,
+        conv_Short1ToFloat1_NEON, conv_Short1ToFloat2_NEON, conv_Short2ToFloat1_NEON, conv_Short2ToFloat2_NEON,
+
+        NULL, NULL, NULL, NULL,
+        conv_Float1ToShort1_NEON, conv_Float1ToShort2_NEON, conv_Float2ToShort1_NEON, conv_Float2ToShort2_NEON,
+        NULL, conv_Float1ToFloat2_NEON, conv_Float2ToFloat1_NEON, NULL,
+    };
+#endif
+
+    static const FilterFunc FilterFuncTableBase[2] =
+    {
+        filter_1, filter_2,
+    };
+
+#ifdef LSOUND_DSP_X86
+    static const FilterFunc FilterFuncTableAVX2[2] =
+    {
+        filter_1_AVX2, filter_2_AVX2,
+    };
+#endif
+
+#ifdef LSOUND_DSP_NEON
+    static const FilterFunc FilterFuncTableNEON[2] =
+    {
+        filter_1_NEON, filter_2_NEON,
+    };
+#endif
+    SIMDLevel detectSIMDLevel()
+    {
+#if defined(LSOUND_DSP_X86)
+        s32 info[4];
+        cpuid(info, 0);
+        s32 maxFunction = info[0];
+
+        cpuid(info, 1);
+        if(0 == (info[2] & (0x01<<19))){
+            return SIMDLevel_SSE2;
+        }
+        //AVX and OSXSAVE
+        if(maxFunction<7 || (0x03<<27) != (info[2] & (0x03<<27)) || !checkOSAVX()){
+            return SIMDLevel_SSE41;
+        }
+        cpuid(info, 7);
+        return (0 != (info[1] & (0x01<<5)))? SIMDLevel_AVX2 : SIMDLevel_SSE41;
+
+#elif defined(LSOUND_DSP_NEON)
+        //Built for NEON, armv7 without it does not define __ARM_NEON__
+        return SIMDLevel_NEON;
+#else
+        return SIMDLevel_None;
+#endif
+    }
+
+    /**
+    @brief Functions selected for the level of the cpu, before any player is made
+    */
+    class ConvTypeFuncSelector
+    {
+    public:
+        ConvTypeFuncSelector()
+            :cpuLevel_(detectSIMDLevel())
+        {
+            select(cpuLevel_);
+        }
+
+        SIMDLevel select(SIMDLevel level)
+        {
+            level_ = (cpuLevel_<level)? cpuLevel_ : level;
+#if defined(LSOUND_DSP_X86)
+            //The base functions are SSE2
+            level_ = (level_<SIMDLevel_SSE2)? SIMDLevel_SSE2 : level_;
+#endif
+            for(s32 i=0; i<NumConvTypeFuncs; ++i){
+                table_[i] = ConvTypeFuncTableBase[i];
+            }
+            filterTable_[0] = FilterFuncTableBase[0];
+            filterTable_[1] = FilterFuncTableBase[1];
+            ditherFunc_ = dither_Float;
+#if defined(LSOUND_DSP_X86)
+            if(SIMDLevel_SSE41<=level_){
+                overwrite(ConvTypeFuncTableSSE41);
+            }
+            if(SIMDLevel_AVX2<=level_){
+                overwrite(ConvTypeFuncTableAVX2);
+                filterTable_[0] = FilterFuncTableAVX2[0];
+                filterTable_[1] = FilterFuncTableAVX2[1];
+            }
+#elif defined(LSOUND_DSP_NEON)
+            if(SIMDLevel_NEON<=level_){
+                overwrite(ConvTypeFuncTableNEON);
+                filterTable_[0] = FilterFuncTableNEON[0];
+                filterTable_[1] = FilterFuncTableNEON[1];
+                ditherFunc_ = dither_Float_NEON;
+            }
+#endif
+            return level_;
+        }
+
+        void overwrite(const ConvTypeFunc* table)
+        {
+            for(s32 i=0; i<NumConvTypeFuncs; ++i){
+                if(NULL != table[i]){
+                    table_[i] = table[i];
+                }
+            }
+        }
+
+        SIMDLevel cpuLevel_;
+        SIMDLevel level_;
+        ConvTypeFunc table_[NumConvTypeFuncs];
+        FilterFunc filterTable_[2];
+        DitherFunc ditherFunc_;
+    };
+
+    ConvTypeFuncSelector convTypeFuncSelector_;
+}
+
+    SIMDLevel getSIMDLevel()
+    {
+        return convTypeFuncSelector_.level_;
+    }
+
+    SIMDLevel setSIMDLevel(SIMDLevel level)
+    {
+        return convTypeFuncSelector_.select(level);
+    }
+
+    ConvTypeFunc getConvTypeFunc(u16 dstNumChannels, u16 dstBytesPerSample, u16 srcNumChannels, u16 srcBytesPerSample)
+    {
+        LASSERT(8 != srcBytesPerSample);
+        dstNumChannels = convChannelsToID(dstNumChannels);
+        dstBytesPerSample = convBytesSampleToID(dstBytesPerSample);
+        srcNumChannels = convChannelsToID(srcNumChannels);
+        srcBytesPerSample = convBytesSampleToID(srcBytesPerSample);
+
+        s32 channel = srcNumChannels*2 + dstNumChannels;
+
+        switch(srcBytesPerSample)
+        {
+        case 1:
+            {
+                s32 type = dstBytesPerSample*4;
+                return convTypeFuncSelector_.table_[type+channel];
+            }
+            break;
+        case 2:
+            {
+                s32 type = dstBytesPerSample*4 + 12;
+                return convTypeFuncSelector_.table_[type+channel];
+            }
+            break;
+        }
+        return NULL;
+    }
+
+    FilterFunc getFilterFunc(u16 numChannels)
+    {
+        LASSERT(1 == numChannels || 2 == numChannels);
+        return convTypeFuncSelector_.filterTable_[convChannelsToID(numChannels)];
+    }
+
+    DitherFunc getDitherFunc(bool noiseShaping)
+    {
+        return (noiseShaping)? dither_FloatShaped : convTypeFuncSelector_.ditherFunc_;
+    }
+}
@@ -24,9 +24,11 @@ namespace lsound
         return static_cast<LSshort>((32768.0f/128.0f)*v);
     }
 
+    /// Rounded and saturated like the packs of simd kernels
     static inline LSshort toShort(LSfloat v)
     {
-        return static_cast<LSshort>(32768.0f*v);
+        f32 x = lcore::clamp(32768.0f*v, -32768.0f, 32767.0f);
+        return static_cast<LSshort>((x<0.0f)? x-0.5f : x+0.5f);
     }
 
     static inline LSbyte toByte(LSshort v)
@@ -36,9 +38,29 @@ namespace lsound
 
     static inline LSbyte toByte(LSfloat v)
     {
-        return static_cast<LSshort>(128.0f*v);
+        return static_cast<LSbyte>(lcore::clamp(128.0f*v, -128.0f, 127.0f));
     }
 
+    enum SIMDLevel
+    {
+        SIMDLevel_None =0,
+        SIMDLevel_SSE2,
+        SIMDLevel_SSE41,
+        SIMDLevel_AVX2,
+        SIMDLevel_NEON,
+    };
+
+    /**
+    @brief Instruction set the conversions run with, detected once at startup
+    */
+    SIMDLevel getSIMDLevel();
+
+    /**
+    @brief Select conversions for a lower level, to compare them. Call before getting functions
+    @return the level selected, not above the cpu's
+    */
+    SIMDLevel setSIMDLevel(SIMDLevel level);
+
     typedef void(*ConvTypeFunc)(void* dst, const void* s, s32 numSamples);
 
     void conv_Short1ToShort2(void* dst, const void* src, s32 numSamples);
@@ -70,5 +92,39 @@ namespace lsound
     void conv_Float2ToShort1(void* dst, const void* src, s32 numSamples);
 
     ConvTypeFunc getConvTypeFunc(u16 dstNumChannels, u16 dstBytesPerSample, u16 srcNumChannels, u16 srcBytesPerSample);
+
+    /**
+    @brief One output frame of a fir filter, the inner product of taps and the history of each channel
+    @param x ... planar histories, numTaps samples of each from the same position
+    @param taps ... aligned to 32 bytes
+    */
+    typedef void(*FilterFunc)(LSfloat* dst, const f32* taps, const f32* const* x, s32 numTaps);
+
+    void filter_1(LSfloat* dst, const f32* taps, const f32* const* x, s32 numTaps);
+    void filter_2(LSfloat* dst, const f32* taps, const f32* const* x, s32 numTaps);
+
+    FilterFunc getFilterFunc(u16 numChannels);
+
+    /**
+    @brief State of the final quantization to 16bit, carried over blocks
+    */
+    struct DitherState
+    {
+        u32 seeds_[4]; ///< xorshift of each lane
+        f32 errors_[2][2]; ///< last two errors of each channel, for noise shaping
+    };
+
+    void initializeDither(DitherState& state, u32 seed);
+
+    /**
+    @brief Scale, add triangular dither of 1 lsb, round and saturate to 16bit
+    @param numChannels ... of interleaved src, errors are shaped for each channel
+    */
+    typedef void(*DitherFunc)(LSshort* dst, const LSfloat* src, s32 numSamples, u16 numChannels, f32 gain, DitherState& state);
+
+    void dither_Float(LSshort* dst, const LSfloat* src, s32 numSamples, u16 numChannels, f32 gain, DitherState& state);
+    void dither_FloatShaped(LSshort* dst, const LSfloat* src, s32 numSamples, u16 numChannels, f32 gain, DitherState& state);
+
+    DitherFunc getDitherFunc(bool noiseShaping);
 }
 #endif //INC_LSOUND_DSP_H__
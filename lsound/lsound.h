@@ -67,6 +67,46 @@ namespace lsound
         PlayerFlag_Loop = (0x01U<<0),
     };
 
+    /**
+    @brief What happens when an entry already plays its maximum instances
+    */
+    enum Polyphony
+    {
+        Polyphony_Reject = 0, ///< the new voice does not start
+        Polyphony_StealOldest, ///< the one played longest stops
+        Polyphony_StealQuietest, ///< the one at the lowest gain stops
+    };
+
+    /**
+    @brief Handle of a voice, index in the lower 16 bits and generation in the upper 16 bits.
+    Generations start from 1, then 0 is never a valid handle.
+    */
+    typedef u32 Handle;
+    static const Handle InvalidHandle = 0;
+    static const s32 MaxHandleIndex = 0xFFFF;
+
+    inline Handle makeHandle(s32 index, u16 generation)
+    {
+        return (static_cast<u32>(generation)<<16) | static_cast<u32>(index);
+    }
+
+    inline s32 getHandleIndex(Handle handle)
+    {
+        return static_cast<s32>(handle & 0xFFFFU);
+    }
+
+    inline u16 getHandleGeneration(Handle handle)
+    {
+        return static_cast<u16>(handle>>16);
+    }
+
+    /// Next generation, skipping 0
+    inline u16 nextGeneration(u16 generation)
+    {
+        ++generation;
+        return (0 == generation)? 1 : generation;
+    }
+
 #if defined(LSOUND_API_WASAPI)
 
 #define LSOUND_TASKMEMFREE(ptr) if(NULL != (ptr)){CoTaskMemFree((ptr)); (ptr)=NULL;}
@@ -194,6 +234,48 @@ namespace lsound
 
     //typedef f32 SampleType;
     typedef s16 SampleType;
+
+#elif defined(LSOUND_API_OFFLINE)
+
+#define LSOUND_DITHER_ENABLE 1
+
+    typedef s32 LSsizei;
+    typedef s8 LSbyte;
+    typedef s16 LSshort;
+    typedef s32 LSint;
+    typedef u32 LSuint;
+    typedef f32 LSfloat;
+    typedef s32 LSenum;
+    typedef void LSvoid;
+
+    enum PCMFormat
+    {
+        PCMFormat_Short =0,
+    };
+
+    enum Format
+    {
+        Format_Mono8 = 0,
+        Format_Mono16 = 1,
+        Format_Stereo8 = 2,
+        Format_Stereo16 = 3,
+    };
+
+    enum Channels
+    {
+        Channels_Mono = 1,
+        Channels_Stereo = 2,
+    };
+
+    enum State
+    {
+        State_Initial = 0,
+        State_Playing = 1,
+        State_Paused  = 2,
+        State_Stopped = 3,
+    };
+
+    static const s32 SharedBufferLength = BufferNumSamplesPerChannel*Channels_Stereo;
 #endif
 
 }
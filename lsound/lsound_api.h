@@ -5,7 +5,10 @@
 @author t-sakai
 @date 2015/07/06 create
 */
-#if defined(_WIN32) || defined(_WIN64)
+#if defined(LSOUND_API_OFFLINE)
+//Headless render backend, can be forced on any platform
+
+#elif defined(_WIN32) || defined(_WIN64)
 #define LSOUND_API_WASAPI
 //#define LSOUND_API_OPENAL
 
@@ -14,5 +17,8 @@
 
 #elif defined(ANDROID)
 #define LSOUND_API_OPENSL
+
+#elif defined(__linux__)
+#define LSOUND_API_OFFLINE
 #endif
 #endif //INC_LSOUND_LSOUND_API_H__
@@ -14,6 +14,7 @@ namespace lsound
     //------------------------------------------
     Pack::Pack()
         :entries_(NULL)
+        ,infos_(NULL)
         ,dataTopOffset_(0)
         ,data_(NULL)
     {
@@ -49,10 +50,17 @@ namespace lsound
         return dataTopOffset_ + entries_[index].offset_;
     }
 
+    const FileInfo* Pack::getInfo(u32 index) const
+    {
+        LASSERT(0<=index && index<header_.numFiles_);
+        return (NULL == infos_)? NULL : &infos_[index];
+    }
+
     void Pack::swap(Pack& rhs)
     {
         lcore::swap(header_, rhs.header_);
         lcore::swap(entries_, rhs.entries_);
+        lcore::swap(infos_, rhs.infos_);
         lcore::swap(dataTopOffset_, rhs.dataTopOffset_);
         lcore::swap(data_, rhs.data_);
     }
@@ -60,6 +68,7 @@ namespace lsound
     void Pack::releaseEntries()
     {
         LIME_DELETE_ARRAY(entries_);
+        LIME_DELETE_ARRAY(infos_);
     }
 
     void Pack::releaseData()
@@ -9,9 +9,15 @@
 
 namespace lsound
 {
+    /// Version 2 and later have a FileInfo array after the FileEntry array
+    static const u8 PackVersion_FileInfo = 2;
+    /// Version 3 and later have a SeekRange array and SeekPoint array after the FileInfo array
+    static const u8 PackVersion_SeekTable = 3;
+    static const u8 PackVersion = PackVersion_SeekTable;
+
     struct PackHeader
     {
-        u8 reserved0_;
+        u8 version_; //0 for packs which have only FileEntry
         u8 reserved1_;
         u16 numFiles_;
     };
@@ -22,6 +28,35 @@ namespace lsound
         s32 offset_;
     };
 
+    /**
+    @brief Opus stream information of an entry, so that streams can open without probing
+    */
+    struct FileInfo
+    {
+        u16 channels_;
+        u16 preSkip_;
+        u32 headerSize_; //bytes of OpusHead and OpusTags pages from the top of the entry
+        s64 totalPcm_; //number of samples at 48kHz excluding pre-skip, 0 if unknown
+    };
+
+    /**
+    @brief A page where decoding can restart
+    */
+    struct SeekPoint
+    {
+        u32 pcm_; //position of the first sample output when decoding restarts from the page
+        u32 offset_; //byte offset of the page from the top of the entry
+    };
+
+    /**
+    @brief Seek points of an entry in the SeekPoint array
+    */
+    struct SeekRange
+    {
+        u32 top_;
+        u32 numPoints_;
+    };
+
     class Pack
     {
     public:
@@ -36,6 +71,9 @@ namespace lsound
 
         s32 getFileOffset(u32 index) const;
 
+        /// NULL if the pack has no FileInfo
+        const FileInfo* getInfo(u32 index) const;
+
         void swap(Pack& rhs);
     private:
         friend class PackReader;
@@ -44,6 +82,7 @@ namespace lsound
 
         PackHeader header_;
         FileEntry* entries_;
+        FileInfo* infos_;
         s32 dataTopOffset_;
         u8* data_;
     };
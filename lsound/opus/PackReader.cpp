@@ -45,6 +45,29 @@ namespace lsound
                 return false;
             }
 
+            if(PackVersion_FileInfo<=pack_.header_.version_){
+                pack_.infos_ = LIME_NEW FileInfo[pack_.header_.numFiles_];
+                u32 infoSize = pack_.header_.numFiles_ * sizeof(FileInfo);
+                size = lcore::io::read(stream_, pack_.infos_, infoSize);
+                if(size<1){
+                    return false;
+                }
+            }
+
+            //Pack does not use seek tables, skip them
+            if(PackVersion_SeekTable<=pack_.header_.version_){
+                u32 numPoints = 0;
+                for(u32 i=0; i<pack_.header_.numFiles_; ++i){
+                    SeekRange range;
+                    size = lcore::io::read(stream_, range);
+                    if(size<1){
+                        return false;
+                    }
+                    numPoints += range.numPoints_;
+                }
+                stream_.seekg(numPoints*sizeof(SeekPoint), lcore::ios::cur);
+            }
+
             //f[^TCYvZ
             s32 dataTop = stream_.tellg();
             stream_.seekg(0, lcore::ios::end);
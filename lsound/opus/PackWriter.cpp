@@ -6,14 +6,115 @@
 */
 
 #include "PackWriter.h"
-#include <lcore/clibrary.h>
+#include <lcore/CLibrary.h>
 
 namespace lsound
 {
+namespace
+{
+    static const u32 OggPageHeaderSize = 27;
+    static const u8 OggPageContinued = 0x01;
+
+    /// Samples between seek points at 48kHz
+    static const u32 SeekInterval = 48000;
+
+    inline u16 getU16(const u8* p)
+    {
+        return static_cast<u16>(p[0] | (p[1]<<8));
+    }
+
+    inline s64 getS64(const u8* p)
+    {
+        u64 v = 0;
+        for(s32 i=7; 0<=i; --i){
+            v = (v<<8) | p[i];
+        }
+        return static_cast<s64>(v);
+    }
+
+    /**
+    @brief Walk ogg pages of an opus file
+    @return false if the file is not a single logical opus stream, then info is left unknown
+    @param points ... seek points are added, pages which do not begin with a continued packet
+    */
+    bool getFileInfo(FileInfo& info, lcore::vector_arena<SeekPoint>& points, u32 size, const u8* buffer)
+    {
+        info.channels_ = 0;
+        info.preSkip_ = 0;
+        info.headerSize_ = 0;
+        info.totalPcm_ = 0;
+
+        u32 serial = 0;
+        s64 lastGranule = -1;
+        s64 nextSeek = 0;
+        u32 offset = 0;
+        while(offset+OggPageHeaderSize <= size){
+            const u8* page = buffer + offset;
+            if(0 != lcore::memcmp(page, "OggS", 4)){
+                return false;
+            }
+            u32 numSegments = page[26];
+            u32 pageSize = OggPageHeaderSize + numSegments;
+            if(size < offset+pageSize){
+                return false;
+            }
+            for(u32 i=0; i<numSegments; ++i){
+                pageSize += page[OggPageHeaderSize+i];
+            }
+            if(size < offset+pageSize){
+                return false;
+            }
+
+            s64 granule = getS64(page+6);
+            u32 pageSerial = page[14] | (page[15]<<8) | (page[16]<<16) | (page[17]<<24);
+            if(0 == offset){
+                //OpusHead
+                const u8* head = page + OggPageHeaderSize + numSegments;
+                if(pageSize<OggPageHeaderSize+numSegments+19 || 0 != lcore::memcmp(head, "OpusHead", 8)){
+                    return false;
+                }
+                info.channels_ = head[9];
+                info.preSkip_ = getU16(head+10);
+                serial = pageSerial;
+            }else if(serial != pageSerial){
+                return false;
+            }
+
+            //Header pages have granule position 0, audio data begins on a fresh page
+            if(0 == info.headerSize_ && 0 != granule){
+                info.headerSize_ = offset;
+            }
+
+            //Decoding from a page restarts at the end of the previous page
+            if(0 != info.headerSize_
+                && 0 == (page[5] & OggPageContinued)
+                && nextSeek<=lastGranule
+                && lastGranule<=0xFFFFFFFFU)
+            {
+                SeekPoint point;
+                point.pcm_ = static_cast<u32>(lastGranule);
+                point.offset_ = offset;
+                points.push_back(point);
+                nextSeek = lastGranule + SeekInterval;
+            }
+            if(0<=granule){
+                lastGranule = granule;
+            }
+            offset += pageSize;
+        }
+        if(0 == info.headerSize_ || lastGranule<=info.preSkip_){
+            info.headerSize_ = 0;
+            return false;
+        }
+        info.totalPcm_ = lastGranule - info.preSkip_;
+        return true;
+    }
+}
+
     //-------------------------------------------------
     PackWriter::PackWriter()
     {
-        header_.reserved0_ = 0;
+        header_.version_ = PackVersion;
         header_.reserved1_ = 0;
         header_.numFiles_ = 0;
     }
@@ -40,7 +141,17 @@ namespace lsound
         entry.size_ = size;
 
         entries_.push_back(entry);
-        
+
+        FileInfo info;
+        SeekRange range;
+        range.top_ = points_.size();
+        if(!getFileInfo(info, points_, size, reinterpret_cast<const u8*>(buffer))){
+            points_.resize(range.top_);
+        }
+        range.numPoints_ = points_.size() - range.top_;
+        infos_.push_back(info);
+        ranges_.push_back(range);
+
         u8* tmp = LIME_NEW u8[size];
         lcore::memcpy(tmp, buffer, size);
 
@@ -82,6 +193,36 @@ namespace lsound
             }
         }
 
+        for(FileInfoArray::iterator itr = infos_.begin();
+            itr != infos_.end();
+            ++itr)
+        {
+            ret = lcore::io::write(stream_, (*itr));
+            if(0 == ret){
+                return false;
+            }
+        }
+
+        for(SeekRangeArray::iterator itr = ranges_.begin();
+            itr != ranges_.end();
+            ++itr)
+        {
+            ret = lcore::io::write(stream_, (*itr));
+            if(0 == ret){
+                return false;
+            }
+        }
+
+        for(SeekPointArray::iterator itr = points_.begin();
+            itr != points_.end();
+            ++itr)
+        {
+            ret = lcore::io::write(stream_, (*itr));
+            if(0 == ret){
+                return false;
+            }
+        }
+
         FileEntryArray::iterator entryItr = entries_.begin();
         for(MemPtrArray::iterator itr = mempts_.begin();
             itr != mempts_.end();
@@ -7,7 +7,7 @@
 
 */
 #include <lcore/liostream.h>
-#include <lcore/vector.h>
+#include <lcore/Vector.h>
 #include "Pack.h"
 
 namespace lsound
@@ -27,6 +27,9 @@ namespace lsound
 
     private:
         typedef lcore::vector_arena<FileEntry> FileEntryArray;
+        typedef lcore::vector_arena<FileInfo> FileInfoArray;
+        typedef lcore::vector_arena<SeekRange> SeekRangeArray;
+        typedef lcore::vector_arena<SeekPoint> SeekPointArray;
         typedef lcore::vector_arena<void*> MemPtrArray;
 
         /// t@CI[v
@@ -39,6 +42,9 @@ namespace lsound
         lcore::ofstream listStream_;
         PackHeader header_;
         FileEntryArray entries_;
+        FileInfoArray infos_;
+        SeekRangeArray ranges_;
+        SeekPointArray points_;
         MemPtrArray mempts_;
     };
 
@@ -4,6 +4,19 @@
 @date 2014/07/15 create
 */
 #include "Resource.h"
+#include <math.h>
+#include <lcore/CLibrary.h>
+#include "Stream.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#endif
 
 namespace lsound
 {
@@ -15,17 +28,43 @@ namespace lsound
     File::File()
         :refCount_(0)
         ,file_(NULL)
+        ,blockSize_(0)
+        ,numBlocks_(0)
+        ,blocks_(NULL)
+        ,blockBuffer_(NULL)
     {
+        blockTop_.prev_ = blockTop_.next_ = &blockTop_;
+#ifdef LSOUND_RESOURCE_ENABLE_PREAD
+#if defined(_WIN32) || defined(_WIN64)
+        handle_ = INVALID_HANDLE_VALUE;
+#else
+        descriptor_ = -1;
+#endif
+#endif
     }
 
     File::File(FILE* file)
         :refCount_(0)
         ,file_(file)
+        ,blockSize_(0)
+        ,numBlocks_(0)
+        ,blocks_(NULL)
+        ,blockBuffer_(NULL)
     {
+        LASSERT(NULL != file_);
+        blockTop_.prev_ = blockTop_.next_ = &blockTop_;
+#ifdef LSOUND_RESOURCE_ENABLE_PREAD
+#if defined(_WIN32) || defined(_WIN64)
+        handle_ = reinterpret_cast<void*>(_get_osfhandle(_fileno(file_)));
+#else
+        descriptor_ = fileno(file_);
+#endif
+#endif
     }
 
     File::~File()
     {
+        destroyCache();
         if(NULL != file_){
             fclose(file_);
             file_ = NULL;
@@ -34,16 +73,162 @@ namespace lsound
 
     void File::addRef()
     {
-        ++refCount_;
+        lcore::atomicIncrement(&refCount_);
     }
 
     void File::release()
     {
-        if(--refCount_ == 0){
+        if(lcore::atomicDecrement(&refCount_) == 0){
             LIME_DELETE_NONULL(this);
         }
     }
 
+    s32 File::read(void* dst, s64 offset, s32 size)
+    {
+        LASSERT(NULL != dst);
+        LASSERT(0<=offset);
+        LASSERT(0<=size);
+#ifdef LSOUND_RESOURCE_ENABLE_PREAD
+#if defined(_WIN32) || defined(_WIN64)
+        //The offset of OVERLAPPED is used for synchronous handles too
+        OVERLAPPED overlapped;
+        lcore::memset(&overlapped, 0, sizeof(OVERLAPPED));
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFU);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset>>32);
+        DWORD bytes = 0;
+        if(!ReadFile(handle_, dst, size, &bytes, &overlapped)){
+            return (ERROR_HANDLE_EOF == GetLastError())? 0 : -1;
+        }
+        return static_cast<s32>(bytes);
+#else
+        ssize_t bytes;
+        do{
+            bytes = pread(descriptor_, dst, size, offset);
+        }while(bytes<0 && EINTR == errno);
+        return static_cast<s32>(bytes);
+#endif
+
+#else //LSOUND_RESOURCE_ENABLE_PREAD
+#ifdef LSOUND_RESOURCE_ENABLE_SYNC
+        lcore::CSLock lock(cs_);
+#endif
+        fseek(file_, static_cast<long>(offset), SEEK_SET);
+        return static_cast<s32>(fread(dst, 1, size, file_));
+#endif
+    }
+
+    bool File::createCache(u32 blockSize, s32 numBlocks)
+    {
+        LASSERT(0<blockSize);
+        destroyCache();
+        if(numBlocks<=0){
+            return true;
+        }
+        blockBuffer_ = reinterpret_cast<u8*>(LIME_MALLOC(blockSize*numBlocks));
+        if(NULL == blockBuffer_){
+            return false;
+        }
+        blocks_ = LIME_NEW FileBlock[numBlocks];
+        blockSize_ = blockSize;
+        numBlocks_ = numBlocks;
+
+        for(s32 i=0; i<numBlocks_; ++i){
+            FileBlock& block = blocks_[i];
+            block.offset_ = -1;
+            block.size_ = 0;
+            block.refCount_ = 0;
+            block.data_ = blockBuffer_ + blockSize_*i;
+
+            block.prev_ = blockTop_.prev_;
+            block.next_ = &blockTop_;
+            blockTop_.prev_->next_ = &block;
+            blockTop_.prev_ = &block;
+        }
+        return true;
+    }
+
+    void File::destroyCache()
+    {
+        LIME_DELETE_ARRAY(blocks_);
+        LIME_FREE(blockBuffer_);
+        blockTop_.prev_ = blockTop_.next_ = &blockTop_;
+        blockSize_ = 0;
+        numBlocks_ = 0;
+    }
+
+    const FileBlock* File::acquireBlock(s64 offset)
+    {
+        if(NULL == blocks_){
+            return NULL;
+        }
+        s64 blockOffset = offset - offset%blockSize_;
+        FileBlock* block;
+        {
+#ifdef LSOUND_RESOURCE_ENABLE_SYNC
+            lcore::CSLock lock(cs_);
+#endif
+            //Search from the most recently used
+            for(block = blockTop_.next_; block != &blockTop_; block = block->next_){
+                if(blockOffset == block->offset_){
+                    break;
+                }
+            }
+            if(block != &blockTop_ && block->size_<0){
+                //Another stream is loading it, read directly rather than loading the same offset into a second block
+                return NULL;
+            }
+            if(block == &blockTop_){
+                //Reuse the least recently used block which no stream holds
+                for(block = blockTop_.prev_; block != &blockTop_; block = block->prev_){
+                    if(block->refCount_<=0){
+                        break;
+                    }
+                }
+                if(block == &blockTop_){
+                    return NULL;
+                }
+                block->offset_ = blockOffset;
+                block->size_ = -1;
+            }
+            ++block->refCount_;
+
+            block->prev_->next_ = block->next_;
+            block->next_->prev_ = block->prev_;
+            block->prev_ = &blockTop_;
+            block->next_ = blockTop_.next_;
+            blockTop_.next_->prev_ = block;
+            blockTop_.next_ = block;
+            if(0<=block->size_){
+                return block;
+            }
+        }
+
+        //Load without the lock, nobody else uses a loading block
+        s32 size = read(block->data_, blockOffset, blockSize_);
+        {
+#ifdef LSOUND_RESOURCE_ENABLE_SYNC
+            lcore::CSLock lock(cs_);
+#endif
+            if(size<0){
+                block->offset_ = -1;
+                block->size_ = 0;
+                --block->refCount_;
+                return NULL;
+            }
+            block->size_ = size;
+        }
+        return block;
+    }
+
+    void File::releaseBlock(const FileBlock* block)
+    {
+        LASSERT(NULL != block);
+#ifdef LSOUND_RESOURCE_ENABLE_SYNC
+        lcore::CSLock lock(cs_);
+#endif
+        --const_cast<FileBlock*>(block)->refCount_;
+    }
+
     //-------------------------------------------
     //---
     //--- Memory
@@ -53,6 +238,8 @@ namespace lsound
         :refCount_(0)
         ,size_(0)
         ,memory_(NULL)
+        ,mapping_(NULL)
+        ,mappingSize_(0)
     {
     }
 
@@ -60,26 +247,267 @@ namespace lsound
         :refCount_(0)
         ,size_(size)
         ,memory_(memory)
+        ,mapping_(NULL)
+        ,mappingSize_(0)
+    {
+    }
+
+    Memory::Memory(u32 size, u8* memory, void* mapping, u64 mappingSize)
+        :refCount_(0)
+        ,size_(size)
+        ,memory_(memory)
+        ,mapping_(mapping)
+        ,mappingSize_(mappingSize)
     {
     }
 
     Memory::~Memory()
     {
-        LIME_DELETE_ARRAY(memory_);
+        if(NULL == mapping_){
+            LIME_DELETE_ARRAY(memory_);
+            return;
+        }
+#if defined(_WIN32) || defined(_WIN64)
+        UnmapViewOfFile(mapping_);
+#else
+        munmap(mapping_, static_cast<size_t>(mappingSize_));
+#endif
+        memory_ = NULL;
+        mapping_ = NULL;
     }
 
     void Memory::addRef()
     {
-        ++refCount_;
+        lcore::atomicIncrement(&refCount_);
     }
 
     void Memory::release()
     {
-        if(--refCount_ == 0){
+        if(lcore::atomicDecrement(&refCount_) == 0){
             LIME_DELETE_NONULL(this);
         }
     }
 
+    //-------------------------------------------
+    //---
+    //--- SeekTable
+    //---
+    //-------------------------------------------
+    SeekTable::SeekTable(s32 numEntries, SeekRange* ranges, SeekPoint* points)
+        :refCount_(0)
+        ,numEntries_(numEntries)
+        ,ranges_(ranges)
+        ,points_(points)
+    {
+    }
+
+    SeekTable::~SeekTable()
+    {
+        LIME_DELETE_ARRAY(points_);
+        LIME_DELETE_ARRAY(ranges_);
+    }
+
+    void SeekTable::addRef()
+    {
+        lcore::atomicIncrement(&refCount_);
+    }
+
+    void SeekTable::release()
+    {
+        if(lcore::atomicDecrement(&refCount_) == 0){
+            LIME_DELETE_NONULL(this);
+        }
+    }
+
+    const SeekPoint* SeekTable::find(s32 index, s64 position) const
+    {
+        LASSERT(0<=index && index<numEntries_);
+        const SeekPoint* points = points_ + ranges_[index].top_;
+        u32 numPoints = ranges_[index].numPoints_;
+        if(numPoints<=0 || position<points[0].pcm_){
+            return NULL;
+        }
+
+        //Binary search for the last point at or before position
+        u32 first = 0;
+        u32 last = numPoints;
+        while(1<(last-first)){
+            u32 mid = (first+last)>>1;
+            if(position<points[mid].pcm_){
+                last = mid;
+            }else{
+                first = mid;
+            }
+        }
+        return &points[first];
+    }
+
+    //-------------------------------------------
+    //---
+    //--- PcmBlock
+    //---
+    //-------------------------------------------
+    PcmBlock::PcmBlock()
+        :refCount_(0)
+        ,numFrames_(0)
+        ,numChannels_(0)
+        ,format_(Format_Short)
+        ,data_(NULL)
+    {
+    }
+
+    PcmBlock::~PcmBlock()
+    {
+        LIME_FREE(data_);
+    }
+
+    void PcmBlock::addRef()
+    {
+        lcore::atomicIncrement(&refCount_);
+    }
+
+    void PcmBlock::release()
+    {
+        if(lcore::atomicDecrement(&refCount_) == 0){
+            LIME_DELETE_NONULL(this);
+        }
+    }
+
+    u32 PcmBlock::read(LSshort* dst, u32 position, u32 numFrames) const
+    {
+        LASSERT(NULL != dst);
+        if(numFrames_<=position){
+            return 0;
+        }
+        numFrames = lcore::minimum(numFrames, numFrames_-position);
+
+        if(Format_Short == format_){
+            const LSshort* src = reinterpret_cast<const LSshort*>(data_) + position*numChannels_;
+            if(Channels_Stereo == numChannels_){
+                lcore::memcpy(dst, src, sizeof(LSshort)*numFrames*Channels_Stereo);
+            }else{
+                for(u32 i=0; i<numFrames; ++i){
+                    dst[2*i+0] = dst[2*i+1] = src[i];
+                }
+            }
+        }else{
+            const u16* src = reinterpret_cast<const u16*>(data_) + position*numChannels_;
+            if(Channels_Stereo == numChannels_){
+                for(u32 i=0; i<numFrames*Channels_Stereo; ++i){
+                    dst[i] = static_cast<LSshort>(32767.0f*lcore::fromBinary16Float(src[i]));
+                }
+            }else{
+                for(u32 i=0; i<numFrames; ++i){
+                    dst[2*i+0] = dst[2*i+1] = static_cast<LSshort>(32767.0f*lcore::fromBinary16Float(src[i]));
+                }
+            }
+        }
+        return numFrames;
+    }
+
+    u32 PcmBlock::read(LSfloat* dst, u32 position, u32 numFrames) const
+    {
+        LASSERT(NULL != dst);
+        if(numFrames_<=position){
+            return 0;
+        }
+        numFrames = lcore::minimum(numFrames, numFrames_-position);
+
+        u32 numSamples = numFrames*numChannels_;
+        if(Format_Short == format_){
+            const LSshort* src = reinterpret_cast<const LSshort*>(data_) + position*numChannels_;
+            for(u32 i=0; i<numSamples; ++i){
+                dst[i] = (1.0f/32768.0f)*src[i];
+            }
+        }else{
+            const u16* src = reinterpret_cast<const u16*>(data_) + position*numChannels_;
+            for(u32 i=0; i<numSamples; ++i){
+                dst[i] = lcore::fromBinary16Float(src[i]);
+            }
+        }
+        //Spread mono from the end, in place
+        if(Channels_Mono == numChannels_){
+            for(u32 i=numFrames; 0<i; --i){
+                dst[2*i-1] = dst[2*i-2] = dst[i-1];
+            }
+        }
+        return numFrames;
+    }
+
+    f32 PcmBlock::getLoudness() const
+    {
+        if(numFrames_<=0){
+            return 0.0f;
+        }
+        static const u32 ChunkFrames = 1024;
+        LSshort samples[ChunkFrames*Channels_Stereo];
+
+        f64 sum = 0.0;
+        for(u32 position=0; position<numFrames_;){
+            u32 frames = read(samples, position, ChunkFrames);
+            for(u32 i=0; i<frames*Channels_Stereo; ++i){
+                f64 x = samples[i];
+                sum += x*x;
+            }
+            position += frames;
+        }
+        return static_cast<f32>(sqrt(sum/(numFrames_*Channels_Stereo))/32767.0);
+    }
+
+    PcmBlock* PcmBlock::create(Stream& stream, Format format)
+    {
+        s64 total = stream.getTotal();
+        if(total<=0){
+            return NULL;
+        }
+        u32 numFrames = static_cast<u32>(total);
+        u16 numChannels = static_cast<u16>(stream.getChannels());
+
+        u32 numSamples = numFrames*numChannels;
+        void* data = NULL;
+        u32 frames = 0;
+        if(Format_Half == format){
+            //Decoded in float, not quantized to 16bit on the way
+            static const u32 ChunkFrames = 1024;
+            f32 chunk[ChunkFrames*Channels_Stereo];
+            u16* half = reinterpret_cast<u16*>(LIME_MALLOC(sizeof(u16)*numSamples));
+            while(frames<numFrames){
+                s32 ret = stream.read_float(chunk, lcore::minimum(numFrames-frames, ChunkFrames)*numChannels);
+                if(ret<=0){
+                    break;
+                }
+                u16* dst = half + frames*numChannels;
+                u32 numRead = static_cast<u32>(ret)*numChannels;
+                for(u32 i=0; i<numRead; ++i){
+                    dst[i] = lcore::toBinary16Float(chunk[i]);
+                }
+                frames += ret;
+            }
+            data = half;
+        }else{
+            LSshort* pcm = reinterpret_cast<LSshort*>(LIME_MALLOC(sizeof(LSshort)*numSamples));
+            while(frames<numFrames){
+                s32 ret = stream.read(pcm + frames*numChannels, (numFrames-frames)*numChannels);
+                if(ret<=0){
+                    break;
+                }
+                frames += ret;
+            }
+            data = pcm;
+        }
+        if(frames<=0){
+            LIME_FREE(data);
+            return NULL;
+        }
+
+        PcmBlock* block = LIME_NEW PcmBlock();
+        block->numFrames_ = frames;
+        block->numChannels_ = numChannels;
+        block->format_ = static_cast<u16>(format);
+        block->data_ = data;
+        return block;
+    }
+
 #ifdef ANDROID
     //-------------------------------------------
     //---
@@ -108,17 +536,152 @@ namespace lsound
 
     void Asset::addRef()
     {
-        ++refCount_;
+        lcore::atomicIncrement(&refCount_);
     }
 
     void Asset::release()
     {
-        if(--refCount_ == 0){
+        if(lcore::atomicDecrement(&refCount_) == 0){
             LIME_DELETE_NONULL(this);
         }
     }
 #endif
 
+    //-------------------------------------------
+    //---
+    //--- PackResource
+    //---
+    //-------------------------------------------
+    void PackResource::setStreamInfo(s32 index, Stream& stream)
+    {
+        stream.setFileInfo(getInfo(index), seekTable_, index);
+    }
+
+    void PackResource::setPriority(s32 index, u8 priority)
+    {
+        LASSERT(0<=index && index<numFiles_);
+        if(NULL == priorities_){
+            priorities_ = LIME_NEW u8[numFiles_];
+            for(s32 i=0; i<numFiles_; ++i){
+                priorities_[i] = 0;
+            }
+        }
+        priorities_[index] = priority;
+    }
+
+    void PackResource::setLoudness(s32 index, f32 loudness)
+    {
+        LASSERT(0<=index && index<numFiles_);
+        if(NULL == loudness_){
+            loudness_ = LIME_NEW f32[numFiles_];
+            for(s32 i=0; i<numFiles_; ++i){
+                loudness_[i] = 1.0f;
+            }
+        }
+        loudness_[index] = loudness;
+    }
+
+    void PackResource::setPolyphony(s32 index, u8 maxInstances, Polyphony polyphony)
+    {
+        LASSERT(0<=index && index<numFiles_);
+        if(NULL == maxInstances_){
+            maxInstances_ = LIME_NEW u8[numFiles_];
+            polyphonies_ = LIME_NEW u8[numFiles_];
+            for(s32 i=0; i<numFiles_; ++i){
+                maxInstances_[i] = 0;
+                polyphonies_[i] = Polyphony_Reject;
+            }
+        }
+        maxInstances_[index] = maxInstances;
+        polyphonies_[index] = static_cast<u8>(polyphony);
+    }
+
+    bool PackResource::readInfos(FileInfo*& infos, SeekTable*& seekTable, FILE* f, const PackHeader& header)
+    {
+        infos = NULL;
+        seekTable = NULL;
+        if(header.version_<PackVersion_FileInfo){
+            return true;
+        }
+        infos = LIME_NEW FileInfo[header.numFiles_];
+        if(0>=fread(infos, sizeof(FileInfo)*header.numFiles_, 1, f)){
+            LIME_DELETE_ARRAY(infos);
+            return false;
+        }
+        if(header.version_<PackVersion_SeekTable){
+            return true;
+        }
+
+        SeekRange* ranges = LIME_NEW SeekRange[header.numFiles_];
+        if(0>=fread(ranges, sizeof(SeekRange)*header.numFiles_, 1, f)){
+            LIME_DELETE_ARRAY(ranges);
+            LIME_DELETE_ARRAY(infos);
+            return false;
+        }
+        u32 numPoints = 0;
+        for(s32 i=0; i<header.numFiles_; ++i){
+            numPoints += ranges[i].numPoints_;
+        }
+        SeekPoint* points = LIME_NEW SeekPoint[numPoints];
+        if(0<numPoints && 0>=fread(points, sizeof(SeekPoint)*numPoints, 1, f)){
+            LIME_DELETE_ARRAY(points);
+            LIME_DELETE_ARRAY(ranges);
+            LIME_DELETE_ARRAY(infos);
+            return false;
+        }
+        seekTable = LIME_NEW SeekTable(header.numFiles_, ranges, points);
+        seekTable->addRef();
+        return true;
+    }
+
+#ifdef ANDROID
+    bool PackResource::readInfos(FileInfo*& infos, SeekTable*& seekTable, AAsset* asset, const PackHeader& header, s32& pos)
+    {
+        infos = NULL;
+        seekTable = NULL;
+        if(header.version_<PackVersion_FileInfo){
+            return true;
+        }
+        infos = LIME_NEW FileInfo[header.numFiles_];
+        s32 ret = AAsset_read(asset, infos, sizeof(FileInfo)*header.numFiles_);
+        if(0>=ret){
+            LIME_DELETE_ARRAY(infos);
+            return false;
+        }
+        pos += ret;
+        if(header.version_<PackVersion_SeekTable){
+            return true;
+        }
+
+        SeekRange* ranges = LIME_NEW SeekRange[header.numFiles_];
+        ret = AAsset_read(asset, ranges, sizeof(SeekRange)*header.numFiles_);
+        if(0>=ret){
+            LIME_DELETE_ARRAY(ranges);
+            LIME_DELETE_ARRAY(infos);
+            return false;
+        }
+        pos += ret;
+        u32 numPoints = 0;
+        for(s32 i=0; i<header.numFiles_; ++i){
+            numPoints += ranges[i].numPoints_;
+        }
+        SeekPoint* points = LIME_NEW SeekPoint[numPoints];
+        if(0<numPoints){
+            ret = AAsset_read(asset, points, sizeof(SeekPoint)*numPoints);
+            if(0>=ret){
+                LIME_DELETE_ARRAY(points);
+                LIME_DELETE_ARRAY(ranges);
+                LIME_DELETE_ARRAY(infos);
+                return false;
+            }
+            pos += ret;
+        }
+        seekTable = LIME_NEW SeekTable(header.numFiles_, ranges, points);
+        seekTable->addRef();
+        return true;
+    }
+#endif
+
     //-------------------------------------------
     //---
     //--- PackFile
@@ -146,7 +709,7 @@ namespace lsound
         end = start + entries_[index].size_;
     }
 
-    PackFile* PackFile::open(const Char* path)
+    PackFile* PackFile::open(const Char* path, u32 blockSize, s32 numBlocks)
     {
         LASSERT(NULL != path);
         FILE* f = NULL;
@@ -171,6 +734,13 @@ namespace lsound
             fclose(f);
             return NULL;
         }
+        FileInfo* infos = NULL;
+        SeekTable* seekTable = NULL;
+        if(!readInfos(infos, seekTable, f, header)){
+            LIME_DELETE_ARRAY(entries);
+            fclose(f);
+            return NULL;
+        }
 
         //t@C擪̃ItZbgɕϊ
         s32 dataTop = ftell(f);
@@ -181,8 +751,11 @@ namespace lsound
         PackFile* packFile = LIME_NEW PackFile();
         packFile->numFiles_ = header.numFiles_;
         packFile->entries_ = entries;
+        packFile->infos_ = infos;
+        packFile->seekTable_ = seekTable;
         packFile->file_ = LIME_NEW File(f);
         packFile->file_->addRef();
+        packFile->file_->createCache(blockSize, numBlocks);
         return packFile;
     }
 
@@ -194,11 +767,20 @@ namespace lsound
     PackMemory::PackMemory()
         :entries_(NULL)
         ,memory_(NULL)
+        ,pcms_(NULL)
     {
     }
 
     PackMemory::~PackMemory()
     {
+        if(NULL != pcms_){
+            for(s32 i=0; i<numFiles_; ++i){
+                if(NULL != pcms_[i]){
+                    pcms_[i]->release();
+                }
+            }
+            LIME_DELETE_ARRAY(pcms_);
+        }
         LIME_DELETE_ARRAY(entries_);
         if(NULL != memory_){
             memory_->release();
@@ -213,6 +795,64 @@ namespace lsound
         offset = entries_[index].offset_;
     }
 
+    bool PackMemory::cache(s32 index, PcmBlock::Format format)
+    {
+        LASSERT(0<=index && index<numFiles_);
+        if(NULL != getPcm(index)){
+            return true;
+        }
+
+        MemoryStream stream;
+        stream.set(entries_[index].size_, entries_[index].offset_, memory_);
+        setStreamInfo(index, stream);
+        if(!stream.open()){
+            return false;
+        }
+        return setPcm(index, stream, format);
+    }
+
+    s32 PackMemory::cache(u32 maxFrames, PcmBlock::Format format)
+    {
+        s32 count = 0;
+        for(s32 i=0; i<numFiles_; ++i){
+            if(NULL != getPcm(i)){
+                ++count;
+                continue;
+            }
+            MemoryStream stream;
+            stream.set(entries_[i].size_, entries_[i].offset_, memory_);
+            setStreamInfo(i, stream);
+            if(!stream.open()){
+                continue;
+            }
+            if(stream.getTotal()<=0 || maxFrames<stream.getTotal()){
+                continue;
+            }
+            if(setPcm(i, stream, format)){
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    bool PackMemory::setPcm(s32 index, Stream& stream, PcmBlock::Format format)
+    {
+        PcmBlock* block = PcmBlock::create(stream, format);
+        if(NULL == block){
+            return false;
+        }
+        if(NULL == pcms_){
+            pcms_ = LIME_NEW PcmBlock*[numFiles_];
+            for(s32 i=0; i<numFiles_; ++i){
+                pcms_[i] = NULL;
+            }
+        }
+        block->addRef();
+        pcms_[index] = block;
+        setLoudness(index, block->getLoudness());
+        return true;
+    }
+
     PackMemory* PackMemory::open(const Char* path)
     {
         LASSERT(NULL != path);
@@ -237,6 +877,13 @@ namespace lsound
             fclose(f);
             return NULL;
         }
+        FileInfo* infos = NULL;
+        SeekTable* seekTable = NULL;
+        if(!readInfos(infos, seekTable, f, header)){
+            LIME_DELETE_ARRAY(entries);
+            fclose(f);
+            return NULL;
+        }
 
         //f[^TCYvZ
         s32 dataTop = ftell(f);
@@ -247,6 +894,10 @@ namespace lsound
         u8* memory = LIME_NEW u8[size];
         if(0>=fread(memory, size, 1, f)){
             LIME_DELETE_ARRAY(memory);
+            if(NULL != seekTable){
+                seekTable->release();
+            }
+            LIME_DELETE_ARRAY(infos);
             LIME_DELETE_ARRAY(entries);
             fclose(f);
             return NULL;
@@ -256,6 +907,8 @@ namespace lsound
         PackMemory* packMemory = LIME_NEW PackMemory();
         packMemory->numFiles_ = header.numFiles_;
         packMemory->entries_ = entries;
+        packMemory->infos_ = infos;
+        packMemory->seekTable_ = seekTable;
         packMemory->memory_ = LIME_NEW Memory(size, memory);
         packMemory->memory_->addRef();
         return packMemory;
@@ -291,6 +944,14 @@ namespace lsound
         }
         pos += ret;
 
+        FileInfo* infos = NULL;
+        SeekTable* seekTable = NULL;
+        if(!readInfos(infos, seekTable, asset, header, pos)){
+            LIME_DELETE_ARRAY(entries);
+            AAsset_close(asset);
+            return NULL;
+        }
+
         //f[^TCYvZ
         s32 dataTop = pos;
         u32 size = AAsset_getLength(asset) - dataTop;
@@ -300,6 +961,10 @@ namespace lsound
         AAsset_close(asset);
         if(0>=ret){
             LIME_DELETE_ARRAY(memory);
+            if(NULL != seekTable){
+                seekTable->release();
+            }
+            LIME_DELETE_ARRAY(infos);
             LIME_DELETE_ARRAY(entries);
             return NULL;
         }
@@ -307,11 +972,137 @@ namespace lsound
         PackMemory* packMemory = LIME_NEW PackMemory();
         packMemory->numFiles_ = header.numFiles_;
         packMemory->entries_ = entries;
+        packMemory->infos_ = infos;
+        packMemory->seekTable_ = seekTable;
         packMemory->memory_ = LIME_NEW Memory(size, memory);
         packMemory->memory_->addRef();
         return packMemory;
     }
+#endif
+
+    //-------------------------------------------
+    //---
+    //--- PackMapped
+    //---
+    //-------------------------------------------
+    PackMapped::PackMapped()
+        :entries_(NULL)
+        ,memory_(NULL)
+    {
+    }
+
+    PackMapped::~PackMapped()
+    {
+        LIME_DELETE_ARRAY(entries_);
+        if(NULL != memory_){
+            memory_->release();
+        }
+    }
 
+    void PackMapped::get(s32 index, Memory*& memory, u32& size, s32& offset)
+    {
+        LASSERT(0<=index && index<numFiles_);
+        memory = memory_;
+        size = entries_[index].size_;
+        offset = entries_[index].offset_;
+    }
+
+    void PackMapped::prefetch(s32 index)
+    {
+        LASSERT(0<=index && index<numFiles_);
+        u8* top = memory_->memory_ + entries_[index].offset_;
+        u32 size = entries_[index].size_;
+#if defined(_WIN32) || defined(_WIN64)
+#if defined(_WIN32_WINNT) && 0x0602<=_WIN32_WINNT
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = top;
+        range.NumberOfBytes = size;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+        //madvise needs an address aligned to the page
+        static const uintptr_t PageMask = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1;
+        uintptr_t address = reinterpret_cast<uintptr_t>(top) & ~PageMask;
+        madvise(reinterpret_cast<void*>(address), (reinterpret_cast<uintptr_t>(top) + size) - address, MADV_WILLNEED);
+#endif
+    }
+
+    PackMapped* PackMapped::open(const Char* path)
+    {
+        LASSERT(NULL != path);
+        FILE* f = NULL;
+#if defined(_WIN32) || defined(_WIN64)
+        fopen_s(&f, path, "rb");
+#else
+        f = fopen(path, "rb");
+#endif
+        if(NULL == f){
+            return NULL;
+        }
+
+        PackHeader header;
+        if(0>=fread(&header, sizeof(PackHeader), 1, f)){
+            fclose(f);
+            return NULL;
+        }
+        FileEntry* entries = LIME_NEW FileEntry[header.numFiles_];
+        if(0>=fread(entries, sizeof(FileEntry)*header.numFiles_, 1, f)){
+            LIME_DELETE_ARRAY(entries);
+            fclose(f);
+            return NULL;
+        }
+        FileInfo* infos = NULL;
+        SeekTable* seekTable = NULL;
+        if(!readInfos(infos, seekTable, f, header)){
+            LIME_DELETE_ARRAY(entries);
+            fclose(f);
+            return NULL;
+        }
+
+        s32 dataTop = ftell(f);
+        fseek(f, 0, SEEK_END);
+        u64 fileSize = ftell(f);
+
+        //Map whole file, nothing is read until touched
+        void* mapping = NULL;
+        if(static_cast<u64>(dataTop)<fileSize){
+#if defined(_WIN32) || defined(_WIN64)
+            HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(f)));
+            HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if(NULL != fileMapping){
+                mapping = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(fileMapping); //the view keeps the mapping
+            }
+#else
+            mapping = mmap(NULL, static_cast<size_t>(fileSize), PROT_READ, MAP_SHARED, fileno(f), 0);
+            if(MAP_FAILED == mapping){
+                mapping = NULL;
+            }
+#endif
+        }
+        fclose(f);
+
+        if(NULL == mapping){
+            if(NULL != seekTable){
+                seekTable->release();
+            }
+            LIME_DELETE_ARRAY(infos);
+            LIME_DELETE_ARRAY(entries);
+            return NULL;
+        }
+
+        PackMapped* packMapped = LIME_NEW PackMapped();
+        packMapped->numFiles_ = header.numFiles_;
+        packMapped->entries_ = entries;
+        packMapped->infos_ = infos;
+        packMapped->seekTable_ = seekTable;
+        u32 size = static_cast<u32>(fileSize - dataTop);
+        packMapped->memory_ = LIME_NEW Memory(size, reinterpret_cast<u8*>(mapping) + dataTop, mapping, fileSize);
+        packMapped->memory_->addRef();
+        return packMapped;
+    }
+
+#ifdef ANDROID
     //-------------------------------------------
     //---
     //--- PackAsset
@@ -369,6 +1160,14 @@ namespace lsound
         }
         pos += ret;
 
+        FileInfo* infos = NULL;
+        SeekTable* seekTable = NULL;
+        if(!readInfos(infos, seekTable, asset, header, pos)){
+            LIME_DELETE_ARRAY(entries);
+            AAsset_close(asset);
+            return NULL;
+        }
+
         //t@C擪̃ItZbgɕϊ
         s32 dataTop = pos;
         for(s32 i=0; i<header.numFiles_; ++i){
@@ -378,6 +1177,8 @@ namespace lsound
         PackAsset* packAsset = LIME_NEW PackAsset();
         packAsset->numFiles_ = header.numFiles_;
         packAsset->entries_ = entries;
+        packAsset->infos_ = infos;
+        packAsset->seekTable_ = seekTable;
         packAsset->asset_ = LIME_NEW Asset(asset);
         packAsset->asset_->addRef();
         return packAsset;
@@ -14,13 +14,35 @@
 
 #include "Pack.h"
 
-//#define LSOUND_RESOURCE_ENABLE_SYNC
+#define LSOUND_RESOURCE_ENABLE_SYNC //Players may be decoded on several threads
+#define LSOUND_RESOURCE_ENABLE_PREAD //File::read reads at an offset without a shared cursor and lock
 #ifdef LSOUND_RESOURCE_ENABLE_SYNC
 #include <lcore/async/SyncObject.h>
 #endif
+#include <lcore/async/LockFree.h>
 
 namespace lsound
 {
+    class Stream;
+
+    //-------------------------------------------
+    //---
+    //--- FileBlock
+    //---
+    //-------------------------------------------
+    /**
+    @brief Cached block of a file, read at an offset aligned to the block size
+    */
+    struct FileBlock
+    {
+        FileBlock* prev_;
+        FileBlock* next_;
+        s64 offset_;
+        s32 size_; //negative while loading
+        s32 refCount_;
+        u8* data_;
+    };
+
     //-------------------------------------------
     //---
     //--- File
@@ -29,20 +51,55 @@ namespace lsound
     class File
     {
     public:
+        static const u32 DefaultBlockSize = 64*1024;
+        static const s32 DefaultNumBlocks = 16;
+
         File();
         File(FILE* file);
         ~File();
 
         void addRef();
         void release();
+
+        /**
+        @brief Read bytes at an offset from the top of the file
+        @return number of bytes, negative if failed
+        */
+        s32 read(void* dst, s64 offset, s32 size);
+
+        /**
+        @brief Create blocks shared by the streams of this file, least recently used one is reused
+        */
+        bool createCache(u32 blockSize, s32 numBlocks);
+
+        /**
+        @brief Get a block which contains offset, load it if not cached
+        @return NULL if no block is available or the block is still loading, then read directly
+        */
+        const FileBlock* acquireBlock(s64 offset);
+        void releaseBlock(const FileBlock* block);
     private:
         friend class FileStream;
 
         File(const File&);
         File& operator=(const File&);
 
-        s32 refCount_;
+        void destroyCache();
+
+        volatile s32 refCount_;
         FILE* file_;
+        u32 blockSize_;
+        s32 numBlocks_;
+        FileBlock* blocks_;
+        FileBlock blockTop_; //sentinel, next_ is the most recently used
+        u8* blockBuffer_;
+#ifdef LSOUND_RESOURCE_ENABLE_PREAD
+#if defined(_WIN32) || defined(_WIN64)
+        void* handle_;
+#else
+        s32 descriptor_;
+#endif
+#endif
 #ifdef LSOUND_RESOURCE_ENABLE_SYNC
         lcore::CriticalSection cs_;
 #endif
@@ -58,21 +115,142 @@ namespace lsound
     public:
         Memory();
         Memory(u32 size, u8* memory);
+
+        /**
+        @brief Memory in a read only mapping of a file, unmapped instead of deleted
+        @param mapping ... top of the mapping
+        @param mappingSize ... size of the mapping
+        */
+        Memory(u32 size, u8* memory, void* mapping, u64 mappingSize);
         ~Memory();
 
         void addRef();
         void release();
     private:
         friend class MemoryStream;
+        friend class PackMapped;
 
         Memory(const Memory&);
         Memory& operator=(const Memory&);
 
-        s32 refCount_;
+        volatile s32 refCount_;
         u32 size_;
         u8* memory_;
+        void* mapping_;
+        u64 mappingSize_;
+    };
+
+    //-------------------------------------------
+    //---
+    //--- SeekTable
+    //---
+    //-------------------------------------------
+    /**
+    @brief Seek points of all entries of a pack
+    */
+    class SeekTable
+    {
+    public:
+        SeekTable(s32 numEntries, SeekRange* ranges, SeekPoint* points);
+        ~SeekTable();
+
+        void addRef();
+        void release();
+
+        /**
+        @brief Find the last seek point at or before a position
+        @return NULL if the entry has no point before the position
+        @param index ... entry
+        @param position ... sample at 48kHz
+        */
+        const SeekPoint* find(s32 index, s64 position) const;
+    private:
+        SeekTable(const SeekTable&);
+        SeekTable& operator=(const SeekTable&);
+
+        volatile s32 refCount_;
+        s32 numEntries_;
+        SeekRange* ranges_;
+        SeekPoint* points_;
     };
 
+    //-------------------------------------------
+    //---
+    //--- PcmBlock
+    //---
+    //-------------------------------------------
+    /**
+    @brief Decoded pcm of a pack entry, shared and never modified by players
+    */
+    class PcmBlock
+    {
+    public:
+        enum Format
+        {
+            Format_Short = 0,
+            Format_Half = 1, ///< half float, lcore::toBinary16Float
+        };
+
+        void addRef();
+        void release();
+
+        inline u32 getNumFrames() const;
+        inline u16 getNumChannels() const;
+        inline u16 getFormat() const;
+        inline u32 getSizeInBytes() const;
+
+        /**
+        @brief Root mean square of the samples, 1 for a full scale square wave
+        */
+        f32 getLoudness() const;
+
+        /**
+        @brief Read frames as interleaved stereo
+        @return number of frames
+        @param dst ... numFrames*2 samples
+        @param position ... frame to start
+        */
+        u32 read(LSshort* dst, u32 position, u32 numFrames) const;
+        u32 read(LSfloat* dst, u32 position, u32 numFrames) const;
+
+        /**
+        @brief Decode a whole stream
+        */
+        static PcmBlock* create(Stream& stream, Format format);
+    private:
+        PcmBlock(const PcmBlock&);
+        PcmBlock& operator=(const PcmBlock&);
+
+        PcmBlock();
+        ~PcmBlock();
+
+        volatile s32 refCount_;
+        u32 numFrames_;
+        u16 numChannels_;
+        u16 format_;
+        void* data_;
+    };
+
+    inline u32 PcmBlock::getNumFrames() const
+    {
+        return numFrames_;
+    }
+
+    inline u16 PcmBlock::getNumChannels() const
+    {
+        return numChannels_;
+    }
+
+    inline u16 PcmBlock::getFormat() const
+    {
+        return format_;
+    }
+
+    inline u32 PcmBlock::getSizeInBytes() const
+    {
+        return numFrames_*numChannels_*((Format_Short == format_)? sizeof(LSshort) : sizeof(u16));
+    }
+
 #ifdef ANDROID
     //-------------------------------------------
     //---
@@ -96,7 +274,7 @@ namespace lsound
         Asset(const Asset&);
         Asset& operator=(const Asset&);
 
-        s32 refCount_;
+        volatile s32 refCount_;
         AAsset* asset_;
 #ifdef LSOUND_RESOURCE_ENABLE_SYNC
         lcore::CriticalSection cs_;
@@ -117,23 +295,103 @@ namespace lsound
             ResourceType_File,
             ResourceType_Memory,
             ResourceType_Asset,
+            ResourceType_Mapped,
         };
 
         virtual ~PackResource()
-        {}
+        {
+            LIME_DELETE_ARRAY(polyphonies_);
+            LIME_DELETE_ARRAY(maxInstances_);
+            LIME_DELETE_ARRAY(loudness_);
+            LIME_DELETE_ARRAY(priorities_);
+            LIME_DELETE_ARRAY(infos_);
+            if(NULL != seekTable_){
+                seekTable_->release();
+            }
+        }
 
         /// t@C擾
         s32 getNumFiles() const{ return numFiles_;}
 
         virtual s32 getType() const =0;
+
+        /// NULL if the pack has no FileInfo
+        inline const FileInfo* getInfo(s32 index) const;
+
+        /// Pass FileInfo and seek points of an entry to its stream
+        void setStreamInfo(s32 index, Stream& stream);
+
+        /// Voices of higher priority are decoded first, 0 if not set
+        inline u8 getPriority(s32 index) const;
+        void setPriority(s32 index, u8 priority);
+
+        /// Root mean square of an entry at gain 1, 1 if not set
+        inline f32 getLoudness(s32 index) const;
+        void setLoudness(s32 index, f32 loudness);
+
+        /// Voices of an entry playing at once, 0 for no limit
+        inline u8 getMaxInstances(s32 index) const;
+        inline u8 getPolyphony(s32 index) const;
+        void setPolyphony(s32 index, u8 maxInstances, Polyphony polyphony);
     protected:
         PackResource()
             :numFiles_(0)
+            ,infos_(NULL)
+            ,seekTable_(NULL)
+            ,priorities_(NULL)
+            ,loudness_(NULL)
+            ,maxInstances_(NULL)
+            ,polyphonies_(NULL)
         {}
 
+        /**
+        @brief Read FileInfo array which follows FileEntry array from version 2,
+        and seek table from version 3
+        */
+        static bool readInfos(FileInfo*& infos, SeekTable*& seekTable, FILE* f, const PackHeader& header);
+#ifdef ANDROID
+        static bool readInfos(FileInfo*& infos, SeekTable*& seekTable, AAsset* asset, const PackHeader& header, s32& pos);
+#endif
+
         s32 numFiles_;
+        FileInfo* infos_;
+        SeekTable* seekTable_;
+        u8* priorities_; //allocated when set
+        f32* loudness_; //allocated when set
+        u8* maxInstances_; //allocated when set
+        u8* polyphonies_;
     };
 
+    inline const FileInfo* PackResource::getInfo(s32 index) const
+    {
+        LASSERT(0<=index && index<numFiles_);
+        return (NULL == infos_)? NULL : &infos_[index];
+    }
+
+    inline u8 PackResource::getPriority(s32 index) const
+    {
+        LASSERT(0<=index && index<numFiles_);
+        return (NULL == priorities_)? 0 : priorities_[index];
+    }
+
+    inline f32 PackResource::getLoudness(s32 index) const
+    {
+        LASSERT(0<=index && index<numFiles_);
+        return (NULL == loudness_)? 1.0f : loudness_[index];
+    }
+
+    inline u8 PackResource::getMaxInstances(s32 index) const
+    {
+        LASSERT(0<=index && index<numFiles_);
+        return (NULL == maxInstances_)? 0 : maxInstances_[index];
+    }
+
+    inline u8 PackResource::getPolyphony(s32 index) const
+    {
+        LASSERT(0<=index && index<numFiles_);
+        return (NULL == polyphonies_)? static_cast<u8>(Polyphony_Reject) : polyphonies_[index];
+    }
+
     //-------------------------------------------
     //---
     //--- PackFile
@@ -149,7 +407,11 @@ namespace lsound
 
         void get(s32 index, File*& file, s32& start, s32& end);
 
-        static PackFile* open(const Char* path);
+        /**
+        @param blockSize ... size of read-ahead blocks shared by streams of the pack
+        @param numBlocks ... 0 to read directly
+        */
+        static PackFile* open(const Char* path, u32 blockSize=File::DefaultBlockSize, s32 numBlocks=File::DefaultNumBlocks);
     private:
         PackFile(const PackFile&);
         PackFile& operator=(const PackFile&);
@@ -173,6 +435,22 @@ namespace lsound
 
         void get(s32 index, Memory*& memory, u32& size, s32& offset);
 
+        /**
+        @brief Decoded pcm of the entry, NULL if not cached
+        */
+        inline PcmBlock* getPcm(s32 index);
+
+        /**
+        @brief Decode an entry once, players of it read the decoded pcm
+        */
+        bool cache(s32 index, PcmBlock::Format format);
+
+        /**
+        @brief Cache all entries which are shorter than maxFrames
+        @return number of cached entries
+        */
+        s32 cache(u32 maxFrames, PcmBlock::Format format);
+
         static PackMemory* open(const Char* path);
 
 #ifdef ANDROID
@@ -183,6 +461,48 @@ namespace lsound
         PackMemory(const PackMemory&);
         PackMemory& operator=(const PackMemory&);
 
+        bool setPcm(s32 index, Stream& stream, PcmBlock::Format format);
+
+        FileEntry* entries_;
+        Memory* memory_;
+        PcmBlock** pcms_;
+    };
+
+    inline PcmBlock* PackMemory::getPcm(s32 index)
+    {
+        LASSERT(0<=index && index<numFiles_);
+        return (NULL == pcms_)? NULL : pcms_[index];
+    }
+
+    //-------------------------------------------
+    //---
+    //--- PackMapped
+    //---
+    //-------------------------------------------
+    /**
+    @brief Pack mapped into the address space. Pages are read on first touch
+    and shared with other processes mapping the same file.
+    */
+    class PackMapped : public PackResource
+    {
+    public:
+        PackMapped();
+        virtual ~PackMapped();
+
+        virtual s32 getType() const{ return PackResource::ResourceType_Mapped;}
+
+        void get(s32 index, Memory*& memory, u32& size, s32& offset);
+
+        /**
+        @brief Hint that an entry will be read soon, pages are read ahead in background
+        */
+        void prefetch(s32 index);
+
+        static PackMapped* open(const Char* path);
+    private:
+        PackMapped(const PackMapped&);
+        PackMapped& operator=(const PackMapped&);
+
         FileEntry* entries_;
         Memory* memory_;
     };
@@ -5,6 +5,7 @@
 */
 #include "Stream.h"
 #include "Resource.h"
+#include <lcore/CLibrary.h>
 
 #ifdef LSOUND_USE_WAVE
 #if defined(_WIN32) || defined(_WIN64)
@@ -43,12 +44,19 @@ namespace lsound
         ,position_(0)
         ,format_(Format_Stereo16)
         ,channels_(Channels_Stereo)
+        ,seekTable_(NULL)
+        ,seekIndex_(0)
+        ,seekOffset_(0)
     {
+        setFileInfo(NULL, NULL, 0);
     }
 
     Stream::~Stream()
     {
         close();
+        if(NULL != seekTable_){
+            seekTable_->release();
+        }
     }
 
     void Stream::close()
@@ -60,9 +68,32 @@ namespace lsound
         opusFile_ = NULL;
     }
 
+    void Stream::setFileInfo(const FileInfo* info, SeekTable* seekTable, s32 index)
+    {
+        if(NULL != info){
+            info_ = *info;
+        }else{
+            info_.channels_ = 0;
+            info_.preSkip_ = 0;
+            info_.headerSize_ = 0;
+            info_.totalPcm_ = 0;
+        }
+        seekOffset_ = info_.headerSize_;
+
+        if(NULL != seekTable){
+            seekTable->addRef();
+        }
+        if(NULL != seekTable_){
+            seekTable_->release();
+        }
+        seekTable_ = seekTable;
+        seekIndex_ = index;
+    }
+
     void Stream::setInfo()
     {
-        total_ = op_pcm_total(opusFile_, 0);
+        //Unseekable streams cannot know the total without reading to the end
+        total_ = (hasFileInfo())? info_.totalPcm_ : op_pcm_total(opusFile_, 0);
         position_ = op_pcm_tell(opusFile_);
         s32 numChannels = op_channel_count(opusFile_, 0);
 
@@ -87,6 +118,47 @@ namespace lsound
         lcore::swap(position_, rhs.position_);
         lcore::swap(format_, rhs.format_);
         lcore::swap(channels_, rhs.channels_);
+        lcore::swap(info_, rhs.info_);
+        lcore::swap(seekTable_, rhs.seekTable_);
+        lcore::swap(seekIndex_, rhs.seekIndex_);
+        lcore::swap(seekOffset_, rhs.seekOffset_);
+    }
+
+    s32 Stream::reopen(opus_int64 offset)
+    {
+        if(offset<0 || total_<offset){
+            return Error_Inval;
+        }
+        SeekPoint point;
+        point.pcm_ = 0;
+        point.offset_ = info_.headerSize_;
+        if(NULL != seekTable_){
+            //Start far enough before the position, not to decode it from a cold decoder
+            const SeekPoint* found = seekTable_->find(seekIndex_, lcore::maximum(offset-PreRoll, static_cast<opus_int64>(0)));
+            if(NULL != found){
+                point = *found;
+            }
+        }
+
+        close();
+        seekOffset_ = point.offset_;
+        if(!open()){
+            return Error_Fault;
+        }
+
+        //Decode from the page to the position
+        opus_int16 pcm[SkipSamples];
+        opus_int64 numChannels = op_channel_count(opusFile_, -1);
+        opus_int64 rest = offset - point.pcm_;
+        while(0<rest){
+            s32 size = static_cast<s32>(lcore::minimum(rest*numChannels, static_cast<opus_int64>(SkipSamples)));
+            s32 ret = op_read(opusFile_, pcm, size, NULL);
+            if(ret<=0){
+                return (ret<0)? ret : Error_Inval;
+            }
+            rest -= ret;
+        }
+        return 0;
     }
 
     //-------------------------------------------
@@ -102,17 +174,32 @@ namespace lsound
         FileStream::close_func,
     };
 
+    //Without seek, opusfile does not search the last page on open
+    OpusFileCallbacks FileStream::streamCallbacks_ =
+    {
+        FileStream::read_func,
+        NULL,
+        NULL,
+        FileStream::close_func,
+    };
+
     FileStream::FileStream()
         :start_(0)
         ,end_(0)
         ,current_(0)
+        ,headerEnd_(0)
+        ,dataStart_(0)
         ,file_(NULL)
+        ,block_(NULL)
     {
     }
 
     FileStream::~FileStream()
     {
         if(NULL != file_){
+            if(NULL != block_){
+                file_->releaseBlock(block_);
+            }
             file_->release();
         }
     }
@@ -124,6 +211,10 @@ namespace lsound
         LASSERT(start<=end);
 
         if(NULL != file_){
+            if(NULL != block_){
+                file_->releaseBlock(block_);
+                block_ = NULL;
+            }
             file_->release();
         }
 
@@ -138,7 +229,14 @@ namespace lsound
     bool FileStream::open()
     {
         LASSERT(NULL == opusFile_);
-        opusFile_ = op_open_callbacks(this, &callbacks_, NULL, 0, NULL);
+        current_ = start_;
+        if(isStreamed()){
+            headerEnd_ = start_ + info_.headerSize_;
+            dataStart_ = start_ + seekOffset_;
+        }else{
+            headerEnd_ = dataStart_ = start_;
+        }
+        opusFile_ = op_open_callbacks(this, (isStreamed())? &streamCallbacks_ : &callbacks_, NULL, 0, NULL);
         if(NULL == opusFile_){
             return false;
         }
@@ -155,21 +253,59 @@ namespace lsound
         lcore::swap(start_, rhs.start_);
         lcore::swap(end_, rhs.end_);
         lcore::swap(current_, rhs.current_);
+        lcore::swap(headerEnd_, rhs.headerEnd_);
+        lcore::swap(dataStart_, rhs.dataStart_);
         lcore::swap(file_, rhs.file_);
+        lcore::swap(block_, rhs.block_);
     }
 
     int FileStream::read_func(void* stream, unsigned char* ptr, int nbytes)
     {
         FileStream* fileStream = (FileStream*)stream;
-#ifdef LSOUND_RESOURCE_ENABLE_SYNC
-        lcore::CSLock lock(fileStream->file_->cs_);
-#endif
-        FILE* file = fileStream->file_->file_;
 
-        fseek(file, fileStream->current_, SEEK_SET);
-        size_t bytes = fread(ptr, 1, nbytes, file);
-        fileStream->current_ += bytes;
-        return static_cast<int>(bytes);
+        //Read the header pages, then continue from the page to start
+        opus_int64 end = fileStream->end_;
+        if(fileStream->current_<fileStream->headerEnd_){
+            end = fileStream->headerEnd_;
+        }else if(fileStream->current_ == fileStream->headerEnd_){
+            fileStream->current_ = fileStream->dataStart_;
+        }
+        opus_int64 rest = end - fileStream->current_;
+        if(rest<=0){
+            return 0;
+        }
+        if(rest<nbytes){
+            nbytes = static_cast<int>(rest);
+        }
+
+        //Serve from the block which contains current_, change blocks on the boundary
+        const FileBlock* block = fileStream->block_;
+        if(NULL == block
+            || fileStream->current_<block->offset_
+            || (block->offset_+block->size_)<=fileStream->current_)
+        {
+            if(NULL != block){
+                fileStream->file_->releaseBlock(block);
+            }
+            block = fileStream->block_ = fileStream->file_->acquireBlock(fileStream->current_);
+        }
+
+        s32 bytes;
+        if(NULL != block){
+            s32 offset = static_cast<s32>(fileStream->current_ - block->offset_);
+            bytes = lcore::minimum(nbytes, block->size_ - offset);
+            if(0<bytes){
+                lcore::memcpy(ptr, block->data_+offset, bytes);
+            }else{
+                bytes = 0;
+            }
+        }else{
+            bytes = fileStream->file_->read(ptr, fileStream->current_, nbytes);
+        }
+        if(0<bytes){
+            fileStream->current_ += bytes;
+        }
+        return bytes;
     }
 
     int FileStream::seek_func(void* stream, opus_int64 offset, int whence)
@@ -209,8 +345,18 @@ namespace lsound
     //--- MemoryStream
     //---
     //-------------------------------------------
+    OpusFileCallbacks MemoryStream::streamCallbacks_ =
+    {
+        MemoryStream::read_func,
+        NULL,
+        NULL,
+        MemoryStream::close_func,
+    };
+
     MemoryStream::MemoryStream()
         :size_(0)
+        ,offset_(0)
+        ,current_(0)
         ,memory_(NULL)
     {
     }
@@ -232,6 +378,7 @@ namespace lsound
 
         size_ = size;
         offset_ = offset;
+        current_ = 0;
         memory_ = memory;
         memory_->addRef();
     }
@@ -239,7 +386,13 @@ namespace lsound
     bool MemoryStream::open()
     {
         LASSERT(NULL == opusFile_);
-        opusFile_ = op_open_memory(memory_->memory_+offset_, size_, NULL);
+        if(isStreamed()){
+            //Hand the header pages as initial data, reading continues from the page to start
+            current_ = seekOffset_;
+            opusFile_ = op_open_callbacks(this, &streamCallbacks_, memory_->memory_+offset_, info_.headerSize_, NULL);
+        }else{
+            opusFile_ = op_open_memory(memory_->memory_+offset_, size_, NULL);
+        }
         if(NULL == opusFile_){
             return false;
         }
@@ -254,9 +407,25 @@ namespace lsound
 
         lcore::swap(size_, rhs.size_);
         lcore::swap(offset_, rhs.offset_);
+        lcore::swap(current_, rhs.current_);
         lcore::swap(memory_, rhs.memory_);
     }
 
+    int MemoryStream::read_func(void* stream, unsigned char* ptr, int nbytes)
+    {
+        MemoryStream* memoryStream = (MemoryStream*)stream;
+        u32 rest = memoryStream->size_ - memoryStream->current_;
+        u32 bytes = lcore::minimum(rest, static_cast<u32>(nbytes));
+        lcore::memcpy(ptr, memoryStream->memory_->memory_ + memoryStream->offset_ + memoryStream->current_, bytes);
+        memoryStream->current_ += bytes;
+        return static_cast<int>(bytes);
+    }
+
+    int MemoryStream::close_func(void*)
+    {
+        return 0;
+    }
+
 #ifdef ANDROID
     //-------------------------------------------
     //---
@@ -271,10 +440,20 @@ namespace lsound
         AssetStream::close_func,
     };
 
+    OpusFileCallbacks AssetStream::streamCallbacks_ =
+    {
+        AssetStream::read_func,
+        NULL,
+        NULL,
+        AssetStream::close_func,
+    };
+
     AssetStream::AssetStream()
         :start_(0)
         ,end_(0)
         ,current_(0)
+        ,headerEnd_(0)
+        ,dataStart_(0)
         ,asset_(NULL)
     {
     }
@@ -307,7 +486,14 @@ namespace lsound
     bool AssetStream::open()
     {
         LASSERT(NULL == opusFile_);
-        opusFile_ = op_open_callbacks(this, &callbacks_, NULL, 0, NULL);
+        current_ = start_;
+        if(isStreamed()){
+            headerEnd_ = start_ + info_.headerSize_;
+            dataStart_ = start_ + seekOffset_;
+        }else{
+            headerEnd_ = dataStart_ = start_;
+        }
+        opusFile_ = op_open_callbacks(this, (isStreamed())? &streamCallbacks_ : &callbacks_, NULL, 0, NULL);
         if(NULL == opusFile_){
             return false;
         }
@@ -324,6 +510,8 @@ namespace lsound
         lcore::swap(start_, rhs.start_);
         lcore::swap(end_, rhs.end_);
         lcore::swap(current_, rhs.current_);
+        lcore::swap(headerEnd_, rhs.headerEnd_);
+        lcore::swap(dataStart_, rhs.dataStart_);
         lcore::swap(asset_, rhs.asset_);
     }
 
@@ -335,6 +523,19 @@ namespace lsound
 #endif
         AAsset* asset = assetStream->asset_->asset_;
 
+        opus_int64 end = assetStream->end_;
+        if(assetStream->current_<assetStream->headerEnd_){
+            end = assetStream->headerEnd_;
+        }else if(assetStream->current_ == assetStream->headerEnd_){
+            assetStream->current_ = assetStream->dataStart_;
+        }
+        opus_int64 rest = end - assetStream->current_;
+        if(rest<=0){
+            return 0;
+        }
+        if(rest<nbytes){
+            nbytes = static_cast<int>(rest);
+        }
         AAsset_seek64(asset, assetStream->current_, SEEK_SET);
         s32 bytes = AAsset_read(asset, ptr, nbytes);
 
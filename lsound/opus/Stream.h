@@ -7,13 +7,16 @@
 */
 #include "../lsound.h"
 #include <opus/opusfile.h>
+#include "Pack.h"
 
 
 namespace lsound
 {
     class File;
+    struct FileBlock;
     class Memory;
     class Asset;
+    class SeekTable;
 
     enum Error
     {
@@ -28,6 +31,7 @@ namespace lsound
         Error_BadPacket = OP_EBADPACKET,
         Error_BadLink = OP_EBADLINK,
         Error_BadTimestamp = OP_EBADTIMESTAMP,
+        Error_NoSeek = OP_ENOSEEK,
     };
 
 #ifndef LSOUND_USE_WAVE
@@ -42,6 +46,18 @@ namespace lsound
         void close();
         virtual bool open() =0;
 
+        /**
+        @brief Use information from the pack instead of probing the stream on open.
+        With a seek table the stream is opened as unseekable, and seek reopens it from the nearest seek point.
+        @param info ... NULL to probe
+        @param seekTable ... can be NULL, then the stream is opened seekable and seek bisects it
+        @param index ... entry of the stream in seekTable
+        */
+        void setFileInfo(const FileInfo* info, SeekTable* seekTable, s32 index);
+        inline bool hasFileInfo() const;
+        /// Whether open skips probing, needs a seek table to seek
+        inline bool isStreamed() const;
+
         /**
         @return Tv
         */
@@ -72,6 +88,7 @@ namespace lsound
         inline LSenum getType() const;
     protected:
         friend class Context;
+        friend class MixerContext;
 
         Stream(const Stream&);
         Stream& operator=(const Stream&);
@@ -81,14 +98,34 @@ namespace lsound
 
         void setInfo();
         void swap(Stream& rhs);
+        s32 reopen(opus_int64 offset);
+
+        /// Samples of a buffer to skip decoded samples after reopen
+        static const s32 SkipSamples = 1920;
+        /// Samples decoded before the position of a seek, for the decoder to converge (RFC 7845 4.6)
+        static const s32 PreRoll = 3840;
 
         OggOpusFile* opusFile_;
         opus_int64 total_; //number of samples at 48kHz
         opus_int64 position_;
         LSenum format_;
         LSenum channels_;
+        FileInfo info_;
+        SeekTable* seekTable_;
+        s32 seekIndex_;
+        u32 seekOffset_; //byte offset of the page where decoding begins, after the header pages
     };
 
+    inline bool Stream::hasFileInfo() const
+    {
+        return 0<info_.totalPcm_;
+    }
+
+    inline bool Stream::isStreamed() const
+    {
+        return hasFileInfo() && NULL != seekTable_;
+    }
+
     inline s32 Stream::read(opus_int16* pcm, s32 size)
     {
         LASSERT(NULL != opusFile_);
@@ -138,7 +175,7 @@ namespace lsound
     inline s32 Stream::seek(opus_int64 offset)
     {
         LASSERT(NULL != opusFile_);
-        s32 ret = op_pcm_seek(opusFile_, offset);
+        s32 ret = (op_seekable(opusFile_))? op_pcm_seek(opusFile_, offset) : reopen(offset);
         if(0==ret){
             position_ = offset;
         }
@@ -205,11 +242,15 @@ namespace lsound
         FileStream& operator=(const FileStream&);
 
         static OpusFileCallbacks callbacks_;
+        static OpusFileCallbacks streamCallbacks_;
 
         opus_int64 start_;
         opus_int64 end_;
         opus_int64 current_;
+        opus_int64 headerEnd_; //reading jumps from here to dataStart_
+        opus_int64 dataStart_;
         File* file_;
+        const FileBlock* block_;
     };
 
     //-------------------------------------------
@@ -231,8 +272,14 @@ namespace lsound
         MemoryStream(const MemoryStream&);
         MemoryStream& operator=(const MemoryStream&);
 
+        static int read_func(void* stream, unsigned char* ptr, int nbytes);
+        static int close_func(void* stream);
+
+        static OpusFileCallbacks streamCallbacks_;
+
         u32 size_;
         u32 offset_;
+        u32 current_;
         Memory* memory_;
     };
 
@@ -262,10 +309,13 @@ namespace lsound
         static int close_func(void* stream);
 
         static OpusFileCallbacks callbacks_;
+        static OpusFileCallbacks streamCallbacks_;
 
         opus_int64 start_;
         opus_int64 end_;
         opus_int64 current_;
+        opus_int64 headerEnd_; //reading jumps from here to dataStart_
+        opus_int64 dataStart_;
         Asset* asset_;
     };
 #endif
@@ -392,6 +442,9 @@ namespace lsound
         virtual opus_int64 tell() =0;
         virtual s32 seek(opus_int64 offset) =0;
 
+        /// Wave does not need probing
+        void setFileInfo(const FileInfo*, SeekTable*, s32){}
+
         inline opus_int64 getTotal() const;
         inline opus_int64 getPosition() const;
         inline LSuint getSampleRate() const;
@@ -401,6 +454,7 @@ namespace lsound
         inline LSenum getType() const;
     protected:
         friend class Context;
+        friend class MixerContext;
 
         Stream(const Stream&);
         Stream& operator=(const Stream&);
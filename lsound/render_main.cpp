@@ -0,0 +1,110 @@
+#include <lcore/lcore.h>
+#include <lcore/CLibrary.h>
+#include <stdlib.h>
+#include "lsound.h"
+#include "Context.h"
+#include "UserPlayer.h"
+#include "Player.h"
+
+#if defined(LSOUND_API_OFFLINE)
+namespace
+{
+    void printUsage()
+    {
+        printf("render pack [-stream|-map] [-id n] [-voices n] [-seconds n] [-cache seconds] [-half] [-out file.wav]\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc<2){
+        printUsage();
+        return 0;
+    }
+
+    const char* packPath = argv[1];
+    const char* outPath = NULL;
+    bool stream = false;
+    bool map = false;
+    lcore::s32 id = 0;
+    lcore::s32 voices = 1;
+    lcore::s32 seconds = 10;
+    lcore::f32 cacheSeconds = 0.0f;
+    bool half = false;
+    for(lcore::s32 i=2; i<argc; ++i){
+        if(0 == lcore::strncmp(argv[i], "-stream", 7)){
+            stream = true;
+        }else if(0 == lcore::strncmp(argv[i], "-map", 4)){
+            map = true;
+        }else if(0 == lcore::strncmp(argv[i], "-id", 3) && (i+1)<argc){
+            id = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-voices", 7) && (i+1)<argc){
+            voices = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-seconds", 8) && (i+1)<argc){
+            seconds = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-cache", 6) && (i+1)<argc){
+            cacheSeconds = static_cast<lcore::f32>(atof(argv[++i]));
+        }else if(0 == lcore::strncmp(argv[i], "-half", 5)){
+            half = true;
+        }else if(0 == lcore::strncmp(argv[i], "-out", 4) && (i+1)<argc){
+            outPath = argv[++i];
+        }else{
+            printUsage();
+            return 0;
+        }
+    }
+
+    lcore::System system;
+    {
+        lsound::Context::InitParam initParam;
+        initParam.maxPlayers_ = lcore::maximum(initParam.maxPlayers_, voices);
+        if(!lsound::Context::initialize(initParam)){
+            printf("fail to initialize\n");
+            return -1;
+        }
+        lsound::Context& context = lsound::Context::getInstance();
+
+        lcore::s32 packId = (map)? context.mapResourcePack(0, packPath) : context.loadResourcePack(0, packPath, stream);
+        if(packId<0){
+            printf("fail to load %s\n", packPath);
+            lsound::Context::terminate();
+            return -1;
+        }
+        if(0.0f<cacheSeconds){
+            printf("cached %d entries\n", context.cacheResourcePack(0, cacheSeconds, half));
+        }
+        if(NULL != outPath && !context.openWaveFile(outPath)){
+            printf("fail to open %s\n", outPath);
+        }
+
+        lsound::Handle handle = context.createUserPlayer(0, id);
+        lsound::UserPlayer* player = context.findUserPlayer(handle);
+        if(NULL != player){
+            player->setFlag(lsound::PlayerFlag_Loop);
+            player->play();
+        }
+        for(lcore::s32 i=1; i<voices; ++i){
+            context.play(0, id, 1.0f/voices);
+        }
+        context.updateRequests();
+
+        const lcore::s32 totalFrames = seconds * context.getDevice().getSamplesPerSec();
+        const lcore::s32 framesPerCall = lsound::BufferNumSamplesPerChannel;
+
+        lcore::ClockType start = lcore::getPerformanceCounter();
+        lcore::s32 rendered = 0;
+        while(rendered<totalFrames){
+            rendered += context.render(NULL, lcore::minimum(framesPerCall, totalFrames-rendered));
+        }
+        lcore::f64 time = lcore::calcTime64(start, lcore::getPerformanceCounter());
+
+        lcore::f64 audioTime = static_cast<lcore::f64>(rendered)/context.getDevice().getSamplesPerSec();
+        printf("rendered %d frames, %f sec in %f sec (x%f realtime)\n", rendered, audioTime, time, audioTime/time);
+
+        context.destroyUserPlayer(handle);
+        context.closeWaveFile();
+        lsound::Context::terminate();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,187 @@
+#include <lcore/lcore.h>
+#include <lcore/CLibrary.h>
+#include <stdlib.h>
+#include <speex/speex_resampler.h>
+#include "lsound.h"
+#include "dsp/dsp.h"
+#include "dsp/Polyphase.h"
+
+namespace
+{
+    using namespace lcore;
+
+    static const f64 PI = 3.14159265358979323846;
+    /// Frames given to a resampler at once, as a mixer block
+    static const u32 BlockFrames = 960;
+    static const u32 Channels = 2;
+    /// Frames at both ends skipped when measuring, filters are still filling there
+    static const u32 EdgeFrames = 1024;
+
+    struct Ratio
+    {
+        s32 src_;
+        s32 dst_;
+    };
+
+    static const Ratio Ratios[] =
+    {
+        {48000, 44100},
+        {44100, 48000},
+        {48000, 32000},
+        {32000, 48000},
+        {48000, 24000},
+        {24000, 48000},
+    };
+
+    /// Speex qualities compared with each quality of Polyphase
+    static const s32 SpeexQualities[lsound::Polyphase::Quality_Num] =
+    {
+        2,
+        SPEEX_RESAMPLER_QUALITY_DEFAULT,
+        8,
+    };
+
+    void printUsage()
+    {
+        printf("resample_bench [-seconds n] [-freq hz] [-level none|sse2|sse41|avx2|neon]\n");
+    }
+
+    f64 sine(f64 freq, u32 frame, u32 channel, s32 rate)
+    {
+        return 0.5*sin(2.0*PI*freq*frame/rate + channel);
+    }
+
+    /**
+    @brief Signal to noise ratio against the ideal sine, the delay of the resampler is searched
+    */
+    f64 measure(const f32* out, u32 numFrames, f64 freq, s32 rate)
+    {
+        f64 best = -1000.0;
+        for(u32 delay=0; delay<256; ++delay){
+            f64 signal = 0.0;
+            f64 noise = 0.0;
+            for(u32 i=EdgeFrames; (i+EdgeFrames)<numFrames; ++i){
+                for(u32 c=0; c<Channels; ++c){
+                    f64 ideal = sine(freq, i-delay, c, rate);
+                    f64 e = out[i*Channels+c] - ideal;
+                    signal += ideal*ideal;
+                    noise += e*e;
+                }
+            }
+            f64 snr = (noise<=0.0)? 200.0 : 10.0*log10(signal/noise);
+            best = (best<snr)? snr : best;
+        }
+        return best;
+    }
+
+    f64 runPolyphase(const f32* in, u32 inFrames, f32* out, u32& outFrames, const Ratio& ratio, lsound::Polyphase::Quality quality)
+    {
+        lsound::Polyphase polyphase;
+        if(!polyphase.create(Channels, ratio.src_, ratio.dst_, quality, BlockFrames)){
+            outFrames = 0;
+            return -1.0;
+        }
+        u32 capacity = outFrames;
+        outFrames = 0;
+        ClockType start = getPerformanceCounter();
+        for(u32 i=0; i<inFrames; i+=BlockFrames){
+            u32 inN = minimum(BlockFrames, inFrames-i);
+            u32 outN = capacity-outFrames;
+            polyphase.process(in + i*Channels, inN, out + outFrames*Channels, outN);
+            outFrames += outN;
+        }
+        return calcTime64(start, getPerformanceCounter());
+    }
+
+    f64 runSpeex(const f32* in, u32 inFrames, f32* out, u32& outFrames, const Ratio& ratio, s32 quality)
+    {
+        SpeexResamplerState* resampler = speex_resampler_init(Channels, ratio.src_, ratio.dst_, quality, NULL);
+        if(NULL == resampler){
+            outFrames = 0;
+            return -1.0;
+        }
+        speex_resampler_skip_zeros(resampler);
+        u32 capacity = outFrames;
+        outFrames = 0;
+        ClockType start = getPerformanceCounter();
+        for(u32 i=0; i<inFrames; i+=BlockFrames){
+            spx_uint32_t inN = minimum(BlockFrames, inFrames-i);
+            spx_uint32_t outN = capacity-outFrames;
+            speex_resampler_process_interleaved_float(resampler, in + i*Channels, &inN, out + outFrames*Channels, &outN);
+            outFrames += outN;
+        }
+        f64 time = calcTime64(start, getPerformanceCounter());
+        speex_resampler_destroy(resampler);
+        return time;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    s32 seconds = 10;
+    f64 freq = 1000.0;
+    lsound::SIMDLevel level = lsound::getSIMDLevel();
+    for(s32 i=1; i<argc; ++i){
+        if(0 == lcore::strncmp(argv[i], "-seconds", 8) && (i+1)<argc){
+            seconds = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-freq", 5) && (i+1)<argc){
+            freq = atof(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-level", 6) && (i+1)<argc){
+            const char* name = argv[++i];
+            if(0 == lcore::strncmp(name, "none", 4)){
+                level = lsound::SIMDLevel_None;
+            }else if(0 == lcore::strncmp(name, "sse2", 4)){
+                level = lsound::SIMDLevel_SSE2;
+            }else if(0 == lcore::strncmp(name, "sse41", 5)){
+                level = lsound::SIMDLevel_SSE41;
+            }else if(0 == lcore::strncmp(name, "avx2", 4)){
+                level = lsound::SIMDLevel_AVX2;
+            }else if(0 == lcore::strncmp(name, "neon", 4)){
+                level = lsound::SIMDLevel_NEON;
+            }
+        }else{
+            printUsage();
+            return 0;
+        }
+    }
+    seconds = lcore::maximum(seconds, 1);
+
+    lcore::System system;
+    {
+        printf("simd level %d\n", lsound::setSIMDLevel(level));
+        printf("ratio         engine       quality  x realtime  snr(dB)\n");
+
+        const u32 numRatios = sizeof(Ratios)/sizeof(Ratios[0]);
+        for(u32 r=0; r<numRatios; ++r){
+            const Ratio& ratio = Ratios[r];
+            u32 inFrames = seconds*ratio.src_;
+            u32 capacity = static_cast<u32>((static_cast<u64>(inFrames)*ratio.dst_)/ratio.src_) + BlockFrames*2;
+            f32* in = LIME_NEW f32[inFrames*Channels];
+            f32* out = LIME_NEW f32[capacity*Channels];
+            for(u32 i=0; i<inFrames; ++i){
+                for(u32 c=0; c<Channels; ++c){
+                    in[i*Channels+c] = static_cast<f32>(sine(freq, i, c, ratio.src_));
+                }
+            }
+
+            for(s32 q=0; q<lsound::Polyphase::Quality_Num; ++q){
+                u32 outFrames = capacity;
+                f64 time = runPolyphase(in, inFrames, out, outFrames, ratio, static_cast<lsound::Polyphase::Quality>(q));
+                if(0.0<=time){
+                    printf("%5d->%5d  polyphase    %d        %10.1f  %7.1f\n",
+                        ratio.src_, ratio.dst_, q, seconds/time, measure(out, outFrames, freq, ratio.dst_));
+                }
+
+                outFrames = capacity;
+                time = runSpeex(in, inFrames, out, outFrames, ratio, SpeexQualities[q]);
+                if(0.0<=time){
+                    printf("%5d->%5d  speex        %d        %10.1f  %7.1f\n",
+                        ratio.src_, ratio.dst_, SpeexQualities[q], seconds/time, measure(out, outFrames, freq, ratio.dst_));
+                }
+            }
+            LIME_DELETE_ARRAY(out);
+            LIME_DELETE_ARRAY(in);
+        }
+    }
+    return 0;
+}
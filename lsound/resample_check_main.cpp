@@ -0,0 +1,296 @@
+#include <lcore/lcore.h>
+#include <lcore/CLibrary.h>
+#include <lcore/async/Thread.h>
+#include <stdlib.h>
+#include <math.h>
+#include "lsound.h"
+#include "opus/Resource.h"
+#include "opus/Stream.h"
+#include "dsp/Resampler.h"
+
+/**
+@brief Race check of resamplers running on many threads at once, meant to be built with -fsanitize=thread.
+The opusfile entry points used by streams are defined here and generate a sine wave,
+so link this without libopusfile. Nothing is read from files.
+Returns non zero if outputs differ, the sanitizer exits with its own code if it reports.
+*/
+#if defined(LSOUND_API_OFFLINE)
+/// The spin lock of dlmalloc tests its word with a plain read before the atomic exchange
+extern "C" const char* __tsan_default_suppressions()
+{
+    return "race:spin_acquire_lock\n";
+}
+
+namespace
+{
+    static const lcore::f64 PI = 3.14159265358979323846;
+    static const lcore::f64 Frequency = 440.0;
+
+    /// Content of the memory handed to op_open_memory
+    struct SineHeader
+    {
+        lcore::s32 channels_;
+        lcore::s32 frames_;
+    };
+}
+
+/// A decoder of a synthetic source, at 48kHz as opus
+struct OggOpusFile
+{
+    lcore::s32 channels_;
+    lcore::s32 frames_;
+    lcore::s32 position_;
+};
+
+namespace
+{
+    inline lcore::f32 sine(lcore::s32 frame, lcore::s32 channel)
+    {
+        return static_cast<lcore::f32>(0.5*sin(2.0*PI*Frequency*frame/lsound::SampleRate_48000 + channel));
+    }
+}
+
+extern "C"
+{
+    OggOpusFile* op_open_memory(const unsigned char* _data, size_t _size, int* _error)
+    {
+        if(_size<sizeof(SineHeader)){
+            if(NULL != _error){
+                *_error = -1;
+            }
+            return NULL;
+        }
+        const SineHeader* header = reinterpret_cast<const SineHeader*>(_data);
+        OggOpusFile* of = LIME_NEW OggOpusFile;
+        of->channels_ = header->channels_;
+        of->frames_ = header->frames_;
+        of->position_ = 0;
+        return of;
+    }
+
+    OggOpusFile* op_open_callbacks(void*, const OpusFileCallbacks*, const unsigned char*, size_t, int* _error)
+    {
+        //Streams here never have file info
+        if(NULL != _error){
+            *_error = -1;
+        }
+        return NULL;
+    }
+
+    void op_free(OggOpusFile* _of)
+    {
+        LIME_DELETE(_of);
+    }
+
+    int op_channel_count(const OggOpusFile* _of, int)
+    {
+        return _of->channels_;
+    }
+
+    ogg_int64_t op_pcm_total(const OggOpusFile* _of, int)
+    {
+        return _of->frames_;
+    }
+
+    ogg_int64_t op_pcm_tell(const OggOpusFile* _of)
+    {
+        return _of->position_;
+    }
+
+    void op_set_dither_enabled(OggOpusFile*, int)
+    {
+    }
+
+    int op_read(OggOpusFile* _of, opus_int16* _pcm, int _buf_size, int*)
+    {
+        lcore::s32 frames = lcore::minimum(_buf_size/_of->channels_, _of->frames_-_of->position_);
+        for(lcore::s32 i=0; i<frames; ++i){
+            for(lcore::s32 c=0; c<_of->channels_; ++c){
+                _pcm[i*_of->channels_+c] = static_cast<opus_int16>(sine(_of->position_+i, c)*32767.0f);
+            }
+        }
+        _of->position_ += frames;
+        return frames;
+    }
+
+    int op_read_float(OggOpusFile* _of, float* _pcm, int _buf_size, int*)
+    {
+        lcore::s32 frames = lcore::minimum(_buf_size/_of->channels_, _of->frames_-_of->position_);
+        for(lcore::s32 i=0; i<frames; ++i){
+            for(lcore::s32 c=0; c<_of->channels_; ++c){
+                _pcm[i*_of->channels_+c] = sine(_of->position_+i, c);
+            }
+        }
+        _of->position_ += frames;
+        return frames;
+    }
+}
+
+namespace
+{
+    void printUsage()
+    {
+        printf("resample_check [-threads n] [-loops n] [-seconds n] [-rate n] [-mono] [-float]\n");
+    }
+
+    /**
+    @brief Resample the synthetic source with its own stream and resampler, only the memory is shared
+    */
+    class Job : public lcore::Thread
+    {
+    public:
+        Job()
+            :memory_(NULL)
+            ,size_(0)
+            ,loops_(1)
+            ,rate_(44100)
+            ,isFloat_(false)
+            ,frames_(0)
+            ,checksum_(0)
+            ,failed_(false)
+        {}
+
+        virtual ~Job()
+        {}
+
+        lsound::Memory* memory_;
+        lcore::u32 size_;
+        lcore::s32 loops_;
+        lcore::s32 rate_;
+        bool isFloat_;
+
+        lcore::u64 frames_;
+        lcore::u64 checksum_;
+        bool failed_;
+    protected:
+        virtual void run();
+
+    private:
+        static const lcore::u32 NumFrames = lsound::BufferNumSamplesPerChannel;
+    };
+
+    void Job::run()
+    {
+        lsound::MemoryStream stream;
+        lsound::Resampler resampler;
+        LIME_ALIGN16 lsound::LSshort pcm[NumFrames*2];
+        LIME_ALIGN16 lsound::LSfloat pcmFloat[NumFrames*2];
+
+        for(lcore::s32 i=0; i<loops_; ++i){
+            stream.set(size_, 0, memory_);
+            if(!stream.open()){
+                failed_ = true;
+                return;
+            }
+            lcore::u16 channels = (lsound::Format_Mono16 == stream.getFormat())? 1 : 2;
+            resampler.setSource(channels, (isFloat_)? 4 : 2, stream.getSampleRate());
+            resampler.setDest(2, (isFloat_)? 4 : 2, rate_);
+            //Every loop changes the scratch size, so allocating is checked too
+            resampler.setBlockFrames(lsound::Resampler::BlockFrames + i*64);
+            resampler.setQuality(static_cast<lsound::Polyphase::Quality>(i%lsound::Polyphase::Quality_Num));
+            if(!resampler.initialize()){
+                failed_ = true;
+                return;
+            }
+            resampler.reset();
+
+            for(;;){
+                lcore::s32 frames = (isFloat_)
+                    ? resampler.read(pcmFloat, NumFrames, &stream)
+                    : resampler.read(pcm, NumFrames, &stream);
+                if(frames<=0){
+                    failed_ = (frames<0);
+                    break;
+                }
+                frames_ += frames;
+                if(isFloat_){
+                    for(lcore::s32 j=0; j<frames*2; ++j){
+                        checksum_ = checksum_*31 + static_cast<lcore::u64>(lsound::toShort(pcmFloat[j]));
+                    }
+                }else{
+                    for(lcore::s32 j=0; j<frames*2; ++j){
+                        checksum_ = checksum_*31 + static_cast<lcore::u16>(pcm[j]);
+                    }
+                }
+            }
+            stream.close();
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    lcore::s32 threads = 4;
+    lcore::s32 loops = 3;
+    lcore::s32 seconds = 2;
+    lcore::s32 rate = 44100;
+    bool mono = false;
+    bool isFloat = false;
+    for(lcore::s32 i=1; i<argc; ++i){
+        if(0 == lcore::strncmp(argv[i], "-threads", 8) && (i+1)<argc){
+            threads = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-loops", 6) && (i+1)<argc){
+            loops = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-seconds", 8) && (i+1)<argc){
+            seconds = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-rate", 5) && (i+1)<argc){
+            rate = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-mono", 5)){
+            mono = true;
+        }else if(0 == lcore::strncmp(argv[i], "-float", 6)){
+            isFloat = true;
+        }else{
+            printUsage();
+            return 0;
+        }
+    }
+    threads = lcore::clamp(threads, 2, 32);
+    loops = lcore::maximum(loops, 1);
+    seconds = lcore::maximum(seconds, 1);
+
+    lcore::System system;
+    bool failed = false;
+    {
+        lcore::u8* bytes = LIME_NEW lcore::u8[sizeof(SineHeader)];
+        SineHeader* header = reinterpret_cast<SineHeader*>(bytes);
+        header->channels_ = (mono)? 1 : 2;
+        header->frames_ = seconds*lsound::SampleRate_48000;
+        lsound::Memory* memory = LIME_NEW lsound::Memory(sizeof(SineHeader), bytes);
+        memory->addRef();
+
+        //One job alone gives the expected output, then all jobs run at once
+        lcore::u64 checksum = 0;
+        for(lcore::s32 n=1; n<=threads; n+=threads-1){
+            Job* jobs = LIME_NEW Job[n];
+            for(lcore::s32 i=0; i<n; ++i){
+                jobs[i].memory_ = memory;
+                jobs[i].size_ = sizeof(SineHeader);
+                jobs[i].loops_ = loops;
+                jobs[i].rate_ = rate;
+                jobs[i].isFloat_ = isFloat;
+                jobs[i].create();
+            }
+            for(lcore::s32 i=0; i<n; ++i){
+                jobs[i].start();
+            }
+            for(lcore::s32 i=0; i<n; ++i){
+                jobs[i].join();
+            }
+
+            for(lcore::s32 i=0; i<n; ++i){
+                if(1 == n){
+                    checksum = jobs[i].checksum_;
+                }
+                if(jobs[i].failed_ || 0 == jobs[i].frames_ || checksum != jobs[i].checksum_){
+                    printf("job %d of %d threads: %s\n", i, n, (jobs[i].failed_)? "failed" : "mismatch");
+                    failed = true;
+                }
+            }
+            LIME_DELETE_ARRAY(jobs);
+        }
+        memory->release();
+        printf("%s\n", (failed)? "NG" : "OK");
+    }
+    return (failed)? 1 : 0;
+}
+#endif
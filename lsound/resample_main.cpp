@@ -0,0 +1,227 @@
+#include <lcore/lcore.h>
+#include <lcore/CLibrary.h>
+#include <lcore/async/Thread.h>
+#include <stdlib.h>
+#include "lsound.h"
+#include "opus/Resource.h"
+#include "opus/Stream.h"
+#include "dsp/Resampler.h"
+
+#if defined(LSOUND_API_OFFLINE)
+namespace
+{
+    void printUsage()
+    {
+        printf("resample pack [-id n] [-threads n] [-loops n] [-rate n] [-block n] [-quality 0-2] [-speex] [-float]\n");
+    }
+
+    /**
+    @brief Resample an entry with its own stream and resampler, nothing is shared between jobs
+    */
+    class Job : public lcore::Thread
+    {
+    public:
+        Job()
+            :pack_(NULL)
+            ,id_(0)
+            ,loops_(1)
+            ,rate_(44100)
+            ,blockFrames_(lsound::Resampler::BlockFrames)
+            ,quality_(lsound::Polyphase::Quality_Default)
+            ,speex_(false)
+            ,isFloat_(false)
+            ,frames_(0)
+            ,checksum_(0)
+            ,failed_(false)
+        {}
+
+        virtual ~Job()
+        {}
+
+        lsound::PackMemory* pack_;
+        lcore::s32 id_;
+        lcore::s32 loops_;
+        lcore::s32 rate_;
+        lcore::u32 blockFrames_;
+        lsound::Polyphase::Quality quality_;
+        bool speex_;
+        bool isFloat_;
+
+        lcore::u64 frames_;
+        lcore::u64 checksum_;
+        bool failed_;
+    protected:
+        virtual void run();
+
+    private:
+        static const lcore::u32 NumFrames = lsound::BufferNumSamplesPerChannel;
+    };
+
+    void Job::run()
+    {
+        lsound::Memory* memory = NULL;
+        lcore::u32 size = 0;
+        lcore::s32 offset = 0;
+        pack_->get(id_, memory, size, offset);
+
+        lsound::MemoryStream stream;
+        lsound::Resampler resampler;
+        LIME_ALIGN16 lsound::LSshort pcm[NumFrames*2];
+        LIME_ALIGN16 lsound::LSfloat pcmFloat[NumFrames*2];
+
+        for(lcore::s32 i=0; i<loops_; ++i){
+            stream.set(size, offset, memory);
+            if(!stream.open()){
+                failed_ = true;
+                return;
+            }
+            lcore::u16 channels = (lsound::Format_Mono16 == stream.getFormat())? 1 : 2;
+            resampler.setSource(channels, (isFloat_)? 4 : 2, stream.getSampleRate());
+            resampler.setDest(2, (isFloat_)? 4 : 2, rate_);
+            resampler.setBlockFrames(blockFrames_);
+            resampler.setQuality(quality_);
+            resampler.setUsePolyphase(!speex_);
+            if(!resampler.initialize()){
+                failed_ = true;
+                return;
+            }
+            resampler.reset();
+
+            for(;;){
+                lcore::s32 frames = (isFloat_)
+                    ? resampler.read(pcmFloat, NumFrames, &stream)
+                    : resampler.read(pcm, NumFrames, &stream);
+                if(frames<=0){
+                    failed_ = (frames<0);
+                    break;
+                }
+                frames_ += frames;
+                if(isFloat_){
+                    for(lcore::s32 j=0; j<frames*2; ++j){
+                        checksum_ = checksum_*31 + static_cast<lcore::u64>(lsound::toShort(pcmFloat[j]));
+                    }
+                }else{
+                    for(lcore::s32 j=0; j<frames*2; ++j){
+                        checksum_ = checksum_*31 + static_cast<lcore::u16>(pcm[j]);
+                    }
+                }
+            }
+            stream.close();
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc<2){
+        printUsage();
+        return 0;
+    }
+
+    const char* packPath = argv[1];
+    lcore::s32 id = 0;
+    lcore::s32 threads = 4;
+    lcore::s32 loops = 4;
+    lcore::s32 rate = 44100;
+    lcore::s32 blockFrames = lsound::Resampler::BlockFrames;
+    lcore::s32 quality = lsound::Polyphase::Quality_Default;
+    bool speex = false;
+    bool isFloat = false;
+    for(lcore::s32 i=2; i<argc; ++i){
+        if(0 == lcore::strncmp(argv[i], "-id", 3) && (i+1)<argc){
+            id = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-threads", 8) && (i+1)<argc){
+            threads = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-loops", 6) && (i+1)<argc){
+            loops = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-rate", 5) && (i+1)<argc){
+            rate = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-block", 6) && (i+1)<argc){
+            blockFrames = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-quality", 8) && (i+1)<argc){
+            quality = atoi(argv[++i]);
+        }else if(0 == lcore::strncmp(argv[i], "-speex", 6)){
+            speex = true;
+        }else if(0 == lcore::strncmp(argv[i], "-float", 6)){
+            isFloat = true;
+        }else{
+            printUsage();
+            return 0;
+        }
+    }
+    threads = lcore::clamp(threads, 1, 32);
+    blockFrames = lcore::maximum(blockFrames, 2);
+    quality = lcore::clamp(quality, 0, lsound::Polyphase::Quality_Num-1);
+
+    lcore::System system;
+    {
+        lsound::PackMemory* pack = lsound::PackMemory::open(packPath);
+        if(NULL == pack){
+            printf("fail to load %s\n", packPath);
+            return -1;
+        }
+        if(id<0 || pack->getNumFiles()<=id){
+            printf("no entry %d\n", id);
+            LIME_DELETE(pack);
+            return -1;
+        }
+
+        //The same work on 1 to threads threads, every job must give the same output
+        lcore::f64 baseTime = 0.0;
+        lcore::u64 checksum = 0;
+        for(lcore::s32 n=1; n<=threads; ++n){
+            Job* jobs = LIME_NEW Job[n];
+            for(lcore::s32 i=0; i<n; ++i){
+                jobs[i].pack_ = pack;
+                jobs[i].id_ = id;
+                jobs[i].loops_ = loops;
+                jobs[i].rate_ = rate;
+                jobs[i].blockFrames_ = blockFrames;
+                jobs[i].quality_ = static_cast<lsound::Polyphase::Quality>(quality);
+                jobs[i].speex_ = speex;
+                jobs[i].isFloat_ = isFloat;
+                jobs[i].create();
+            }
+
+            lcore::ClockType start = lcore::getPerformanceCounter();
+            for(lcore::s32 i=0; i<n; ++i){
+                jobs[i].start();
+            }
+            for(lcore::s32 i=0; i<n; ++i){
+                jobs[i].join();
+            }
+            lcore::f64 time = lcore::calcTime64(start, lcore::getPerformanceCounter());
+
+            lcore::u64 frames = 0;
+            bool mismatch = false;
+            for(lcore::s32 i=0; i<n; ++i){
+                if(jobs[i].failed_){
+                    printf("job %d failed\n", i);
+                    mismatch = true;
+                }
+                if(1 == n && 0 == i){
+                    checksum = jobs[i].checksum_;
+                }
+                if(checksum != jobs[i].checksum_){
+                    mismatch = true;
+                }
+                frames += jobs[i].frames_;
+            }
+            if(1 == n){
+                baseTime = time;
+            }
+            lcore::f64 audioTime = static_cast<lcore::f64>(frames)/rate;
+            printf("%d threads: %llu frames in %f sec (x%f realtime, efficiency %f)%s\n",
+                n,
+                static_cast<unsigned long long>(frames),
+                time,
+                audioTime/time,
+                baseTime/time,
+                (mismatch)? " mismatch" : "");
+            LIME_DELETE_ARRAY(jobs);
+        }
+        LIME_DELETE(pack);
+    }
+    return 0;
+}
+#endif
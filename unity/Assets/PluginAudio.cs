@@ -28,10 +28,10 @@ public class PluginAudio
     public static extern void audioPlay(int packId, int id, float volume);
 
     [DllImport("audio")]
-    public static extern IntPtr audioCreateUserPlayer(int packId, int id);
+    public static extern uint audioCreateUserPlayer(int packId, int id);
 
     [DllImport("audio")]
-    public static extern void audioDestroyUserPlayer(IntPtr player);
+    public static extern void audioDestroyUserPlayer(uint player);
 
     public static bool loadResourcePackFromAsset(int packId, string filename, bool stream)
     {
@@ -45,10 +45,10 @@ public class PluginAudio
 
 
     [DllImport("audio")]
-    public static extern void audioUserPlayerPlay(IntPtr player);
+    public static extern void audioUserPlayerPlay(uint player);
 
     [DllImport("audio")]
-    public static extern void audioUserPlayerPause(IntPtr player);
+    public static extern void audioUserPlayerPause(uint player);
 
 #else
 
@@ -86,12 +86,12 @@ public class PluginAudio
 
     }
 
-    public static IntPtr audioCreateUserPlayer(int packId, int id)
+    public static uint audioCreateUserPlayer(int packId, int id)
     {
-        return IntPtr.Zero;
+        return 0;
     }
 
-    public static void audioDestroyUserPlayer(IntPtr player)
+    public static void audioDestroyUserPlayer(uint player)
     {
 
     }
@@ -101,12 +101,12 @@ public class PluginAudio
         return false;
     }
 
-    public static void audioUserPlayerPlay(IntPtr player)
+    public static void audioUserPlayerPlay(uint player)
     {
 
     }
 
-    public static void audioUserPlayerPause(IntPtr player)
+    public static void audioUserPlayerPause(uint player)
     {
 
     }
@@ -56,6 +56,9 @@ LOCAL_SRC_FILES :=\
 	$(SRC)/lsound/opus/PackReader.cpp\
 	$(SRC)/lsound/opus/Resource.cpp\
 	$(SRC)/lsound/opus/Stream.cpp\
+	$(SRC)/lsound/BufferPool.cpp\
+	$(SRC)/lsound/VoiceTable.cpp\
+	$(SRC)/lsound/SlotPool.cpp\
 	$(SRC)/lsound/OpenSL/Context.cpp\
 	$(SRC)/lsound/OpenSL/Player.cpp\
 	$(SRC)/lsound/OpenSL/UserPlayer.cpp\
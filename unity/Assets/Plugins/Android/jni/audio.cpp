@@ -93,41 +93,54 @@ void audioPlay(int packId, int id, float volume)
     lsound::Context::getInstance().play(packId, id, volume);
 }
 
-void* audioCreateUserPlayer(int packId, int id)
+unsigned int audioCreateUserPlayer(int packId, int id)
 {
     lcore::Log("createUserPlayer");
     if(!lsound::Context::exists()){
-        return NULL;
+        return lsound::InvalidHandle;
+    }
+    lsound::Context& context = lsound::Context::getInstance();
+    lsound::Handle handle = context.createUserPlayer(packId, id);
+    lsound::UserPlayer* player = context.findUserPlayer(handle);
+    if(NULL == player){
+        return lsound::InvalidHandle;
     }
-    lsound::UserPlayer* player = lsound::Context::getInstance().createUserPlayer(packId, id);
     player->setFlag(lsound::PlayerFlag_Loop);
     //player->play();
-    return player;
+    return handle;
 }
 
-void audioDestroyUserPlayer(void* player)
+void audioDestroyUserPlayer(unsigned int handle)
 {
     lcore::Log("destroyUserPlayer");
     if(!lsound::Context::exists()){
         return;
     }
-    lsound::Context::getInstance().destroyUserPlayer(reinterpret_cast<lsound::UserPlayer*>(player));
+    lsound::Context::getInstance().destroyUserPlayer(handle);
 }
 
-void audioUserPlayerPlay(void* player)
+void audioUserPlayerPlay(unsigned int handle)
 {
+    if(!lsound::Context::exists()){
+        return;
+    }
+    lsound::UserPlayer* player = lsound::Context::getInstance().findUserPlayer(handle);
     if(NULL == player){
         return;
     }
-    reinterpret_cast<lsound::UserPlayer*>(player)->play();
+    player->play();
 }
 
-void audioUserPlayerPause(void* player)
+void audioUserPlayerPause(unsigned int handle)
 {
+    if(!lsound::Context::exists()){
+        return;
+    }
+    lsound::UserPlayer* player = lsound::Context::getInstance().findUserPlayer(handle);
     if(NULL == player){
         return;
     }
-    reinterpret_cast<lsound::UserPlayer*>(player)->pause();
+    player->pause();
 }
 
 #ifdef __cplusplus
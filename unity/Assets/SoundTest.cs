@@ -20,7 +20,7 @@ public class SoundTest : MonoBehaviour
     private AudioSource se1_;
     private AudioSource bgm1_;
 
-    private System.IntPtr bgm0_ = System.IntPtr.Zero;
+    private uint bgm0_ = 0; //handle of the user player, 0 if none
 
     float time_;
     int flag_;
@@ -63,7 +63,7 @@ public class SoundTest : MonoBehaviour
     void OnDestroy()
     {
         PluginAudio.audioDestroyUserPlayer(bgm0_);
-        bgm0_ = System.IntPtr.Zero;
+        bgm0_ = 0;
 
         PluginAudio.audioTerminate();
     }